@@ -1,7 +1,11 @@
 #include "SteelSightApp.hpp"
+#include "SteelSightBenchmark.hpp"
 
 int WinMain()
 {
+#ifdef STEELSIGHT_BENCHMARK
+    return Voortman::SteelSightBenchmark::run({ "Models/Voortman3D.obj" });
+#else
     Voortman::SteelSightApp app{};
 
     try {
@@ -13,4 +17,5 @@ int WinMain()
     }
 
     return EXIT_SUCCESS;
+#endif
 }
\ No newline at end of file
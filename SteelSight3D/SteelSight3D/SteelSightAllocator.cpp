@@ -0,0 +1,139 @@
+#define VMA_IMPLEMENTATION
+#include "SteelSightAllocator.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <string>
+
+namespace Voortman {
+	namespace {
+		const char* getUsageName(SteelSightAllocator::Usage usage) noexcept {
+			switch (usage) {
+			case SteelSightAllocator::Usage::Geometry: return "geometry";
+			case SteelSightAllocator::Usage::Staging: return "staging";
+			case SteelSightAllocator::Usage::Host: return "host";
+			case SteelSightAllocator::Usage::Image: return "image";
+			default: return "device";
+			}
+		}
+
+		inline uint64_t makePoolKey(SteelSightAllocator::Usage usage, uint32_t memoryTypeIndex) noexcept {
+			return static_cast<uint64_t>(usage) << 32 | memoryTypeIndex;
+		}
+	}
+
+	SteelSightAllocator::SteelSightAllocator(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t apiVersion) {
+		VmaAllocatorCreateInfo createInfo{};
+		createInfo.instance = instance;
+		createInfo.physicalDevice = physicalDevice;
+		createInfo.device = device;
+		createInfo.vulkanApiVersion = apiVersion;
+
+		if (vmaCreateAllocator(&createInfo, &allocator) != VK_SUCCESS) _UNLIKELY {
+			throw std::runtime_error("failed to create memory allocator!");
+		}
+	}
+
+	SteelSightAllocator::~SteelSightAllocator() {
+		for (const auto& [key, pool] : pools) vmaDestroyPool(allocator, pool);
+		vmaDestroyAllocator(allocator);
+	}
+
+	SteelSightAllocator::Usage SteelSightAllocator::classify(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) noexcept {
+		if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			return usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT ? Usage::Staging : Usage::Host;
+		}
+		if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) _LIKELY return Usage::Geometry;
+		return Usage::Device;
+	}
+
+	VmaPool SteelSightAllocator::getPool(Usage usage, uint32_t memoryTypeIndex) {
+		std::lock_guard lock{ poolMutex };
+
+		const uint64_t key = makePoolKey(usage, memoryTypeIndex);
+		if (const auto it = pools.find(key); it != pools.end()) _LIKELY return it->second;
+
+		// Blocks are created when the pool needs them, an unused pool holds no memory
+		VmaPoolCreateInfo poolInfo{};
+		poolInfo.memoryTypeIndex = memoryTypeIndex;
+		poolInfo.blockSize = BLOCK_SIZES[static_cast<size_t>(usage)];
+
+		VmaPool pool{ VK_NULL_HANDLE };
+		if (vmaCreatePool(allocator, &poolInfo, &pool) != VK_SUCCESS) _UNLIKELY {
+			throw std::runtime_error("failed to create memory pool!");
+		}
+
+		pools.emplace(key, pool);
+		return pool;
+	}
+
+	VmaAllocation SteelSightAllocator::allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, Usage usage) {
+		VmaAllocationCreateInfo allocationInfo{};
+
+		// A buffer that fills most of a block would waste the rest of it, so it gets its own memory like before
+		if (requirements.size > BLOCK_SIZES[static_cast<size_t>(usage)] / 2) _UNLIKELY {
+			allocationInfo.memoryTypeBits = 1u << memoryTypeIndex;
+			allocationInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+			largeAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+		else {
+			allocationInfo.pool = getPool(usage, memoryTypeIndex);
+		}
+
+		VmaAllocation allocation{ VK_NULL_HANDLE };
+		if (vmaAllocateMemory(allocator, &requirements, &allocationInfo, &allocation, nullptr) != VK_SUCCESS) _UNLIKELY {
+			throw std::runtime_error("failed to allocate " + std::string{ getUsageName(usage) } + " memory!");
+		}
+		return allocation;
+	}
+
+	void SteelSightAllocator::free(VmaAllocation allocation) noexcept {
+		if (allocation == VK_NULL_HANDLE) _UNLIKELY return;
+		vmaFreeMemory(allocator, allocation);
+	}
+
+	std::vector<SteelSightAllocator::PoolStatistics> SteelSightAllocator::getPoolStatistics() {
+		std::lock_guard lock{ poolMutex };
+
+		std::vector<PoolStatistics> statistics{};
+		statistics.reserve(pools.size());
+		for (const auto& [key, pool] : pools) {
+			VmaStatistics poolStatistics{};
+			vmaGetPoolStatistics(allocator, pool, &poolStatistics);
+
+			auto& entry = statistics.emplace_back();
+			entry.usage = static_cast<Usage>(key >> 32);
+			entry.memoryTypeIndex = static_cast<uint32_t>(key);
+			entry.blockCount = poolStatistics.blockCount;
+			entry.allocationCount = poolStatistics.allocationCount;
+			entry.blockBytes = poolStatistics.blockBytes;
+			entry.allocationBytes = poolStatistics.allocationBytes;
+		}
+
+		std::sort(statistics.begin(), statistics.end(), [](const PoolStatistics& a, const PoolStatistics& b) {
+			return a.usage != b.usage ? a.usage < b.usage : a.memoryTypeIndex < b.memoryTypeIndex;
+		});
+		return statistics;
+	}
+
+	uint32_t SteelSightAllocator::getDeviceMemoryCount() {
+		VmaTotalStatistics statistics{};
+		vmaCalculateStatistics(allocator, &statistics);
+		return statistics.total.statistics.blockCount;
+	}
+
+	void SteelSightAllocator::printStatistics() {
+		VmaTotalStatistics total{};
+		vmaCalculateStatistics(allocator, &total);
+
+		std::cout << "GPU memory: " << total.total.statistics.allocationCount << " allocations in " << total.total.statistics.blockCount << " device memory objects, "
+			<< total.total.statistics.allocationBytes / 1024 << " of " << total.total.statistics.blockBytes / 1024 << " KB used" << std::endl;
+
+		for (const auto& pool : getPoolStatistics()) {
+			const double used = pool.blockBytes > 0 ? 100.0 * pool.allocationBytes / pool.blockBytes : 0.0;
+			std::cout << "  " << getUsageName(pool.usage) << " pool (memory type " << pool.memoryTypeIndex << "): " << pool.allocationCount << " allocations in " << pool.blockCount
+				<< " blocks, " << pool.allocationBytes / 1024 << " of " << pool.blockBytes / 1024 << " KB used (" << used << "%)" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+#include <array>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "unordered_dense.h"
+
+namespace Voortman {
+	/// <summary>
+	/// Sub-allocates every buffer and image from large VkDeviceMemory blocks with the vendored Vulkan Memory Allocator, so thousands of models stay far below
+	/// maxMemoryAllocationCount. Allocations are grouped in one pool per usage and memory type, buffers that live and die together share their blocks and a
+	/// pool of short lived staging buffers does not fragment the blocks of the geometry. Allocations larger than half a block get their own memory.
+	/// Safe to use from the loader threads.
+	/// </summary>
+	class SteelSightAllocator final {
+	public:
+		enum class Usage : uint8_t {
+			// Device local vertex and index buffers
+			Geometry,
+			// Host visible sources of uploads
+			Staging,
+			// Other host visible buffers: uniform buffers, instance records
+			Host,
+			// Images, the depth attachments
+			Image,
+			// Device local buffers that are none of the above
+			Device,
+		};
+
+		static constexpr size_t USAGE_COUNT{ 5 };
+
+		// Size of the blocks of every pool, the staging and host visible pools hold small or short lived buffers
+		static constexpr std::array<VkDeviceSize, USAGE_COUNT> BLOCK_SIZES{ 64ull << 20, 16ull << 20, 4ull << 20, 64ull << 20, 16ull << 20 };
+
+		struct PoolStatistics final {
+			Usage usage{ Usage::Geometry };
+			uint32_t memoryTypeIndex{ 0 };
+			// VkDeviceMemory blocks of the pool and the buffers or images inside them
+			uint32_t blockCount{ 0 };
+			uint32_t allocationCount{ 0 };
+			VkDeviceSize blockBytes{ 0 };
+			VkDeviceSize allocationBytes{ 0 };
+		};
+
+		SteelSightAllocator(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t apiVersion);
+		~SteelSightAllocator();
+
+		SteelSightAllocator(const SteelSightAllocator&) = delete;
+		SteelSightAllocator& operator=(const SteelSightAllocator&) = delete;
+
+		// The pool a buffer belongs in
+		_NODISCARD static Usage classify(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) noexcept;
+
+		/// <summary>
+		/// Allocates memory for a buffer or image from the pool of its usage and memory type.
+		/// </summary>
+		/// <param name="requirements">Memory requirements of the buffer or image</param>
+		/// <param name="memoryTypeIndex">Memory type that fits the requirements and the wanted properties</param>
+		/// <param name="usage">Pool to allocate from</param>
+		/// <returns>The allocation to bind with vmaBindBufferMemory or vmaBindImageMemory</returns>
+		_NODISCARD VmaAllocation allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, Usage usage);
+		void free(VmaAllocation allocation) noexcept;
+
+		_NODISCARD inline VmaAllocator get() const noexcept { return allocator; }
+
+		// Statistics of every pool that was created, without the allocations that got their own memory
+		_NODISCARD std::vector<PoolStatistics> getPoolStatistics();
+
+		// VkDeviceMemory objects of the whole device, pools and own memory together
+		_NODISCARD uint32_t getDeviceMemoryCount();
+
+		// Allocations since the start that were too large for the blocks of their pool
+		_NODISCARD inline uint32_t getLargeAllocationCount() const noexcept { return largeAllocations.load(std::memory_order_relaxed); }
+
+		void printStatistics();
+
+	private:
+		VmaPool getPool(Usage usage, uint32_t memoryTypeIndex);
+
+		VmaAllocator allocator{ VK_NULL_HANDLE };
+
+		std::mutex poolMutex{};
+		// Key is the usage in the high and the memory type in the low 32 bits
+		ankerl::unordered_dense::map<uint64_t, VmaPool> pools{};
+
+		std::atomic<uint32_t> largeAllocations{ 0 };
+	};
+}
@@ -2,6 +2,7 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "SteelSightWindow.hpp"
 
@@ -20,7 +21,15 @@ namespace Voortman {
 		globalPool = SteelSightDescriptorPool::Builder(SSDevice)
 			.setMaxSets(SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.build();
+		materialTable = std::make_unique<SteelSightMaterialTable>(SSDevice);
+		modelLoader = std::make_unique<SteelSightModelLoader>(SSDevice);
+		modelRegistry = std::make_unique<SteelSightModelRegistry>(*modelLoader, *materialTable);
+
+		placeholderModel = SteelSightModel::createUnitBox(SSDevice);
+		placeholderModel->setMaterialBase(materialTable->add(placeholderModel->getMaterials()).value_or(SteelSightMaterialTable::FALLBACK_MATERIAL));
+
 		loadSimulationObjects();
 	}
 
@@ -46,18 +55,24 @@ namespace Voortman {
 
         auto globalSetLayout = SteelSightDescriptorSetLayout::Builder(SSDevice)
             .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
             .build();
 
         std::vector<VkDescriptorSet> globalDescriptorSets(SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < globalDescriptorSets.size(); i++) {
             auto bufferInfo = uboBuffers[i]->descriptorInfo();
+            auto materialInfo = materialTable->descriptorInfo(i);
             SteelSightDescriptorWriter(*globalSetLayout, *globalPool)
                 .writeBuffer(0, &bufferInfo)
+                .writeBuffer(1, &materialInfo)
                 .build(globalDescriptorSets[i]);
         }
 
         SteelSightRenderSystem RenderSystem{ SSDevice, VSMRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+        RenderSystem.setPlaceholderModel(placeholderModel);
         SteelSightPointLight PointLightSystem{ SSDevice, VSMRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+        SteelSightBeamSystem BeamSystem{ SSDevice, VSMRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+        loadBeams(BeamSystem);
 
         SteelSightCamera Camera{};
 
@@ -70,6 +85,8 @@ namespace Voortman {
 
         while (!SSWindow.ShouldClose()) _LIKELY {
             glfwPollEvents();
+            modelRegistry->update();
+            updateLoadingModels();
 
             auto newTime = std::chrono::high_resolution_clock::now();
 
@@ -104,12 +121,15 @@ namespace Voortman {
                 PointLightSystem.update(frameInfo, ubo);
                 uboBuffers[frameIndex]->writeToBuffer(&ubo);
                 uboBuffers[frameIndex]->flush();
+                // After the fence wait of the frame, the colors added or changed by the registry update reach the copy this frame reads
+                materialTable->flush(frameIndex);
                 // render
 
                 VSMRenderer.beginSwapChainRenderPass(commandBuffer);
 
                 // Order matters here because of transperancy
                 RenderSystem.renderSimulationObjects(frameInfo);
+                BeamSystem.render(frameInfo);
                 PointLightSystem.render(frameInfo);
 
                 VSMRenderer.endSwapChainRenderPass(commandBuffer);
@@ -117,18 +137,71 @@ namespace Voortman {
             }
         }
 
-        vkDeviceWaitIdle(SSDevice.device());
+        SSDevice.waitIdle();
 	}
 
+    std::shared_ptr<SteelSightModelHandle> SteelSightApp::loadModelAsync(const std::string& filepath, const SteelSightModel::LoadOptions& options) {
+        auto handle = modelRegistry->acquire(filepath, options);
+        loadingModels.push_back(handle);
+        return handle;
+    }
+
     /// <summary>
-    /// Function that loads all the objects that are simulated this is done with the rapidobj loader parsed with multiple threads
+    /// Hands the models that finished loading to their objects. The registry adds the materials of a model in its update, a model that finished after that waits a frame
+    /// </summary>
+    void SteelSightApp::updateLoadingModels() {
+        const bool loading = !loadingModels.empty();
+
+        for (auto it = loadingModels.begin(); it != loadingModels.end();) {
+            const auto handle = *it;
+            const auto state = handle->getState();
+            if (state == SteelSightModelHandle::State::Loading) _LIKELY {
+                ++it;
+                continue;
+            }
+
+            // A failed model leaves its objects without a model, they are simply not drawn
+            std::shared_ptr<SteelSightModel> model = handle->getModel();
+            if (model && !model->hasMaterialBase()) _UNLIKELY {
+                ++it;
+                continue;
+            }
+
+            for (auto& kv : SimulationObjects) {
+                auto& obj = kv.second;
+                if (obj.pendingModel != handle) continue;
+
+                obj.model = model;
+                obj.pendingModel.reset();
+            }
+
+            // The objects draw the model this frame, for a progressive model that is its base mesh
+            if (model) _LIKELY {
+                std::cout << handle->getPath() << " first drawn " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - handle->getRequestTime())
+                    << " after the request" << (model->isStreaming() ? " (base mesh, streaming the finer levels)" : "") << std::endl;
+            }
+
+            it = loadingModels.erase(it);
+        }
+
+        // Every model of the scene is uploaded, show how the buffers and the geometry were packed into device memory
+        if (loading && loadingModels.empty()) {
+            SSDevice.getAllocator().printStatistics();
+            SSDevice.getStagingRing().printStatistics();
+            SSDevice.getGeometryPool().printStatistics();
+            modelRegistry->printStatistics();
+        }
+    }
+
+    /// <summary>
+    /// Function that creates all the objects that are simulated, the models load in the background with the rapidobj loader parsed with multiple threads
     /// </summary>
     void SteelSightApp::loadSimulationObjects() {
-        std::shared_ptr<SteelSightModel> SimulationModel = SteelSightModel::createModelFromFile(SSDevice, "Models/quad.obj");
+        std::shared_ptr<SteelSightModelHandle> SimulationModel = loadModelAsync("Models/quad.obj", SteelSightModel::LoadOptions{});
 
         {
             auto floor = SteelSightSimulationObject::createSimulationObject();
-            floor.model = SimulationModel;
+            floor.pendingModel = SimulationModel;
             floor.transform.translation = glm::vec3(0.0f, 0.5f, 0.0f);
             floor.transform.scale = glm::vec3(4.f);
             SimulationObjects.emplace(floor.getId(), std::move(floor));
@@ -170,10 +243,16 @@ namespace Voortman {
 
 
         {
-            SimulationModel = SteelSightModel::createModelFromFile(SSDevice, "Models/Voortman3D.obj");
+            // The assembly is made of closed solids, so meshlets facing away from the camera are always hidden behind the front faces
+            SteelSightModel::LoadOptions options{};
+            options.meshletConeCulling = true;
+            options.vertexFormat = SteelSightModel::VertexFormat::Compact;
+            // The first run writes Voortman3D.obj.ssprog, later runs draw its base mesh while the finer levels stream in
+            options.progressive = true;
+            SimulationModel = loadModelAsync("Models/Voortman3D.obj", options);
 
             auto smoothvase = SteelSightSimulationObject::createSimulationObject();
-            smoothvase.model = SimulationModel;
+            smoothvase.pendingModel = SimulationModel;
             smoothvase.transform.translation = { 1.0f, -0.85f, -0.5f };
             smoothvase.transform.rotation = { 3.14f + 1.57f, 3.14f, 0.f };
             smoothvase.transform.scale = glm::vec3(0.001f);
@@ -181,4 +260,46 @@ namespace Voortman {
             SimulationObjects.emplace(smoothvase.getId(), std::move(smoothvase));
         }
     }
-}
\ No newline at end of file
+
+    /// <summary>
+    /// Stacks of IPE, HEA and UNP beams of different lengths next to the floor, every beam is a 32 byte instance of the template of its profile
+    /// </summary>
+    void SteelSightApp::loadBeams(SteelSightBeamSystem& beamSystem) {
+        constexpr uint32_t LAYERS{ 4 };
+        constexpr uint32_t BEAMS_PER_LAYER{ 6 };
+        constexpr float GAP{ 20.f };
+
+        const std::array<SteelSightDstv::Profile, 3> profiles{ {
+            { "I", 200.f, 100.f, 8.5f, 5.6f, 12.f },
+            { "I", 190.f, 200.f, 10.f, 6.5f, 18.f },
+            { "U", 200.f, 75.f, 11.5f, 8.5f, 11.5f },
+        } };
+
+        const std::array<glm::vec4, 1> steel{ glm::vec4{ 0.45f, 0.47f, 0.5f, 1.f } };
+        const uint32_t material = materialTable->add(steel).value_or(SteelSightMaterialTable::FALLBACK_MATERIAL);
+
+        float stackStart{ 0.f };
+        for (const auto& dimensions : profiles) {
+            const uint32_t profile = beamSystem.addProfile(dimensions);
+
+            for (uint32_t layer = 0; layer < LAYERS; ++layer) {
+                for (uint32_t i = 0; i < BEAMS_PER_LAYER; ++i) {
+                    const float length = 1200.f + 150.f * static_cast<float>((layer * BEAMS_PER_LAYER + i) % 5);
+                    const glm::vec3 position{ 0.f, layer * dimensions.height, stackStart + i * (dimensions.flangeWidth + GAP) };
+                    beamSystem.addBeam(profile, length, position, glm::quat{ 1.f, 0.f, 0.f, 0.f }, material);
+                }
+            }
+
+            stackStart += BEAMS_PER_LAYER * (dimensions.flangeWidth + GAP) + 200.f;
+        }
+
+        // The yard is in millimeters with y up, the world has y down with the floor at 0.5
+        glm::mat4 yardTransform = glm::translate(glm::mat4{ 1.f }, glm::vec3{ -2.f, 0.5f, 0.5f });
+        yardTransform = glm::rotate(yardTransform, glm::pi<float>(), glm::vec3{ 1.f, 0.f, 0.f });
+        yardTransform = glm::scale(yardTransform, glm::vec3{ 0.001f });
+        beamSystem.setTransform(yardTransform);
+
+        std::cout << "Beam yard: " << beamSystem.getBeamCount() << " beams of " << beamSystem.getProfileCount() << " profiles, "
+            << beamSystem.getTemplateMemorySize() / 1024 << " KB of templates and " << beamSystem.getBeamCount() * sizeof(SteelSightBeamSystem::BeamInstance) / 1024 << " KB of instances\n";
+    }
+}
@@ -27,6 +27,10 @@
 #include "SteelSightRenderSystem.hpp"
 #include "SteelSightCameraMovement.hpp"
 #include "SteelSightPointLight.hpp"
+#include "SteelSightBeamSystem.hpp"
+#include "SteelSightMaterialTable.hpp"
+#include "SteelSightModelLoader.hpp"
+#include "SteelSightModelRegistry.hpp"
 
 namespace Voortman {
 	class SteelSightApp final {
@@ -44,12 +48,24 @@ namespace Voortman {
 	private:
 		void loadSimulationObjects();
 
+		// Fills the beam system with a stock yard of standard profiles, drawn from one template per profile
+		void loadBeams(SteelSightBeamSystem& beamSystem);
+
+		// Requests a model from the registry, updateLoadingModels hands it to the objects that use it once it is ready
+		std::shared_ptr<SteelSightModelHandle> loadModelAsync(const std::string& filepath, const SteelSightModel::LoadOptions& options);
+		void updateLoadingModels();
+
 		SteelSightWindow SSWindow{ WIDTH, HEIGHT, "Voortman SteelSight3D" };
 		SteelSightDevice SSDevice{ SSWindow };
 		SteelSightRenderer VSMRenderer{ SSWindow, SSDevice };
 
 		// Order matters !
 		std::unique_ptr<SteelSightDescriptorPool> globalPool{};
+		std::unique_ptr<SteelSightMaterialTable> materialTable{};
+		std::unique_ptr<SteelSightModelLoader> modelLoader{};
+		std::unique_ptr<SteelSightModelRegistry> modelRegistry{};
+		std::shared_ptr<SteelSightModel> placeholderModel{};
+		std::vector<std::shared_ptr<SteelSightModelHandle>> loadingModels{};
 		SteelSightSimulationObject::map SimulationObjects;
 	};
 }
\ No newline at end of file
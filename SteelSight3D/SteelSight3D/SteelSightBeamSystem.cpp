@@ -0,0 +1,238 @@
+#include "SteelSightBeamSystem.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <cstddef>
+
+namespace Voortman {
+	// Same layout as the push constants of SteelSightRenderSystem, so beam.vert shares simple_shader.frag
+	struct BeamPushConstants {
+		glm::mat4 modelMatrix{ 1.f };
+		glm::mat3x4 normalMatrix{ 1.f };
+		uint32_t material{ 0 };
+		uint32_t padding[3]{};
+	};
+
+	static_assert(sizeof(BeamPushConstants) <= 128, "Push constants are limited to 128 bytes on most devices");
+
+	std::vector<VkVertexInputBindingDescription> SteelSightBeamSystem::BeamInstance::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+
+		bindingDescriptions[0].binding = 1;
+		bindingDescriptions[0].stride = sizeof(BeamInstance);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> SteelSightBeamSystem::BeamInstance::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		// Position and length in one attribute
+		attributeDescriptions.push_back({ 3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BeamInstance, position) });
+		attributeDescriptions.push_back({ 4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BeamInstance, rotation) });
+
+		return attributeDescriptions;
+	}
+
+	SteelSightBeamSystem::SteelSightBeamSystem(SteelSightDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : SSDevice{ device } {
+		createPipelineLayout(globalSetLayout);
+		createPipeline(renderPass);
+
+		instanceBuffers.resize(SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT);
+		instanceVersions.resize(SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT, 0);
+	}
+
+	SteelSightBeamSystem::~SteelSightBeamSystem() {
+		if (pipelineLayout) [[LIKELY]] {
+			vkDestroyPipelineLayout(SSDevice.device(), pipelineLayout, nullptr);
+		}
+	}
+
+	void SteelSightBeamSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(BeamPushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(SSDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) [[UNLIKELY]] {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+	}
+
+	void SteelSightBeamSystem::createPipeline(VkRenderPass renderPass) {
+		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+		PipelineConfigInfo pipelineConfig{};
+		SteelSightPipeline::defaultPipelineConfigInfo(pipelineConfig);
+
+		// The template mesh at binding 0, the instance records at binding 1
+		const auto instanceBindings = BeamInstance::getBindingDescriptions();
+		const auto instanceAttributes = BeamInstance::getAttributeDescriptions();
+		pipelineConfig.bindingDescriptions.insert(pipelineConfig.bindingDescriptions.end(), instanceBindings.begin(), instanceBindings.end());
+		pipelineConfig.attributeDescriptions.insert(pipelineConfig.attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+
+		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.pipelineLayout = pipelineLayout;
+		SSPipeline = std::make_unique<SteelSightPipeline>(
+			SSDevice,
+			"shaders\\beam.vert.spv",
+			"shaders\\simple_shader.frag.spv",
+			pipelineConfig);
+	}
+
+	uint32_t SteelSightBeamSystem::addProfile(const SteelSightDstv::Profile& dimensions) {
+		// A yard holds a handful of profiles, a linear search is enough
+		for (size_t i = 0; i < profiles.size(); ++i) {
+			if (profiles[i].dimensions == dimensions) return static_cast<uint32_t>(i);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		SteelSightDstv::Result mesh = SteelSightDstv::meshProfile(dimensions);
+
+		SteelSightModel::Builder builder{};
+		builder.vertices = std::move(mesh.vertices);
+		builder.indices = std::move(mesh.indices);
+
+		Profile& profile = profiles.emplace_back();
+		profile.dimensions = dimensions;
+		profile.model = std::make_unique<SteelSightModel>(SSDevice, builder);
+
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << "Beam profile " << dimensions.code << " " << dimensions.height << "x" << dimensions.flangeWidth << ": " << builder.indices.size() / 3 << " triangles, "
+			<< builder.vertices.size() << " vertices, " << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+
+		return static_cast<uint32_t>(profiles.size() - 1);
+	}
+
+	void SteelSightBeamSystem::addBeam(uint32_t profile, float length, const glm::vec3& position, const glm::quat& rotation, uint32_t material) {
+		if (profile >= profiles.size()) _UNLIKELY throw std::out_of_range("unknown beam profile");
+
+		Beam beam{};
+		beam.profile = profile;
+		beam.material = material;
+		beam.instance.position = position;
+		beam.instance.length = length;
+		beam.instance.rotation = { rotation.x, rotation.y, rotation.z, rotation.w };
+		beams.push_back(beam);
+		++version;
+	}
+
+	void SteelSightBeamSystem::clearBeams() {
+		beams.clear();
+		++version;
+	}
+
+	VkDeviceSize SteelSightBeamSystem::getTemplateMemorySize() const noexcept {
+		VkDeviceSize size{ 0 };
+		for (const auto& profile : profiles) size += profile.model->getGpuMemorySize();
+		return size;
+	}
+
+	void SteelSightBeamSystem::updateInstances(int frameIndex) {
+		if (instanceVersions[frameIndex] == version) _LIKELY return;
+
+		// The order only has to be computed once per change, every frame in flight copies the same records
+		if (batchVersion != version) {
+			std::stable_sort(beams.begin(), beams.end(), [](const Beam& a, const Beam& b) {
+				return a.profile != b.profile ? a.profile < b.profile : a.material < b.material;
+			});
+
+			batches.clear();
+			records.resize(beams.size());
+			for (size_t i = 0; i < beams.size(); ++i) {
+				const Beam& beam = beams[i];
+				records[i] = beam.instance;
+				if (batches.empty() || batches.back().profile != beam.profile || batches.back().material != beam.material) {
+					batches.push_back({ beam.profile, beam.material, static_cast<uint32_t>(i), 0 });
+				}
+				++batches.back().instanceCount;
+			}
+			batchVersion = version;
+		}
+
+		auto& buffer = instanceBuffers[frameIndex];
+		if (!beams.empty() && (buffer == nullptr || buffer->getInstanceCount() < beams.size())) {
+			// Grow with some margin so adding a few beams does not recreate the buffer every time
+			const uint32_t capacity = static_cast<uint32_t>(beams.size() + beams.size() / 2);
+			buffer = std::make_unique<SteelSightBuffer>(
+				SSDevice,
+				sizeof(BeamInstance),
+				capacity,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			buffer->map();
+		}
+
+		if (!records.empty()) buffer->writeToBuffer(records.data(), records.size() * sizeof(BeamInstance));
+
+		instanceVersions[frameIndex] = version;
+	}
+
+	void SteelSightBeamSystem::render(FrameInfo& frameInfo) {
+		if (beams.empty()) return;
+
+		// The fence of this frame was waited on in beginFrame, so its instance buffer is no longer read by the GPU
+		updateInstances(frameInfo.frameIndex);
+
+		SSPipeline->bind(frameInfo.commandBuffer);
+
+		vkCmdBindDescriptorSets(
+			frameInfo.commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			0,
+			1,
+			&frameInfo.globalDescriptorSet,
+			0,
+			nullptr);
+
+		BeamPushConstants push{};
+		push.modelMatrix = transform;
+		push.normalMatrix = glm::mat3x4{ glm::inverseTranspose(glm::mat3{ transform }) };
+
+		vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(BeamPushConstants), &push);
+
+		VkBuffer instanceBuffer = instanceBuffers[frameInfo.frameIndex]->getBuffer();
+		VkDeviceSize instanceOffset{ 0 };
+		vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, &instanceBuffer, &instanceOffset);
+
+		// The profiles lie in the geometry pool, they share the bind unless one of them got a page of its own
+		SteelSightGeometryBinding boundGeometry{};
+		for (const Batch& batch : batches) {
+			SteelSightModel& model = *profiles[batch.profile].model;
+
+			// A profile is drawn once its upload is complete, on a dedicated transfer queue that is a frame or two after it was added
+			if (!model.isUploaded()) _UNLIKELY continue;
+			model.bind(frameInfo.commandBuffer, boundGeometry);
+
+			vkCmdPushConstants(
+				frameInfo.commandBuffer,
+				pipelineLayout,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				offsetof(BeamPushConstants, material),
+				sizeof(uint32_t),
+				&batch.material);
+
+			const SteelSightModel::Lod& lod = model.getLods().front();
+			vkCmdDrawIndexed(frameInfo.commandBuffer, lod.indexCount, batch.instanceCount, model.getIndexOffset() + lod.firstIndex, model.getVertexOffset(), batch.firstInstance);
+		}
+	}
+}
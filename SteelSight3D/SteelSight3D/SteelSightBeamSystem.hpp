@@ -0,0 +1,120 @@
+#pragma once
+#include <vector>
+#include <memory>
+
+#include "SteelSightModel.hpp"
+#include "SteelSightPipeline.hpp"
+#include "SteelSightDevice.hpp"
+#include "SteelSightBuffer.hpp"
+#include "SteelSightSwapChain.hpp"
+#include "SteelSightFrameInfo.hpp"
+#include "SteelSightDstv.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+
+namespace Voortman {
+	/// <summary>
+	/// Draws straight beams without meshing them one by one. Every distinct profile is meshed once as a beam of length 1 (SteelSightDstv::meshProfile)
+	/// and every beam is a 32 byte instance record with its position, length and rotation. The vertex shader (beam.vert) stretches the profile to the length
+	/// of the instance, so a yard of thousands of beams costs one template per profile and one instanced draw per profile and material.
+	/// Holes and end cuts are not drawn, beams that need them are loaded from their NC1 file instead.
+	/// </summary>
+	class SteelSightBeamSystem final {
+	public:
+		// Per instance vertex data at binding 1, read at locations 3 and 4 of beam.vert
+		struct BeamInstance final {
+			// Start of the beam in yard space, the beam runs along its local +x
+			glm::vec3 position{ 0.f };
+			// Length of the beam in millimeters
+			float length{ 0.f };
+			// Rotation of the beam as x, y, z, w
+			glm::vec4 rotation{ 0.f, 0.f, 0.f, 1.f };
+
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		};
+
+		static_assert(sizeof(BeamInstance) == 32, "The instance record is read as two vec4 attributes");
+
+		SteelSightBeamSystem(SteelSightDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+		~SteelSightBeamSystem();
+
+		SteelSightBeamSystem(const SteelSightBeamSystem&) = delete;
+		SteelSightBeamSystem& operator=(const SteelSightBeamSystem&) = delete;
+
+		/// <summary>
+		/// Meshes and uploads the template of a profile, a profile that was added before returns its existing id.
+		/// </summary>
+		/// <param name="profile">Dimensions of the profile</param>
+		/// <returns>Id of the profile to pass to addBeam</returns>
+		uint32_t addProfile(const SteelSightDstv::Profile& profile);
+
+		/// <summary>
+		/// Adds a beam. The instance buffers are rewritten once before the next frame that draws them.
+		/// </summary>
+		/// <param name="profile">Id returned by addProfile</param>
+		/// <param name="length">Length of the beam in millimeters</param>
+		/// <param name="position">Start of the beam in yard space</param>
+		/// <param name="rotation">Rotation of the beam in yard space</param>
+		/// <param name="material">Index into the material table</param>
+		void addBeam(uint32_t profile, float length, const glm::vec3& position, const glm::quat& rotation, uint32_t material);
+
+		void clearBeams();
+
+		// Yard to world transform of every beam, the yard is in millimeters like the models
+		inline void setTransform(const glm::mat4& yardTransform) noexcept { transform = yardTransform; }
+
+		void render(FrameInfo& frameInfo);
+
+		_NODISCARD inline size_t getBeamCount() const noexcept { return beams.size(); }
+		_NODISCARD inline size_t getProfileCount() const noexcept { return profiles.size(); }
+
+		// Bytes of device memory held by the profile templates
+		_NODISCARD VkDeviceSize getTemplateMemorySize() const noexcept;
+
+	private:
+		struct Beam final {
+			uint32_t profile{ 0 };
+			uint32_t material{ 0 };
+			BeamInstance instance{};
+		};
+
+		// Consecutive instances with the same profile and material, drawn with one call
+		struct Batch final {
+			uint32_t profile{ 0 };
+			uint32_t material{ 0 };
+			uint32_t firstInstance{ 0 };
+			uint32_t instanceCount{ 0 };
+		};
+
+		struct Profile final {
+			SteelSightDstv::Profile dimensions{};
+			std::unique_ptr<SteelSightModel> model{};
+		};
+
+		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+		void createPipeline(VkRenderPass renderPass);
+
+		// Sorts the beams into batches and writes them to the instance buffer of the frame when the beams changed since it was written
+		void updateInstances(int frameIndex);
+
+		SteelSightDevice& SSDevice;
+		std::unique_ptr<SteelSightPipeline> SSPipeline;
+		VkPipelineLayout pipelineLayout;
+
+		std::vector<Profile> profiles{};
+		std::vector<Beam> beams{};
+		std::vector<Batch> batches{};
+		// The instances of the beams in batch order, copied to the instance buffer of every frame
+		std::vector<BeamInstance> records{};
+		glm::mat4 transform{ 1.f };
+
+		// Bumped by every change of the beams, a frame whose buffer has an older version rewrites it
+		uint64_t version{ 1 };
+		uint64_t batchVersion{ 0 };
+
+		// One buffer per frame in flight, a frame only rewrites its own buffer after its previous submission finished
+		std::vector<std::unique_ptr<SteelSightBuffer>> instanceBuffers{};
+		std::vector<uint64_t> instanceVersions{};
+	};
+}
@@ -0,0 +1,283 @@
+#include "SteelSightBenchmark.hpp"
+#include "SteelSightModel.hpp"
+#include "SteelSightGltf.hpp"
+#include "SteelSightUtils.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+
+namespace Voortman {
+	namespace {
+		using Builder = SteelSightModel::Builder;
+
+		// How far the peak of the process rose above its resident memory at the start of the load until the weld finished, 0 when it stayed below an earlier peak.
+		// The benchmark loads one model at a time, so the growth belongs to that load
+		size_t getParsePeakGrowth(const Builder& builder) noexcept {
+			const auto& statistics = builder.statistics;
+			if (statistics.processPeakAfterWeld <= statistics.processPeakBefore) return 0;
+			return statistics.processPeakAfterWeld - std::min(statistics.processPeakAfterWeld, statistics.processResidentBefore);
+		}
+
+		bool sameMesh(const Builder& a, const Builder& b) {
+			const auto verticesA = a.getVertices();
+			const auto verticesB = b.getVertices();
+			const auto indicesA = a.getIndices();
+			const auto indicesB = b.getIndices();
+
+			return std::equal(verticesA.begin(), verticesA.end(), verticesB.begin(), verticesB.end()) &&
+				std::equal(indicesA.begin(), indicesA.end(), indicesB.begin(), indicesB.end());
+		}
+
+		Builder loadUncached(const std::string& modelPath, uint32_t weldThreads, SteelSightModel::WeldMode weldMode = SteelSightModel::WeldMode::IndexTuple) {
+			Builder builder{};
+			builder.options.useCache = false;
+			builder.options.weldThreads = weldThreads;
+			builder.options.weldMode = weldMode;
+			builder.loadModel(modelPath);
+			return builder;
+		}
+	}
+
+	int SteelSightBenchmark::run(const std::vector<std::string>& modelPaths) {
+		bool succes{ true };
+
+		std::vector<std::string> models = modelPaths;
+
+		// Synthetic models of roughly 1.5 and 6 million face corners
+		const std::filesystem::path directory = std::filesystem::temp_directory_path();
+		for (uint32_t gridSize : { 500u, 1000u }) {
+			const std::string syntheticPath = (directory / ("steelsight_grid_" + std::to_string(gridSize) + ".obj")).string();
+			writeSyntheticModel(syntheticPath, gridSize);
+			models.push_back(syntheticPath);
+		}
+
+		for (const auto& modelPath : models) {
+			succes &= benchmarkWeldThreads(modelPath);
+			succes &= benchmarkWeldModes(modelPath);
+			succes &= benchmarkStreaming(modelPath);
+			succes &= benchmarkGltf(modelPath);
+		}
+
+		return succes ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	bool SteelSightBenchmark::benchmarkWeldThreads(const std::string& modelPath) {
+		const uint32_t maxThreads = resolveWorkerCount(0);
+
+		const Builder serial = loadUncached(modelPath, 1);
+		const double corners = static_cast<double>(serial.getIndices().size());
+
+		std::vector<std::pair<uint32_t, Builder>> results{};
+		for (uint32_t threads = 2; threads < maxThreads; threads *= 2) {
+			results.emplace_back(threads, loadUncached(modelPath, threads));
+		}
+		if (maxThreads > 1) results.emplace_back(maxThreads, loadUncached(modelPath, maxThreads));
+
+		bool identical{ true };
+
+		std::cout << "Weld benchmark: " << modelPath << " (" << serial.getIndices().size() << " corners)" << std::endl;
+		std::cout << std::setw(10) << "threads" << std::setw(14) << "weld ms" << std::setw(16) << "ms / M corners" << std::setw(10) << "speedup" << std::setw(12) << "identical" << std::endl;
+
+		auto printRow = [&](uint32_t threads, const Builder& builder) {
+			const double weldMs = builder.statistics.weldTime.count() / 1000.0;
+			const double serialMs = serial.statistics.weldTime.count() / 1000.0;
+			const bool same = sameMesh(serial, builder);
+			identical &= same;
+
+			std::ostringstream row{};
+			row << std::setw(10) << threads
+				<< std::setw(14) << std::fixed << std::setprecision(2) << weldMs
+				<< std::setw(16) << weldMs / std::max(corners / 1e6, 1e-6)
+				<< std::setw(9) << serialMs / std::max(weldMs, 1e-3) << "x"
+				<< std::setw(12) << (same ? "yes" : "NO");
+			std::cout << row.str() << std::endl;
+		};
+
+		printRow(1, serial);
+		for (const auto& [threads, builder] : results) printRow(threads, builder);
+		std::cout << std::endl;
+
+		return identical;
+	}
+
+	bool SteelSightBenchmark::benchmarkWeldModes(const std::string& modelPath) {
+		using WeldMode = SteelSightModel::WeldMode;
+
+		const uint32_t maxThreads = resolveWorkerCount(0);
+
+		const Builder reference = loadUncached(modelPath, 1, WeldMode::Vertex);
+		const double referenceMs = reference.statistics.weldTime.count() / 1000.0;
+		const double corners = static_cast<double>(reference.getIndices().size());
+
+		bool identical{ true };
+
+		std::cout << "Weld mode benchmark: " << modelPath << " (" << reference.getIndices().size() << " corners)" << std::endl;
+		std::cout << std::setw(14) << "mode" << std::setw(10) << "threads" << std::setw(14) << "weld ms" << std::setw(16) << "ms / M corners" << std::setw(10) << "speedup" << std::setw(12) << "identical" << std::endl;
+
+		for (uint32_t threads : { 1u, maxThreads }) {
+			for (WeldMode mode : { WeldMode::Vertex, WeldMode::IndexTuple }) {
+				if (threads == maxThreads && maxThreads == 1 && mode == WeldMode::Vertex) continue;
+
+				const Builder builder = threads == 1 && mode == WeldMode::Vertex ? loadUncached(modelPath, 1, WeldMode::Vertex) : loadUncached(modelPath, threads, mode);
+				const double weldMs = builder.statistics.weldTime.count() / 1000.0;
+				const bool same = sameMesh(reference, builder);
+				identical &= same;
+
+				std::ostringstream row{};
+				row << std::setw(14) << (mode == WeldMode::Vertex ? "vertex" : "index tuple")
+					<< std::setw(10) << threads
+					<< std::setw(14) << std::fixed << std::setprecision(2) << weldMs
+					<< std::setw(16) << weldMs / std::max(corners / 1e6, 1e-6)
+					<< std::setw(9) << referenceMs / std::max(weldMs, 1e-3) << "x"
+					<< std::setw(12) << (same ? "yes" : "NO");
+				std::cout << row.str() << std::endl;
+			}
+			if (maxThreads == 1) break;
+		}
+		std::cout << std::endl;
+
+		return identical;
+	}
+
+	bool SteelSightBenchmark::benchmarkStreaming(const std::string& modelPath) {
+		// Instances would only exist in the rapidobj load, the streaming parser keeps no shapes.
+		// The peak of the process never drops, the later stages are skipped so the parse and the weld set the peak of each load
+		auto load = [&modelPath](bool streamingParse) {
+			Builder builder{};
+			builder.options.useCache = false;
+			builder.options.detectInstances = false;
+			builder.options.optimizeMesh = false;
+			builder.options.buildMeshlets = false;
+			builder.options.buildLods = false;
+			builder.options.streamingParse = streamingParse;
+			builder.loadModel(modelPath);
+			return builder;
+		};
+
+		const Builder streamed = load(true);
+		const Builder parsed = load(false);
+		const bool same = sameMesh(parsed, streamed);
+
+		constexpr double MB{ 1024.0 * 1024.0 };
+
+		std::cout << "Streaming parse benchmark: " << modelPath << " (" << parsed.getIndices().size() << " corners)" << std::endl;
+		std::cout << std::setw(14) << "parser" << std::setw(14) << "parse ms" << std::setw(14) << "weld ms" << std::setw(18) << "peak growth MB" << std::endl;
+
+		auto printRow = [MB](const char* parser, const Builder& builder) {
+			std::ostringstream row{};
+			row << std::setw(14) << parser
+				<< std::setw(14) << std::fixed << std::setprecision(2) << builder.statistics.parseTime.count() / 1000.0
+				<< std::setw(14) << builder.statistics.weldTime.count() / 1000.0
+				<< std::setw(18) << getParsePeakGrowth(builder) / MB;
+			std::cout << row.str() << std::endl;
+		};
+
+		printRow("rapidobj", parsed);
+		printRow("streaming", streamed);
+
+		// A rapidobj load that stayed below the peak of the streaming load needed at most as much memory
+		const size_t parsedPeak = getParsePeakGrowth(parsed);
+		const size_t streamedPeak = getParsePeakGrowth(streamed);
+		std::ostringstream reduction{};
+		reduction << std::fixed << std::setprecision(2) << (parsedPeak - std::min(parsedPeak, streamedPeak)) / MB;
+		std::cout << "Peak reduction: " << reduction.str() << " MB"
+			<< (parsedPeak == 0 ? " (rapidobj stayed below the streaming peak)" : "") << ", identical: " << (same ? "yes" : "NO") << std::endl << std::endl;
+
+		return same;
+	}
+
+	bool SteelSightBenchmark::benchmarkGltf(const std::string& modelPath) {
+		auto load = [](const std::string& path) {
+			Builder builder{};
+			builder.options.useCache = false;
+			builder.options.optimizeMesh = false;
+			builder.options.buildMeshlets = false;
+			builder.options.buildLods = false;
+			builder.loadModel(path);
+			return builder;
+		};
+
+		const Builder obj = load(modelPath);
+
+		const std::filesystem::path gltfPath = std::filesystem::temp_directory_path() / (std::filesystem::path{ modelPath }.stem().string() + ".glb");
+		SteelSightGltf::write(gltfPath.string(), obj);
+		const Builder gltf = load(gltfPath.string());
+
+		const bool same = sameMesh(obj, gltf) && obj.getParts().size() == gltf.getParts().size() && obj.getInstances().size() == gltf.getInstances().size()
+			&& std::equal(obj.getMaterials().begin(), obj.getMaterials().end(), gltf.getMaterials().begin(), gltf.getMaterials().end());
+
+		const double objMs = obj.statistics.totalTime.count() / 1000.0;
+
+		std::cout << "glTF benchmark: " << modelPath << " (" << obj.getIndices().size() << " corners)" << std::endl;
+		std::cout << std::setw(10) << "format" << std::setw(12) << "file MB" << std::setw(12) << "parse ms" << std::setw(12) << "weld ms" << std::setw(12) << "total ms" << std::setw(10) << "speedup" << std::endl;
+
+		auto printRow = [objMs](const char* format, const std::filesystem::path& path, const Builder& builder) {
+			const double totalMs = builder.statistics.totalTime.count() / 1000.0;
+			std::ostringstream row{};
+			row << std::setw(10) << format
+				<< std::setw(12) << std::fixed << std::setprecision(2) << std::filesystem::file_size(path) / (1024.0 * 1024.0)
+				<< std::setw(12) << builder.statistics.parseTime.count() / 1000.0
+				<< std::setw(12) << builder.statistics.weldTime.count() / 1000.0
+				<< std::setw(12) << totalMs
+				<< std::setw(9) << objMs / std::max(totalMs, 1e-3) << "x";
+			std::cout << row.str() << std::endl;
+		};
+
+		printRow("obj", modelPath, obj);
+		printRow("glb", gltfPath, gltf);
+		std::cout << "identical: " << (same ? "yes" : "NO") << std::endl << std::endl;
+
+		return same;
+	}
+
+	void SteelSightBenchmark::writeSyntheticModel(const std::string& modelPath, uint32_t gridSize) {
+		const std::filesystem::path path{ modelPath };
+		const std::string materialName = path.stem().string() + ".mtl";
+
+		{
+			std::ofstream material{ path.parent_path() / materialName };
+			material << "newmtl steel\nKd 0.6 0.6 0.65\nnewmtl paint\nKd 0.8 0.3 0.1\n";
+		}
+
+		std::ofstream file{ path };
+		if (!file.is_open()) _UNLIKELY throw std::runtime_error("failed to write synthetic model: " + modelPath);
+
+		file << "mtllib " << materialName << "\n";
+
+		// A slightly wavy plate so the positions and normals are not all the same
+		const uint32_t side = gridSize + 1;
+		for (uint32_t y = 0; y < side; ++y) {
+			for (uint32_t x = 0; x < side; ++x) {
+				file << "v " << x * 0.01f << ' ' << 0.05f * std::sin(x * 0.1f) * std::cos(y * 0.1f) << ' ' << y * 0.01f << "\n";
+			}
+		}
+		for (uint32_t y = 0; y < side; ++y) {
+			for (uint32_t x = 0; x < side; ++x) {
+				file << "vt " << static_cast<float>(x) / gridSize << ' ' << static_cast<float>(y) / gridSize << "\n";
+			}
+		}
+		file << "vn 0 1 0\nvn 0 0.995 0.0998\n";
+
+		for (uint32_t part = 0; part < 2; ++part) {
+			file << "o plate" << part << "\nusemtl " << (part == 0 ? "steel" : "paint") << "\n";
+
+			for (uint32_t y = part * gridSize / 2; y < (part + 1) * gridSize / 2; ++y) {
+				for (uint32_t x = 0; x < gridSize; ++x) {
+					const uint32_t a = y * side + x + 1;
+					const uint32_t b = a + 1;
+					const uint32_t c = a + side;
+					const uint32_t d = c + 1;
+					const uint32_t n = 1 + (x / 8) % 2;
+					file << "f " << a << '/' << a << '/' << n << ' ' << b << '/' << b << '/' << n << ' ' << d << '/' << d << '/' << n << ' ' << c << '/' << c << '/' << n << "\n";
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
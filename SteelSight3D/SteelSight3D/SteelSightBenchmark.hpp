@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Define to run the model loading benchmarks from WinMain instead of starting the renderer
+// #define STEELSIGHT_BENCHMARK
+
+namespace Voortman {
+	/// <summary>
+	/// Console benchmarks for the model loading pipeline, the results are printed to std::cout.
+	/// </summary>
+	class SteelSightBenchmark final {
+	public:
+		/// <summary>
+		/// Runs every benchmark on every model.
+		/// </summary>
+		/// <param name="modelPaths">The models to benchmark</param>
+		/// <returns>EXIT_SUCCESS when every benchmark produced the expected output</returns>
+		static int run(const std::vector<std::string>& modelPaths);
+
+		/// <summary>
+		/// Welds the model with 1, 2, 4 ... hardware threads and checks that every thread count produces the same mesh as the serial weld.
+		/// </summary>
+		/// <param name="modelPath">The model to load</param>
+		/// <returns>True when every thread count produced the same mesh</returns>
+		static bool benchmarkWeldThreads(const std::string& modelPath);
+
+		/// <summary>
+		/// Compares the weld on full vertices with the weld on OBJ index tuples, single threaded and with every hardware thread.
+		/// </summary>
+		/// <param name="modelPath">The model to load</param>
+		/// <returns>True when both weld modes produced the same mesh</returns>
+		static bool benchmarkWeldModes(const std::string& modelPath);
+
+		/// <summary>
+		/// Compares the peak memory and load time of the rapidobj parse followed by the weld with the streaming parse that welds while it reads.
+		/// The streaming load runs first, the peak of the process only rises again when the rapidobj load needs more.
+		/// </summary>
+		/// <param name="modelPath">The model to load</param>
+		/// <returns>True when both parsers produced the same mesh</returns>
+		static bool benchmarkStreaming(const std::string& modelPath);
+
+		/// <summary>
+		/// Writes the model as binary glTF and compares the load of both files, the later stages are skipped because they take the same time for both.
+		/// </summary>
+		/// <param name="modelPath">The OBJ to convert and load</param>
+		/// <returns>True when both files produced the same mesh, parts and instances</returns>
+		static bool benchmarkGltf(const std::string& modelPath);
+
+		/// <summary>
+		/// Writes a synthetic OBJ: a grid of quads with shared positions, normals and texture coordinates, split over two materials.
+		/// </summary>
+		/// <param name="modelPath">Path of the OBJ to write, the material library is written next to it</param>
+		/// <param name="gridSize">Number of quads along each side, the model has 6 * gridSize^2 face corners after triangulation</param>
+		static void writeSyntheticModel(const std::string& modelPath, uint32_t gridSize);
+	};
+}
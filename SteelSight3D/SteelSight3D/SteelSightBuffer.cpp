@@ -43,27 +43,32 @@ namespace Voortman {
         memoryPropertyFlags{ memoryPropertyFlags } {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
     SteelSightBuffer::~SteelSightBuffer() {
         unmap();
-        vkDestroyBuffer(SSDevice.device(), buffer, nullptr);
-        vkFreeMemory(SSDevice.device(), memory, nullptr);
+        SSDevice.destroyBuffer(buffer, allocation);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
-     * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
-     * buffer range.
+     * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the buffer
+     * from offset to its end. The whole block stays mapped, the range is only checked against the buffer size.
      * @param offset (Optional) Byte offset from beginning
      *
      * @return VkResult of the buffer mapping call
      */
     VkResult SteelSightBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(SSDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation && "Called map on buffer before create");
+        assert(offset <= bufferSize && (size == VK_WHOLE_SIZE || size <= bufferSize - offset) && "Mapped range outside of the buffer");
+
+        // The allocation shares its block with other buffers, vmaMapMemory maps the block once and returns the start of this allocation
+        void* start = nullptr;
+        const VkResult result = vmaMapMemory(SSDevice.getAllocator().get(), allocation, &start);
+        if (result == VK_SUCCESS) mapped = static_cast<char*>(start) + offset;
+        return result;
     }
 
     /**
@@ -73,7 +78,7 @@ namespace Voortman {
      */
     void SteelSightBuffer::unmap() {
         if (mapped) {
-            vkUnmapMemory(SSDevice.device(), memory);
+            vmaUnmapMemory(SSDevice.getAllocator().get(), allocation);
             mapped = nullptr;
         }
     }
@@ -112,12 +117,8 @@ namespace Voortman {
      * @return VkResult of the flush call
      */
     VkResult SteelSightBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(SSDevice.device(), 1, &mappedRange);
+        // Offset and size are relative to the allocation, the allocator aligns them to nonCoherentAtomSize inside the block
+        return vmaFlushAllocation(SSDevice.getAllocator().get(), allocation, offset, size);
     }
 
     /**
@@ -132,12 +133,7 @@ namespace Voortman {
      * @return VkResult of the invalidate call
      */
     VkResult SteelSightBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(SSDevice.device(), 1, &mappedRange);
+        return vmaInvalidateAllocation(SSDevice.getAllocator().get(), allocation, offset, size);
     }
 
     /**
@@ -38,7 +38,8 @@ namespace Voortman {
         SteelSightDevice& SSDevice;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        // Sub-allocated from a block of the device allocator, the buffer does not own a VkDeviceMemory
+        VmaAllocation allocation = VK_NULL_HANDLE;
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -87,7 +87,17 @@ namespace Voortman {
 		createSurface();
 		pickPhysicalDevice();
 		CreateLogicalDevice();
+		allocator = std::make_unique<SteelSightAllocator>(instance_, physicalDevice, device_, VULKAN_API_VERSION);
 		createCommandPool();
+
+		const QueueFamilyIndices indices = findPhysicalQueueFamilies();
+		const uint32_t uploadFamily = indices.transferFamily.value_or(indices.graphicsFamily.value());
+		transferQueue_ = std::make_unique<SteelSightTransferQueue>(device_, graphicsQueue_, indices.graphicsFamily.value(), queueMutex, uploadQueue_, uploadFamily);
+		stagingRing = std::make_unique<SteelSightStagingRing>(*this);
+		geometryPool = std::make_unique<SteelSightGeometryPool>(*this);
+
+		std::cout << (transferQueue_->isDedicated() ? "Uploads run on the dedicated transfer queue family " : "No dedicated transfer queue, uploads run on the graphics queue family ")
+			<< uploadFamily << std::endl;
 	}
 
 	void SteelSightDevice::createCommandPool() {
@@ -115,6 +125,7 @@ namespace Voortman {
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+		if (indices.transferFamily.has_value()) uniqueQueueFamilies.insert(indices.transferFamily.value());
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -128,8 +139,14 @@ namespace Voortman {
 
 		VkPhysicalDeviceFeatures deviceFeatures{};
 
+		// The uploads on the transfer queue signal a timeline semaphore the frames wait for, core and required since Vulkan 1.2
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = &vulkan12Features;
 
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -152,12 +169,18 @@ namespace Voortman {
 
 		vkGetDeviceQueue(device_, indices.graphicsFamily.value(), 0, &graphicsQueue_);
 		vkGetDeviceQueue(device_, indices.presentFamily.value(), 0, &presentQueue_);
+		if (indices.transferFamily.has_value()) vkGetDeviceQueue(device_, indices.transferFamily.value(), 0, &uploadQueue_);
+		else uploadQueue_ = graphicsQueue_;
 	}
 
 	SteelSightDevice::~SteelSightDevice() {
+		geometryPool.reset();
+		stagingRing.reset();
+		transferQueue_.reset();
 		if (commandPool) _LIKELY {
 			vkDestroyCommandPool(device_, commandPool, nullptr);
 		}
+		allocator.reset();
 		if (device_) _LIKELY {
 			vkDestroyDevice(device_, nullptr);
 		}
@@ -281,7 +304,7 @@ namespace Voortman {
 		const VkImageCreateInfo& imageInfo,
 		VkMemoryPropertyFlags properties,
 		VkImage& image,
-		VkDeviceMemory& imageMemory) {
+		VmaAllocation& imageAllocation) {
 		if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image!");
 		}
@@ -289,20 +312,18 @@ namespace Voortman {
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+		imageAllocation = allocator->allocate(memRequirements, findMemoryType(memRequirements.memoryTypeBits, properties), SteelSightAllocator::Usage::Image);
 
-		if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
-		}
-
-		if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+		if (vmaBindImageMemory(allocator->get(), imageAllocation, image) != VK_SUCCESS) {
 			throw std::runtime_error("failed to bind image memory!");
 		}
 	}
 
+	void SteelSightDevice::destroyImage(VkImage image, VmaAllocation imageAllocation) noexcept {
+		vkDestroyImage(device_, image, nullptr);
+		allocator->free(imageAllocation);
+	}
+
 	void SteelSightDevice::createSurface() { window.createWindowSurface(instance_, &surface_); }
 
 	// Function to validate if the physical device is realy suitable:
@@ -364,13 +385,24 @@ namespace Voortman {
 		VkBufferUsageFlags usage,
 		VkMemoryPropertyFlags properties,
 		VkBuffer& buffer,
-		VkDeviceMemory& bufferMemory) {
+		VmaAllocation& bufferAllocation,
+		bool concurrent) {
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		bufferInfo.size = size;
 		bufferInfo.usage = usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		// Without a dedicated transfer queue there is only one family to share with
+		uint32_t families[2]{};
+		if (concurrent && transferQueue_->isDedicated()) {
+			families[0] = transferQueue_->getGraphicsFamily();
+			families[1] = transferQueue_->getFamily();
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = 2;
+			bufferInfo.pQueueFamilyIndices = families;
+		}
+
 		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create vertex buffer!");
 		}
@@ -378,15 +410,14 @@ namespace Voortman {
 		VkMemoryRequirements memRequirements;
 		vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+		// Thousands of models would exceed maxMemoryAllocationCount with one VkDeviceMemory per buffer
+		bufferAllocation = allocator->allocate(memRequirements, findMemoryType(memRequirements.memoryTypeBits, properties), SteelSightAllocator::classify(usage, properties));
+		vmaBindBufferMemory(allocator->get(), bufferAllocation, buffer);
+	}
 
-		if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate vertex buffer memory!");
-		}
-		vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+	void SteelSightDevice::destroyBuffer(VkBuffer buffer, VmaAllocation bufferAllocation) noexcept {
+		vkDestroyBuffer(device_, buffer, nullptr);
+		allocator->free(bufferAllocation);
 	}
 
 	bool SteelSightDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
@@ -433,79 +464,24 @@ namespace Voortman {
 			i++;
 		}
 
-		return indices;
-	}
-
-	VkCommandBuffer SteelSightDevice::beginSingleTimeCommands() {
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
+		// Transfer only families are backed by the copy engines, a family that can compute as well is the next best
+		bool computeCapable{ true };
+		for (uint32_t family = 0; family < queueFamilyCount; ++family) {
+			const VkQueueFlags flags = queueFamilies[family].queueFlags;
+			if (queueFamilies[family].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT)) continue;
 
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
-
-		VkCommandBufferBeginInfo beginInfo{};
-
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		return commandBuffer;
-	}
-
-	void SteelSightDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(graphicsQueue_);
-
-		vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
-	}
-
-	void SteelSightDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkBufferCopy copyRegion{};
-		copyRegion.srcOffset = 0;  // Optional
-		copyRegion.dstOffset = 0;  // Optional
-		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+			if (!indices.transferFamily.has_value() || (computeCapable && !(flags & VK_QUEUE_COMPUTE_BIT))) {
+				indices.transferFamily = family;
+				computeCapable = (flags & VK_QUEUE_COMPUTE_BIT) != 0;
+			}
+		}
 
-		endSingleTimeCommands(commandBuffer);
+		return indices;
 	}
 
-	void SteelSightDevice::copyBufferToImage(
-		VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = layerCount;
-
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = { width, height, 1 };
-
-		vkCmdCopyBufferToImage(
-			commandBuffer,
-			buffer,
-			image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1,
-			&region);
-		endSingleTimeCommands(commandBuffer);
+	void SteelSightDevice::waitIdle() {
+		std::lock_guard lock{ queueMutex };
+		vkDeviceWaitIdle(device_);
 	}
 
 	void SteelSightDevice::CreateInstance() {
@@ -520,7 +496,7 @@ namespace Voortman {
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_3; // Use the newest vulkan api
+		appInfo.apiVersion = VULKAN_API_VERSION; // Use the newest vulkan api
 
 		VkInstanceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
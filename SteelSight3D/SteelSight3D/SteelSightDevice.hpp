@@ -1,5 +1,9 @@
 #pragma once
 #include "SteelSightWindow.hpp"
+#include "SteelSightAllocator.hpp"
+#include "SteelSightStagingRing.hpp"
+#include "SteelSightTransferQueue.hpp"
+#include "SteelSightGeometryPool.hpp"
 
 #include <optional>
 #include <string>
@@ -10,6 +14,8 @@
 #include <iostream>
 #include <set>
 #include <unordered_set>
+#include <mutex>
+#include <memory>
 
 // Here define if you want to use MAILBOX_MODE mode or IMMEDIATE_MODE
 // Code will try to choose if this is available
@@ -26,12 +32,17 @@ namespace Voortman {
 	struct QueueFamilyIndices final {
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		// A family that can transfer but not draw, the uploads run on the graphics family when there is none
+		std::optional<uint32_t> transferFamily;
 
 		bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 	};
 
 	class SteelSightDevice final {
 	public:
+		// Version of the instance, the allocator uses the functions of the same version
+		static constexpr uint32_t VULKAN_API_VERSION{ VK_API_VERSION_1_3 };
+
 		SteelSightDevice(SteelSightWindow& SSwindow);
 		~SteelSightDevice();
 
@@ -52,20 +63,39 @@ namespace Voortman {
 		QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
 		VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
+		// The memory of images and buffers is sub-allocated from the pools of the allocator, free it with destroyImage and destroyBuffer
 		void createImageWithInfo(
 			const VkImageCreateInfo& imageInfo,
 			VkMemoryPropertyFlags properties,
 			VkImage& image,
-			VkDeviceMemory& imageMemory);
+			VmaAllocation& imageAllocation);
 
+		// A concurrent buffer is shared by the graphics and the transfer queue family, uploads to a part of it need no ownership transfer
 		void createBuffer(
 			VkDeviceSize size,
 			VkBufferUsageFlags usage,
 			VkMemoryPropertyFlags properties,
 			VkBuffer& buffer,
-			VkDeviceMemory& bufferMemory);
+			VmaAllocation& bufferAllocation,
+			bool concurrent = false);
+
+		void destroyImage(VkImage image, VmaAllocation imageAllocation) noexcept;
+		void destroyBuffer(VkBuffer buffer, VmaAllocation bufferAllocation) noexcept;
+
+		_NODISCARD inline SteelSightAllocator& getAllocator() noexcept { return *allocator; }
+
+		// Uploads are recorded into a SteelSightUploadBatch that stages its data through the ring and submits it to the transfer queue
+		_NODISCARD inline SteelSightStagingRing& getStagingRing() noexcept { return *stagingRing; }
+		_NODISCARD inline SteelSightTransferQueue& getTransferQueue() noexcept { return *transferQueue_; }
+
+		// The vertices and indices of every model are ranges of the buffers of the pool
+		_NODISCARD inline SteelSightGeometryPool& getGeometryPool() noexcept { return *geometryPool; }
 
-		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+		// Every vkQueueSubmit and vkQueuePresentKHR must hold this lock, models upload from the loader threads while the render thread submits frames
+		_NODISCARD inline std::mutex& getQueueMutex() noexcept { return queueMutex; }
+
+		// vkDeviceWaitIdle, synchronized with the uploads of other threads
+		void waitIdle();
 
 	private:
 		// Don't build any functions or variables related to validation layers
@@ -81,12 +111,23 @@ namespace Voortman {
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 		VkCommandPool commandPool;
 
+		std::mutex queueMutex{};
+
 		VkDevice device_;
 
+		// Created after and destroyed before the logical device
+		std::unique_ptr<SteelSightAllocator> allocator{};
+
+		// Created after the allocator and destroyed before it
+		std::unique_ptr<SteelSightTransferQueue> transferQueue_{};
+		std::unique_ptr<SteelSightStagingRing> stagingRing{};
+		std::unique_ptr<SteelSightGeometryPool> geometryPool{};
+
 		VkSurfaceKHR surface_;
 
 		VkQueue graphicsQueue_;
 		VkQueue presentQueue_;
+		VkQueue uploadQueue_{ VK_NULL_HANDLE };
 		VkSampleCountFlagBits msaaSamples;
 
 		// Reference to the window
@@ -98,9 +139,6 @@ namespace Voortman {
 		SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
-		VkCommandBuffer beginSingleTimeCommands();
-		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
 		inline void createSurface();
 		void CreateInstance();
@@ -0,0 +1,906 @@
+#include "SteelSightDstv.hpp"
+#include "SteelSightUtils.hpp"
+#include "unordered_dense.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <charconv>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+
+namespace Voortman {
+	namespace {
+		using Vertex = SteelSightModel::Vertex;
+		using Profile = SteelSightDstv::Profile;
+		using Section = SteelSightDstv::Section;
+
+		// Millimeters, NC1 files are written with two decimals
+		constexpr float EPSILON{ 1e-3f };
+
+		constexpr uint32_t FILLET_SEGMENTS{ 4 };
+		constexpr uint32_t TUBE_SEGMENTS{ 32 };
+		constexpr uint32_t HOLE_SEGMENTS{ 16 };
+
+		// Amount of header lines up to the root radius: order, drawing, phase, piece, steel grade, quantity, profile, code, length, height, flange width, flange thickness, web thickness, radius
+		constexpr size_t HEADER_FIELDS{ 14 };
+
+		struct Hole final {
+			char face{ 'v' };
+			float x{ 0.f };
+			float y{ 0.f };
+			float diameter{ 0.f };
+		};
+
+		struct Contour final {
+			char face{ 'v' };
+			bool outer{ true };
+			std::vector<glm::vec2> points{};
+		};
+
+		// A flat plate of the profile (web, flange, tube wall), holes on its DSTV face run through it
+		struct Plate final {
+			char face{ 'v' };
+
+			// Component of the section the holes run along, 0 for z and 1 for y
+			uint32_t axis{ 0 };
+			float from{ 0.f };
+			float to{ 0.f };
+		};
+
+		struct ProfileHash final {
+			_NODISCARD inline uint64_t operator()(const Profile& profile) const noexcept {
+				size_t seed{ ankerl::unordered_dense::hash<std::string>{}(profile.code) };
+				hashCombine(seed, profile.height, profile.flangeWidth, profile.flangeThickness, profile.webThickness, profile.radius);
+				return seed;
+			}
+		};
+
+		_NODISCARD inline float cross(const glm::vec2& a, const glm::vec2& b) noexcept { return a.x * b.y - a.y * b.x; }
+
+		// Sections lie in the (z, y) plane of the beam
+		_NODISCARD inline glm::vec3 toBeam(float x, const glm::vec2& point) noexcept { return { x, point.y, point.x }; }
+		_NODISCARD inline glm::vec2 toSection(const glm::vec3& position) noexcept { return { position.z, position.y }; }
+
+		_NODISCARD float signedArea(const std::vector<glm::vec2>& points, const std::vector<uint32_t>& loop) noexcept {
+			float area{ 0.f };
+			for (size_t i = 0; i < loop.size(); ++i) area += cross(points[loop[i]], points[loop[(i + 1) % loop.size()]]);
+			return area / 2.f;
+		}
+
+		// True when the segments cross in a point inside both of them, touching segments do not cross
+		_NODISCARD bool segmentsCross(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& d) noexcept {
+			const float o1 = cross(b - a, c - a);
+			const float o2 = cross(b - a, d - a);
+			const float o3 = cross(d - c, a - c);
+			const float o4 = cross(d - c, b - c);
+			return o1 * o2 < 0.f && o3 * o4 < 0.f;
+		}
+
+		// True when the point lies on the segment between its end points
+		_NODISCARD bool onSegment(const glm::vec2& point, const glm::vec2& a, const glm::vec2& b) noexcept {
+			if (point == a || point == b) return false;
+			const glm::vec2 ab = b - a;
+			const float along = glm::dot(point - a, ab);
+			return std::abs(cross(ab, point - a)) <= EPSILON * glm::length(ab) && along > 0.f && along < glm::dot(ab, ab);
+		}
+
+		_NODISCARD bool insideTriangle(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) noexcept {
+			return cross(b - a, p - a) >= 0.f && cross(c - b, p - b) >= 0.f && cross(a - c, p - c) >= 0.f;
+		}
+
+		/// <summary>
+		/// Triangulates a polygon with holes by ear clipping. Every hole is first joined to the polygon with a bridge to the nearest vertex it can see,
+		/// starting with the hole that reaches furthest along x.
+		/// </summary>
+		/// <param name="points">The points of every loop</param>
+		/// <param name="loops">The outer loop followed by the holes, indices into points. The orientation does not matter</param>
+		/// <returns>Counterclockwise triangles, indices into points</returns>
+		_NODISCARD std::vector<uint32_t> triangulate(const std::vector<glm::vec2>& points, const std::vector<std::vector<uint32_t>>& loops) {
+			std::vector<uint32_t> polygon = loops.front();
+			if (signedArea(points, polygon) < 0.f) std::reverse(polygon.begin(), polygon.end());
+
+			std::vector<std::vector<uint32_t>> holes(loops.begin() + 1, loops.end());
+			for (auto& hole : holes) {
+				if (signedArea(points, hole) > 0.f) std::reverse(hole.begin(), hole.end());
+			}
+
+			const auto maximumX = [&points](const std::vector<uint32_t>& loop) {
+				return std::max_element(loop.begin(), loop.end(), [&points](uint32_t a, uint32_t b) { return points[a].x < points[b].x; }) - loop.begin();
+			};
+			std::sort(holes.begin(), holes.end(), [&](const auto& a, const auto& b) { return points[a[maximumX(a)]].x > points[b[maximumX(b)]].x; });
+
+			// A bridge may not cross an edge or run through a vertex, holes in a row share their largest x and a bridge along them would pass through the next hole
+			const auto blocked = [&points](const std::vector<uint32_t>& loop, const glm::vec2& a, const glm::vec2& b) {
+				for (size_t i = 0; i < loop.size(); ++i) {
+					if (segmentsCross(a, b, points[loop[i]], points[loop[(i + 1) % loop.size()]])) return true;
+					if (onSegment(points[loop[i]], a, b)) return true;
+				}
+				return false;
+			};
+
+			for (size_t h = 0; h < holes.size(); ++h) {
+				const auto& hole = holes[h];
+				const size_t start = maximumX(hole);
+				const glm::vec2 origin = points[hole[start]];
+
+				std::vector<size_t> candidates(polygon.size());
+				std::iota(candidates.begin(), candidates.end(), size_t{ 0 });
+				std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b) {
+					const glm::vec2 da = points[polygon[a]] - origin;
+					const glm::vec2 db = points[polygon[b]] - origin;
+					return glm::dot(da, da) < glm::dot(db, db);
+				});
+
+				// The nearest vertex whose bridge crosses neither the polygon nor a hole that is not joined yet
+				size_t bridge = candidates.front();
+				for (const size_t candidate : candidates) {
+					const glm::vec2 target = points[polygon[candidate]];
+					if (blocked(polygon, origin, target)) continue;
+					if (std::any_of(holes.begin() + h, holes.end(), [&](const auto& other) { return blocked(other, origin, target); })) continue;
+
+					bridge = candidate;
+					break;
+				}
+
+				std::vector<uint32_t> joined{};
+				joined.reserve(polygon.size() + hole.size() + 2);
+				joined.insert(joined.end(), polygon.begin(), polygon.begin() + bridge + 1);
+				for (size_t i = 0; i <= hole.size(); ++i) joined.push_back(hole[(start + i) % hole.size()]);
+				joined.insert(joined.end(), polygon.begin() + bridge, polygon.end());
+				polygon = std::move(joined);
+			}
+
+			const size_t count = polygon.size();
+			std::vector<size_t> previous(count);
+			std::vector<size_t> next(count);
+			for (size_t i = 0; i < count; ++i) {
+				previous[i] = (i + count - 1) % count;
+				next[i] = (i + 1) % count;
+			}
+
+			const auto isEar = [&](size_t corner) {
+				const glm::vec2& a = points[polygon[previous[corner]]];
+				const glm::vec2& b = points[polygon[corner]];
+				const glm::vec2& c = points[polygon[next[corner]]];
+				if (cross(b - a, c - b) <= 0.f) return false;
+
+				// The bridges repeat points, a repeated corner is not inside the ear
+				for (size_t other = next[next[corner]]; other != previous[corner]; other = next[other]) {
+					const glm::vec2& p = points[polygon[other]];
+					if (p == a || p == b || p == c) continue;
+					if (insideTriangle(p, a, b, c)) return false;
+				}
+				return true;
+			};
+
+			std::vector<uint32_t> triangles{};
+			triangles.reserve(3 * count);
+
+			size_t remaining{ count };
+			size_t corner{ 0 };
+			size_t tried{ 0 };
+			while (remaining > 3) {
+				// Without an ear left, only degenerate triangles remain and the current one is clipped anyway
+				if (!isEar(corner) && ++tried <= remaining) {
+					corner = next[corner];
+					continue;
+				}
+
+				triangles.insert(triangles.end(), { polygon[previous[corner]], polygon[corner], polygon[next[corner]] });
+				next[previous[corner]] = next[corner];
+				previous[next[corner]] = previous[corner];
+				corner = next[corner];
+				--remaining;
+				tried = 0;
+			}
+			triangles.insert(triangles.end(), { polygon[previous[corner]], polygon[corner], polygon[next[corner]] });
+
+			return triangles;
+		}
+
+		struct Loop final {
+			std::vector<glm::vec2> points{};
+			std::vector<bool> smooth{};
+
+			// A fillet at its largest radius ends on the next point, the duplicate is merged so the outline has no zero-length edges. A sharp corner wins over a smooth one
+			inline void add(const glm::vec2& point, bool isSmooth) {
+				if (!points.empty() && glm::distance(points.back(), point) <= EPSILON) _UNLIKELY {
+					smooth.back() = smooth.back() && isSmooth;
+					return;
+				}
+				points.push_back(point);
+				smooth.push_back(isSmooth);
+			}
+
+			// Merges the last point into the first one when the outline ends where it started
+			void close() {
+				if (points.size() > 1 && glm::distance(points.back(), points.front()) <= EPSILON) _UNLIKELY {
+					smooth.front() = smooth.front() && smooth.back();
+					points.pop_back();
+					smooth.pop_back();
+				}
+			}
+
+			// Fillet around center from one angle to the other in degrees, the straight edges are tangent at both ends so every point is smooth
+			void addArc(const glm::vec2& center, float radius, float from, float to) {
+				if (radius <= EPSILON) {
+					add(center, false);
+					return;
+				}
+
+				for (uint32_t segment = 0; segment <= FILLET_SEGMENTS; ++segment) {
+					const float angle = glm::radians(from + (to - from) * segment / FILLET_SEGMENTS);
+					add(center + radius * glm::vec2{ std::cos(angle), std::sin(angle) }, true);
+				}
+			}
+
+			void addCircle(const glm::vec2& center, float radius, bool counterclockwise) {
+				for (uint32_t segment = 0; segment < TUBE_SEGMENTS; ++segment) {
+					const float angle = glm::two_pi<float>() * (counterclockwise ? segment : TUBE_SEGMENTS - segment) / TUBE_SEGMENTS;
+					add(center + radius * glm::vec2{ std::cos(angle), std::sin(angle) }, true);
+				}
+			}
+
+			void addRectangle(const glm::vec2& minimum, const glm::vec2& maximum, bool counterclockwise) {
+				const glm::vec2 corners[4]{ minimum, { maximum.x, minimum.y }, maximum, { minimum.x, maximum.y } };
+				for (size_t i = 0; i < 4; ++i) add(corners[counterclockwise ? i : (4 - i) % 4], false);
+			}
+		};
+
+		_NODISCARD bool isCode(const Profile& profile, std::string_view code) noexcept { return profile.code == code; }
+
+		// Outlines in (z, y), the web of open profiles is centered at flangeWidth / 2 and the bottom is at y = 0
+		_NODISCARD std::vector<Loop> buildOutline(const Profile& profile) {
+			const float h = profile.height;
+			const float b = profile.flangeWidth;
+			const float t = profile.flangeThickness;
+			const float s = profile.webThickness;
+			const float zc = b / 2.f;
+
+			std::vector<Loop> loops(1);
+			Loop& outer = loops.front();
+
+			const bool open = isCode(profile, "I") || isCode(profile, "U") || isCode(profile, "C") || isCode(profile, "L") || isCode(profile, "T");
+			if (open && (b <= 0.f || t <= 0.f || s <= 0.f || s >= b || 2.f * t >= h)) _UNLIKELY throw std::runtime_error("invalid dimensions for profile code " + profile.code);
+
+			if (isCode(profile, "I")) {
+				const float r = std::clamp(profile.radius, 0.f, std::min((h - 2.f * t) / 2.f, (b - s) / 2.f));
+				outer.add({ 0.f, 0.f }, false);
+				outer.add({ b, 0.f }, false);
+				outer.add({ b, t }, false);
+				outer.addArc({ zc + s / 2.f + r, t + r }, r, 270.f, 180.f);
+				outer.addArc({ zc + s / 2.f + r, h - t - r }, r, 180.f, 90.f);
+				outer.add({ b, h - t }, false);
+				outer.add({ b, h }, false);
+				outer.add({ 0.f, h }, false);
+				outer.add({ 0.f, h - t }, false);
+				outer.addArc({ zc - s / 2.f - r, h - t - r }, r, 90.f, 0.f);
+				outer.addArc({ zc - s / 2.f - r, t + r }, r, 0.f, -90.f);
+				outer.add({ 0.f, t }, false);
+			}
+			else if (isCode(profile, "U") || isCode(profile, "C")) {
+				// Web at the back (z = 0), flanges towards +z
+				const float r = std::clamp(profile.radius, 0.f, std::min((h - 2.f * t) / 2.f, b - s));
+				outer.add({ 0.f, 0.f }, false);
+				outer.add({ b, 0.f }, false);
+				outer.add({ b, t }, false);
+				outer.addArc({ s + r, t + r }, r, 270.f, 180.f);
+				outer.addArc({ s + r, h - t - r }, r, 180.f, 90.f);
+				outer.add({ b, h - t }, false);
+				outer.add({ b, h }, false);
+				outer.add({ 0.f, h }, false);
+			}
+			else if (isCode(profile, "L")) {
+				// Vertical leg at z = 0, horizontal leg at y = 0
+				const float r = std::clamp(profile.radius, 0.f, std::min(h - t, b - s));
+				outer.add({ 0.f, 0.f }, false);
+				outer.add({ b, 0.f }, false);
+				outer.add({ b, t }, false);
+				outer.addArc({ s + r, t + r }, r, 270.f, 180.f);
+				outer.add({ s, h }, false);
+				outer.add({ 0.f, h }, false);
+			}
+			else if (isCode(profile, "T")) {
+				// Flange on top
+				const float r = std::clamp(profile.radius, 0.f, std::min(h - t, (b - s) / 2.f));
+				outer.add({ zc - s / 2.f, 0.f }, false);
+				outer.add({ zc + s / 2.f, 0.f }, false);
+				outer.addArc({ zc + s / 2.f + r, h - t - r }, r, 180.f, 90.f);
+				outer.add({ b, h - t }, false);
+				outer.add({ b, h }, false);
+				outer.add({ 0.f, h }, false);
+				outer.add({ 0.f, h - t }, false);
+				outer.addArc({ zc - s / 2.f - r, h - t - r }, r, 90.f, 0.f);
+			}
+			else if (isCode(profile, "RO") || isCode(profile, "RU")) {
+				// Round tube and round bar, the diameter is the height
+				outer.addCircle({ h / 2.f, h / 2.f }, h / 2.f, true);
+				if (isCode(profile, "RO") && s > 0.f && 2.f * s < h) loops.emplace_back().addCircle({ h / 2.f, h / 2.f }, h / 2.f - s, false);
+			}
+			else if (isCode(profile, "M")) {
+				// Rectangular tube, the wall thickness is the web thickness
+				outer.addRectangle({ 0.f, 0.f }, { b, h }, true);
+				if (s > 0.f && 2.f * s < std::min(b, h)) loops.emplace_back().addRectangle({ s, s }, { b - s, h - s }, false);
+			}
+			else if (isCode(profile, "B")) {
+				// Plate standing on its edge, the thickness is the web thickness
+				outer.addRectangle({ 0.f, 0.f }, { s > 0.f ? s : t, h }, true);
+			}
+			else {
+				// Special profiles (SO) and unknown codes are shown as their bounding box
+				outer.addRectangle({ 0.f, 0.f }, { b > 0.f ? b : h, h }, true);
+			}
+
+			for (auto& loop : loops) loop.close();
+			return loops;
+		}
+
+		_NODISCARD std::vector<Plate> getPlates(const Profile& profile) {
+			const float h = profile.height;
+			const float b = profile.flangeWidth;
+			const float t = profile.flangeThickness;
+			const float s = profile.webThickness;
+
+			if (isCode(profile, "I")) return { { 'v', 0, b / 2.f - s / 2.f, b / 2.f + s / 2.f }, { 'h', 0, b / 2.f - s / 2.f, b / 2.f + s / 2.f }, { 'o', 1, h - t, h }, { 'u', 1, 0.f, t } };
+			if (isCode(profile, "U") || isCode(profile, "C")) return { { 'v', 0, 0.f, s }, { 'h', 0, 0.f, s }, { 'o', 1, h - t, h }, { 'u', 1, 0.f, t } };
+			if (isCode(profile, "L")) return { { 'v', 0, 0.f, s }, { 'h', 0, 0.f, s }, { 'u', 1, 0.f, t } };
+			if (isCode(profile, "T")) return { { 'v', 0, b / 2.f - s / 2.f, b / 2.f + s / 2.f }, { 'h', 0, b / 2.f - s / 2.f, b / 2.f + s / 2.f }, { 'o', 1, h - t, h } };
+			if (isCode(profile, "M") && s > 0.f && 2.f * s < std::min(b, h)) return { { 'v', 0, 0.f, s }, { 'h', 0, b - s, b }, { 'u', 1, 0.f, s }, { 'o', 1, h - s, h } };
+			return {};
+		}
+
+		_NODISCARD std::shared_ptr<const Section> buildSection(const Profile& profile) {
+			auto section = std::make_shared<Section>();
+			std::vector<glm::vec2> points{};
+			std::vector<std::vector<uint32_t>> loops{};
+
+			for (auto& loop : buildOutline(profile)) {
+				auto& indices = loops.emplace_back(loop.points.size());
+				std::iota(indices.begin(), indices.end(), static_cast<uint32_t>(points.size()));
+				points.insert(points.end(), loop.points.begin(), loop.points.end());
+
+				section->loops.push_back(std::move(loop.points));
+				section->smooth.push_back(std::move(loop.smooth));
+			}
+
+			section->capIndices = triangulate(points, loops);
+			return section;
+		}
+
+		class MeshBuilder final {
+		public:
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+
+			inline uint32_t add(const glm::vec3& position, const glm::vec3& normal) {
+				vertices.push_back({ position, normal, glm::vec2{ 0.f } });
+				return static_cast<uint32_t>(vertices.size() - 1);
+			}
+
+			// The winding is taken from the normals, so callers do not have to track the orientation of every face
+			void addTriangle(uint32_t a, uint32_t b, uint32_t c) {
+				const glm::vec3 facing = glm::cross(vertices[b].position - vertices[a].position, vertices[c].position - vertices[a].position);
+				if (glm::dot(facing, vertices[a].normal + vertices[b].normal + vertices[c].normal) < 0.f) std::swap(b, c);
+				indices.insert(indices.end(), { a, b, c });
+			}
+
+			inline void addQuad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+				addTriangle(a, b, c);
+				addTriangle(a, c, d);
+			}
+
+			// Inside of a hole from one circle to the other, the normals point at the axis of the hole
+			void addHoleWall(const std::vector<glm::vec3>& first, const std::vector<glm::vec3>& second, const glm::vec3& firstCenter, const glm::vec3& secondCenter) {
+				const uint32_t base = static_cast<uint32_t>(vertices.size());
+				for (size_t i = 0; i < first.size(); ++i) {
+					add(first[i], glm::normalize(firstCenter - first[i]));
+					add(second[i], glm::normalize(secondCenter - second[i]));
+				}
+
+				for (uint32_t i = 0; i < first.size(); ++i) {
+					const uint32_t j = (i + 1) % static_cast<uint32_t>(first.size());
+					addQuad(base + 2 * i, base + 2 * i + 1, base + 2 * j + 1, base + 2 * j);
+				}
+			}
+		};
+
+		_NODISCARD std::vector<glm::vec3> makeCircle(const glm::vec3& center, const glm::vec3& u, const glm::vec3& v, float radius) {
+			std::vector<glm::vec3> circle(HOLE_SEGMENTS);
+			for (uint32_t segment = 0; segment < HOLE_SEGMENTS; ++segment) {
+				const float angle = glm::two_pi<float>() * segment / HOLE_SEGMENTS;
+				circle[segment] = center + radius * (std::cos(angle) * u + std::sin(angle) * v);
+			}
+			return circle;
+		}
+
+		// A hole cut into a side face of the beam, center in (x, distance along the edge)
+		struct Cut final {
+			glm::vec2 center{};
+			float radius{ 0.f };
+			std::vector<glm::vec3> circle{};
+		};
+
+		/// <summary>
+		/// Extrudes the section over the length of the beam and cuts the holes out of the side faces of their plates.
+		/// </summary>
+		void meshBeam(const Section& section, const std::vector<Plate>& plates, float length, const std::vector<Hole>& holes, MeshBuilder& mesh, size_t& cutHoles) {
+			std::vector<std::vector<std::vector<Cut>>> cuts(section.loops.size());
+			for (size_t l = 0; l < section.loops.size(); ++l) cuts[l].resize(section.loops[l].size());
+
+			// The edge of the section that lies in the plane of a plate side and has room for the hole, the center of the hole is in (x, distance along the edge)
+			const auto findEdge = [&](uint32_t axis, float plane, const glm::vec2& point, float x, float radius, glm::vec2& center) -> std::vector<Cut>* {
+				for (size_t l = 0; l < section.loops.size(); ++l) {
+					const auto& loop = section.loops[l];
+					for (size_t i = 0; i < loop.size(); ++i) {
+						const glm::vec2& p0 = loop[i];
+						const glm::vec2& p1 = loop[(i + 1) % loop.size()];
+						if (std::abs(p0[axis] - plane) > EPSILON || std::abs(p1[axis] - plane) > EPSILON) continue;
+
+						const float edgeLength = glm::length(p1 - p0);
+						const glm::vec2 direction = (p1 - p0) / edgeLength;
+						const float along = glm::dot(point - p0, direction);
+						if (std::abs(cross(direction, point - p0)) > EPSILON) continue;
+						if (x - radius <= EPSILON || x + radius >= length - EPSILON || along - radius <= EPSILON || along + radius >= edgeLength - EPSILON) continue;
+
+						center = { x, along };
+						const bool overlaps = std::any_of(cuts[l][i].begin(), cuts[l][i].end(), [&](const Cut& cut) { return glm::distance(cut.center, center) <= cut.radius + radius + EPSILON; });
+						return overlaps ? nullptr : &cuts[l][i];
+					}
+				}
+				return nullptr;
+			};
+
+			for (const Hole& hole : holes) {
+				const float radius = hole.diameter / 2.f;
+				if (radius <= EPSILON) _UNLIKELY continue;
+
+				for (const Plate& plate : plates) {
+					if (plate.face != hole.face) continue;
+
+					const glm::vec2 first = plate.axis == 0 ? glm::vec2{ plate.from, hole.y } : glm::vec2{ hole.y, plate.from };
+					const glm::vec2 second = plate.axis == 0 ? glm::vec2{ plate.to, hole.y } : glm::vec2{ hole.y, plate.to };
+
+					glm::vec2 firstCenter{};
+					glm::vec2 secondCenter{};
+					auto* firstCuts = findEdge(plate.axis, plate.from, first, hole.x, radius, firstCenter);
+					auto* secondCuts = findEdge(plate.axis, plate.to, second, hole.x, radius, secondCenter);
+					if (!firstCuts || !secondCuts) continue;
+
+					const glm::vec3 across = plate.axis == 0 ? glm::vec3{ 0.f, 1.f, 0.f } : glm::vec3{ 0.f, 0.f, 1.f };
+					const glm::vec3 firstPoint = toBeam(hole.x, first);
+					const glm::vec3 secondPoint = toBeam(hole.x, second);
+					Cut firstCut{ firstCenter, radius, makeCircle(firstPoint, { 1.f, 0.f, 0.f }, across, radius) };
+					Cut secondCut{ secondCenter, radius, makeCircle(secondPoint, { 1.f, 0.f, 0.f }, across, radius) };
+
+					mesh.addHoleWall(firstCut.circle, secondCut.circle, firstPoint, secondPoint);
+					firstCuts->push_back(std::move(firstCut));
+					secondCuts->push_back(std::move(secondCut));
+					++cutHoles;
+					break;
+				}
+			}
+
+			// End caps
+			std::vector<glm::vec2> capPoints{};
+			for (const auto& loop : section.loops) capPoints.insert(capPoints.end(), loop.begin(), loop.end());
+
+			for (const float x : { 0.f, length }) {
+				const glm::vec3 normal{ x == 0.f ? -1.f : 1.f, 0.f, 0.f };
+				const uint32_t base = static_cast<uint32_t>(mesh.vertices.size());
+				for (const glm::vec2& point : capPoints) mesh.add(toBeam(x, point), normal);
+				for (size_t i = 0; i < section.capIndices.size(); i += 3) mesh.addTriangle(base + section.capIndices[i], base + section.capIndices[i + 1], base + section.capIndices[i + 2]);
+			}
+
+			// Faces with holes are split along x between holes that do not overlap in x, ear clipping is quadratic in the points of a polygon.
+			// The splits of a face are shared with the faces next to it, so no face has a vertex in the middle of an edge of another face
+			std::vector<std::vector<std::vector<float>>> splits(section.loops.size());
+			for (size_t l = 0; l < section.loops.size(); ++l) {
+				splits[l].resize(section.loops[l].size());
+				for (size_t i = 0; i < section.loops[l].size(); ++i) {
+					auto& edgeCuts = cuts[l][i];
+					std::sort(edgeCuts.begin(), edgeCuts.end(), [](const Cut& a, const Cut& b) { return a.center.x < b.center.x; });
+
+					float end = edgeCuts.empty() ? 0.f : edgeCuts.front().center.x + edgeCuts.front().radius;
+					for (size_t c = 1; c < edgeCuts.size(); ++c) {
+						const float begin = edgeCuts[c].center.x - edgeCuts[c].radius;
+						if (begin > end) splits[l][i].push_back((begin + end) / 2.f);
+						end = std::max(end, edgeCuts[c].center.x + edgeCuts[c].radius);
+					}
+				}
+			}
+
+			// Splits on the line the beam runs along through a point of the section, from both faces that meet there
+			const auto getLineSplits = [&splits](size_t l, size_t point) {
+				const size_t count = splits[l].size();
+				std::vector<float> line = splits[l][(point + count - 1) % count];
+				line.insert(line.end(), splits[l][point].begin(), splits[l][point].end());
+				std::sort(line.begin(), line.end());
+				line.erase(std::unique(line.begin(), line.end()), line.end());
+				return line;
+			};
+
+			// Side faces, one per edge of the section
+			for (size_t l = 0; l < section.loops.size(); ++l) {
+				const auto& loop = section.loops[l];
+				const size_t count = loop.size();
+
+				// A zero-length edge has no direction of its own and takes the normal of the edge before it
+				std::vector<glm::vec3> edgeNormals(count);
+				std::vector<bool> degenerate(count);
+				for (size_t i = 0; i < count; ++i) {
+					const glm::vec2 direction = loop[(i + 1) % count] - loop[i];
+					degenerate[i] = glm::dot(direction, direction) <= EPSILON * EPSILON;
+					if (!degenerate[i]) _LIKELY edgeNormals[i] = glm::normalize(toBeam(0.f, { direction.y, -direction.x }));
+				}
+				for (size_t i = 0; i < count; ++i) {
+					if (!degenerate[i]) _LIKELY continue;
+					for (size_t back = 1; back < count; ++back) {
+						const size_t previous = (i + count - back) % count;
+						if (!degenerate[previous]) {
+							edgeNormals[i] = edgeNormals[previous];
+							break;
+						}
+					}
+				}
+
+				for (size_t i = 0; i < count; ++i) {
+					const size_t j = (i + 1) % count;
+					const glm::vec2& p0 = loop[i];
+					const glm::vec2& p1 = loop[j];
+					const glm::vec3 n0 = section.smooth[l][i] ? glm::normalize(edgeNormals[(i + count - 1) % count] + edgeNormals[i]) : edgeNormals[i];
+					const glm::vec3 n1 = section.smooth[l][j] ? glm::normalize(edgeNormals[i] + edgeNormals[j]) : edgeNormals[i];
+
+					const std::vector<float> firstLine = getLineSplits(l, i);
+					const std::vector<float> secondLine = getLineSplits(l, j);
+					const auto& edgeCuts = cuts[l][i];
+
+					if (edgeCuts.empty()) _LIKELY {
+						// A strip between both lines, usually one quad over the whole length. The lines can hold different splits, so the triangles zip them together
+						std::vector<uint32_t> first{ mesh.add(toBeam(0.f, p0), n0) };
+						for (const float x : firstLine) first.push_back(mesh.add(toBeam(x, p0), n0));
+						first.push_back(mesh.add(toBeam(length, p0), n0));
+
+						std::vector<uint32_t> second{ mesh.add(toBeam(0.f, p1), n1) };
+						for (const float x : secondLine) second.push_back(mesh.add(toBeam(x, p1), n1));
+						second.push_back(mesh.add(toBeam(length, p1), n1));
+
+						for (size_t a = 0, b = 0; a + 1 < first.size() || b + 1 < second.size();) {
+							const bool advanceFirst = b + 1 == second.size() || (a + 1 < first.size() && mesh.vertices[first[a + 1]].position.x <= mesh.vertices[second[b + 1]].position.x);
+							if (advanceFirst) {
+								mesh.addTriangle(first[a], first[a + 1], second[b]);
+								++a;
+							}
+							else {
+								mesh.addTriangle(first[a], second[b + 1], second[b]);
+								++b;
+							}
+						}
+						continue;
+					}
+
+					// Every slab is a rectangle in (x, distance along the edge) with the splits of the neighbouring faces on its long sides and the holes as inner loops
+					const float edgeLength = glm::length(p1 - p0);
+					const glm::vec2 direction = (p1 - p0) / edgeLength;
+
+					std::vector<float> bounds{ 0.f };
+					bounds.insert(bounds.end(), splits[l][i].begin(), splits[l][i].end());
+					bounds.push_back(length);
+
+					size_t cut{ 0 };
+					for (size_t slab = 0; slab + 1 < bounds.size(); ++slab) {
+						const float x0 = bounds[slab];
+						const float x1 = bounds[slab + 1];
+
+						std::vector<glm::vec3> positions{ toBeam(x0, p0) };
+						for (const float x : firstLine) {
+							if (x > x0 && x < x1) positions.push_back(toBeam(x, p0));
+						}
+						positions.push_back(toBeam(x1, p0));
+						positions.push_back(toBeam(x1, p1));
+						for (auto x = secondLine.rbegin(); x != secondLine.rend(); ++x) {
+							if (*x > x0 && *x < x1) positions.push_back(toBeam(*x, p1));
+						}
+						positions.push_back(toBeam(x0, p1));
+
+						std::vector<std::vector<uint32_t>> loops(1, std::vector<uint32_t>(positions.size()));
+						std::iota(loops.front().begin(), loops.front().end(), 0u);
+
+						for (; cut < edgeCuts.size() && edgeCuts[cut].center.x < x1; ++cut) {
+							auto& hole = loops.emplace_back();
+							for (const glm::vec3& position : edgeCuts[cut].circle) {
+								hole.push_back(static_cast<uint32_t>(positions.size()));
+								positions.push_back(position);
+							}
+						}
+
+						std::vector<glm::vec2> points(positions.size());
+						for (size_t p = 0; p < positions.size(); ++p) points[p] = { positions[p].x, glm::dot(toSection(positions[p]) - p0, direction) };
+
+						const uint32_t base = static_cast<uint32_t>(mesh.vertices.size());
+						for (size_t p = 0; p < points.size(); ++p) mesh.add(positions[p], glm::normalize(glm::mix(n0, n1, points[p].y / edgeLength)));
+
+						const auto triangles = triangulate(points, loops);
+						for (size_t t = 0; t < triangles.size(); t += 3) mesh.addTriangle(base + triangles[t], base + triangles[t + 1], base + triangles[t + 2]);
+					}
+				}
+			}
+		}
+
+		_NODISCARD float distanceToSegment(const glm::vec2& point, const glm::vec2& a, const glm::vec2& b) noexcept {
+			const glm::vec2 ab = b - a;
+			const float t = std::clamp(glm::dot(point - a, ab) / std::max(glm::dot(ab, ab), EPSILON * EPSILON), 0.f, 1.f);
+			return glm::distance(point, a + t * ab);
+		}
+
+		_NODISCARD bool insidePolygon(const glm::vec2& point, const std::vector<glm::vec2>& polygon) noexcept {
+			bool inside{ false };
+			for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+				if ((polygon[i].y > point.y) != (polygon[j].y > point.y) && point.x < (polygon[j].x - polygon[i].x) * (point.y - polygon[i].y) / (polygon[j].y - polygon[i].y) + polygon[i].x) inside = !inside;
+			}
+			return inside;
+		}
+
+		/// <summary>
+		/// Meshes a plate from its contours in the (x, y) plane, extruded over its thickness along z. Holes run through the plate.
+		/// </summary>
+		void meshPlate(std::vector<std::vector<glm::vec2>> contours, float thickness, const std::vector<Hole>& holes, MeshBuilder& mesh, size_t& cutHoles) {
+			// The outer contour counterclockwise and the inner contours clockwise, so the edge normals point out of the plate
+			for (size_t c = 0; c < contours.size(); ++c) {
+				std::vector<uint32_t> order(contours[c].size());
+				std::iota(order.begin(), order.end(), 0u);
+				if ((signedArea(contours[c], order) < 0.f) == (c == 0)) std::reverse(contours[c].begin(), contours[c].end());
+			}
+
+			const auto fits = [&contours](const glm::vec2& center, float radius) {
+				if (!insidePolygon(center, contours.front())) return false;
+				for (size_t c = 1; c < contours.size(); ++c) {
+					if (insidePolygon(center, contours[c])) return false;
+				}
+				for (const auto& contour : contours) {
+					for (size_t i = 0; i < contour.size(); ++i) {
+						if (distanceToSegment(center, contour[i], contour[(i + 1) % contour.size()]) <= radius + EPSILON) return false;
+					}
+				}
+				return true;
+			};
+
+			std::vector<glm::vec2> points{};
+			std::vector<std::vector<uint32_t>> loops{};
+			for (const auto& contour : contours) {
+				auto& loop = loops.emplace_back(contour.size());
+				std::iota(loop.begin(), loop.end(), static_cast<uint32_t>(points.size()));
+				points.insert(points.end(), contour.begin(), contour.end());
+			}
+
+			std::vector<Cut> cuts{};
+			for (const Hole& hole : holes) {
+				const float radius = hole.diameter / 2.f;
+				const glm::vec2 center{ hole.x, hole.y };
+				if (radius <= EPSILON || (hole.face != 'v' && hole.face != 'h')) _UNLIKELY continue;
+				if (!fits(center, radius)) continue;
+				if (std::any_of(cuts.begin(), cuts.end(), [&](const Cut& cut) { return glm::distance(cut.center, center) <= cut.radius + radius + EPSILON; })) continue;
+
+				const glm::vec3 front{ center, 0.f };
+				const glm::vec3 back{ center, thickness };
+				const Cut& cut = cuts.emplace_back(Cut{ center, radius, makeCircle(front, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, radius) });
+				mesh.addHoleWall(cut.circle, makeCircle(back, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, radius), front, back);
+				++cutHoles;
+
+				auto& loop = loops.emplace_back();
+				for (const glm::vec3& position : cut.circle) {
+					loop.push_back(static_cast<uint32_t>(points.size()));
+					points.emplace_back(position);
+				}
+			}
+
+			// Both faces share one triangulation
+			const auto triangles = triangulate(points, loops);
+			for (const float z : { 0.f, thickness }) {
+				const glm::vec3 normal{ 0.f, 0.f, z == 0.f ? -1.f : 1.f };
+				const uint32_t base = static_cast<uint32_t>(mesh.vertices.size());
+				for (const glm::vec2& point : points) mesh.add({ point, z }, normal);
+				for (size_t t = 0; t < triangles.size(); t += 3) mesh.addTriangle(base + triangles[t], base + triangles[t + 1], base + triangles[t + 2]);
+			}
+
+			for (const auto& contour : contours) {
+				for (size_t i = 0; i < contour.size(); ++i) {
+					const glm::vec2& p0 = contour[i];
+					const glm::vec2& p1 = contour[(i + 1) % contour.size()];
+					const glm::vec2 direction = p1 - p0;
+					if (glm::dot(direction, direction) <= EPSILON * EPSILON) _UNLIKELY continue;
+
+					const glm::vec3 normal = glm::normalize(glm::vec3{ direction.y, -direction.x, 0.f });
+					mesh.addQuad(mesh.add({ p0, 0.f }, normal), mesh.add({ p1, 0.f }, normal), mesh.add({ p1, thickness }, normal), mesh.add({ p0, thickness }, normal));
+				}
+			}
+		}
+
+		_NODISCARD inline bool isSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+
+		_NODISCARD std::string_view trim(std::string_view text) noexcept {
+			while (!text.empty() && isSpace(text.front())) text.remove_prefix(1);
+			while (!text.empty() && isSpace(text.back())) text.remove_suffix(1);
+			return text;
+		}
+
+		_NODISCARD std::vector<std::string_view> split(std::string_view line) {
+			std::vector<std::string_view> tokens{};
+			for (size_t i = 0; i < line.size();) {
+				while (i < line.size() && isSpace(line[i])) ++i;
+				const size_t begin = i;
+				while (i < line.size() && !isSpace(line[i])) ++i;
+				if (i > begin) tokens.push_back(line.substr(begin, i - begin));
+			}
+			return tokens;
+		}
+
+		class Reader final {
+		public:
+			explicit Reader(const std::string& filepath) : filepath{ filepath } {}
+
+			void read() {
+				std::ifstream file{ filepath };
+				if (!file) _UNLIKELY throw std::runtime_error("failed to open file: " + filepath);
+
+				std::string block{};
+				std::string text{};
+				while (std::getline(file, text)) {
+					++lineNumber;
+					const std::string_view line{ text };
+
+					// Comments start at the beginning of a line
+					if (line.starts_with("**")) continue;
+					if (trim(line).empty()) {
+						// The ST block is positional, a text field the exporter left blank is still a field and keeps the sizes after it in place
+						if (block == "ST") header.emplace_back();
+						continue;
+					}
+
+					// Block identifiers start in the first column, the data of a block is indented
+					if (!isSpace(line.front())) {
+						block = std::string{ trim(line) };
+						if (block == "EN") break;
+						if (block == "AK" || block == "IK") contours.push_back({ 'v', block == "AK", {} });
+						continue;
+					}
+
+					if (block == "ST") header.emplace_back(trim(line));
+					else if (block == "BO") readHole(line);
+					else if (block == "AK" || block == "IK") readContourPoint(line);
+				}
+
+				if (header.size() < HEADER_FIELDS) _UNLIKELY throw std::runtime_error(filepath + ": the ST block has " + std::to_string(header.size()) + " fields, expected at least " + std::to_string(HEADER_FIELDS));
+			}
+
+			_NODISCARD float headerNumber(size_t field) const { return parseNumber(header[field]); }
+
+			const std::string& filepath;
+			std::vector<std::string> header{};
+			std::vector<Hole> holes{};
+			std::vector<Contour> contours{};
+
+		private:
+			// Coordinates can carry a reference letter (s, o, u, ...), it is ignored
+			_NODISCARD float parseNumber(std::string_view token) const {
+				while (!token.empty() && std::isalpha(static_cast<unsigned char>(token.back()))) token.remove_suffix(1);
+
+				float value{ 0.f };
+				const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+				if (token.empty() || error != std::errc{} || end != token.data() + token.size()) _UNLIKELY throw std::runtime_error(filepath + ":" + std::to_string(lineNumber) + ": invalid number '" + std::string{ token } + "'");
+				return value;
+			}
+
+			// Lines of a block start with the face, following lines may leave it out
+			_NODISCARD std::vector<std::string_view> readFace(std::string_view line) {
+				auto tokens = split(line);
+				if (!tokens.empty() && tokens.front().size() == 1 && std::string_view{ "vohu" }.find(tokens.front().front()) != std::string_view::npos) {
+					face = tokens.front().front();
+					tokens.erase(tokens.begin());
+				}
+				return tokens;
+			}
+
+			void readHole(std::string_view line) {
+				const auto tokens = readFace(line);
+				if (tokens.size() < 3) _UNLIKELY throw std::runtime_error(filepath + ":" + std::to_string(lineNumber) + ": hole without position and diameter");
+				holes.push_back({ face, parseNumber(tokens[0]), parseNumber(tokens[1]), parseNumber(tokens[2]) });
+			}
+
+			void readContourPoint(std::string_view line) {
+				const auto tokens = readFace(line);
+				if (tokens.size() < 2) _UNLIKELY throw std::runtime_error(filepath + ":" + std::to_string(lineNumber) + ": contour point without position");
+
+				Contour& contour = contours.back();
+				if (contour.points.empty()) contour.face = face;
+				contour.points.push_back({ parseNumber(tokens[0]), parseNumber(tokens[1]) });
+			}
+
+			char face{ 'v' };
+			size_t lineNumber{ 0 };
+		};
+	}
+
+	bool SteelSightDstv::isDstv(const std::string& filepath) {
+		std::string extension = std::filesystem::path{ filepath }.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".nc1" || extension == ".nc";
+	}
+
+	std::shared_ptr<const SteelSightDstv::Section> SteelSightDstv::getSection(const Profile& profile, bool* shared) {
+		static std::mutex mutex{};
+		static ankerl::unordered_dense::map<Profile, std::shared_ptr<const Section>, ProfileHash> sections{};
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (auto it = sections.find(profile); it != sections.end()) {
+			if (shared) *shared = true;
+			return it->second;
+		}
+
+		if (shared) *shared = false;
+		return sections.emplace(profile, buildSection(profile)).first->second;
+	}
+
+	SteelSightDstv::Result SteelSightDstv::load(const std::string& filepath) {
+		Reader reader{ filepath };
+		reader.read();
+
+		Result result{};
+		result.profileName = reader.header[6];
+		result.profile.code = reader.header[7];
+		result.length = reader.headerNumber(8);
+		result.profile.height = reader.headerNumber(9);
+		result.profile.flangeWidth = reader.headerNumber(10);
+		result.profile.flangeThickness = reader.headerNumber(11);
+		result.profile.webThickness = reader.headerNumber(12);
+		result.profile.radius = reader.headerNumber(13);
+		result.holeCount = reader.holes.size();
+
+		if (result.length <= 0.f || result.profile.height <= 0.f) _UNLIKELY throw std::runtime_error(filepath + ": piece without length or profile height");
+
+		MeshBuilder mesh{};
+		if (result.profile.code == "B") {
+			// The outer contour of the front face is the shape of the plate, without one the plate is a rectangle
+			std::vector<std::vector<glm::vec2>> contours{ { { 0.f, 0.f }, { result.length, 0.f }, { result.length, result.profile.height }, { 0.f, result.profile.height } } };
+			for (auto& contour : reader.contours) {
+				// Contours repeat their first point at the end
+				if (contour.points.size() > 1 && glm::distance(contour.points.front(), contour.points.back()) <= EPSILON) contour.points.pop_back();
+				if (contour.face != 'v' || contour.points.size() < 3) continue;
+
+				if (contour.outer) contours.front() = std::move(contour.points);
+				else contours.push_back(std::move(contour.points));
+			}
+
+			const float thickness = result.profile.webThickness > 0.f ? result.profile.webThickness : result.profile.flangeThickness;
+			if (thickness <= 0.f) _UNLIKELY throw std::runtime_error(filepath + ": plate without thickness");
+			meshPlate(std::move(contours), thickness, reader.holes, mesh, result.cutHoles);
+		}
+		else {
+			const auto section = getSection(result.profile, &result.sectionShared);
+			meshBeam(*section, getPlates(result.profile), result.length, reader.holes, mesh, result.cutHoles);
+		}
+
+		result.vertices = std::move(mesh.vertices);
+		result.indices = std::move(mesh.indices);
+		return result;
+	}
+
+	SteelSightDstv::Result SteelSightDstv::meshProfile(const Profile& profile) {
+		Result result{};
+		result.profile = profile;
+		result.length = 1.f;
+
+		MeshBuilder mesh{};
+		meshBeam(*getSection(profile, &result.sectionShared), getPlates(profile), result.length, {}, mesh, result.cutHoles);
+
+		result.vertices = std::move(mesh.vertices);
+		result.indices = std::move(mesh.indices);
+		return result;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// DSTV NC1 import. Reads the profile from the ST header and the BO (holes) and AK/IK (contours) blocks and meshes the beam procedurally:
+	/// the cross-section of the profile is extruded over the length of the beam and the holes are cut out of the flat faces of the web and flanges.
+	/// Plates (profile code B) are meshed from their outer contour and inner contours instead, holes go through the plate.
+	/// End cuts and the contours of profiles other than plates are not meshed, the beam ends square at its length.
+	/// All dimensions are in millimeters with x along the beam, y up and z across the profile.
+	/// </summary>
+	class SteelSightDstv final {
+	public:
+		// Cross-section dimensions from the header of an NC1 file
+		struct Profile final {
+			// DSTV profile code: I, U, C, L, T, B, M, RO or RU, other codes are meshed as a box
+			std::string code{};
+			float height{ 0.f };
+			float flangeWidth{ 0.f };
+			float flangeThickness{ 0.f };
+			float webThickness{ 0.f };
+			float radius{ 0.f };
+
+			_NODISCARD inline bool operator==(const Profile& other) const noexcept = default;
+		};
+
+		// Outline of a profile in the (z, y) plane, extruded along x
+		struct Section final {
+			// The counterclockwise outer loop, followed by the clockwise inner loop of hollow profiles
+			std::vector<std::vector<glm::vec2>> loops{};
+
+			// Points where the surface continues smoothly (fillets, tubes), the normals of the side faces are averaged there
+			std::vector<std::vector<bool>> smooth{};
+
+			// Triangles of an end cap, indices into the concatenated loops
+			std::vector<uint32_t> capIndices{};
+		};
+
+		struct Result final {
+			std::vector<SteelSightModel::Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+
+			// Profile name from the header, for example IPE200
+			std::string profileName{};
+			Profile profile{};
+			float length{ 0.f };
+
+			// Holes in the file and holes cut into the mesh, holes that cross an edge or a fillet of the profile are left out
+			size_t holeCount{ 0 };
+			size_t cutHoles{ 0 };
+
+			// The section was already built by an earlier beam with the same profile
+			bool sectionShared{ false };
+		};
+
+		// Decided by the extension (.nc1 or .nc), loadModel reads every other file as OBJ
+		_NODISCARD static bool isDstv(const std::string& filepath);
+
+		/// <summary>
+		/// Reads an NC1 file and meshes the piece it describes.
+		/// </summary>
+		/// <param name="filepath">Path of the NC1 file</param>
+		/// <returns>The indexed triangles of the beam with flat normals on the faces and smooth normals on fillets and tubes</returns>
+		_NODISCARD static Result load(const std::string& filepath);
+
+		/// <summary>
+		/// Meshes a beam of length 1 without holes. SteelSightBeamSystem uploads it once per profile and its vertex shader stretches it to the length of every beam,
+		/// the normals of the side faces are perpendicular to x and the caps face along x, so the stretch leaves them correct.
+		/// </summary>
+		/// <param name="profile">Dimensions of the profile</param>
+		/// <returns>The indexed triangles of the unit beam</returns>
+		_NODISCARD static Result meshProfile(const Profile& profile);
+
+		/// <summary>
+		/// Returns the cross-section of a profile. Every distinct profile is built and triangulated once and shared by every beam that uses it, thread safe.
+		/// </summary>
+		/// <param name="profile">Dimensions of the profile</param>
+		/// <param name="shared">Receives whether the section was built before</param>
+		/// <returns>The shared section</returns>
+		_NODISCARD static std::shared_ptr<const Section> getSection(const Profile& profile, bool* shared = nullptr);
+	};
+}
@@ -0,0 +1,140 @@
+#include "SteelSightFileWatcher.hpp"
+
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Voortman {
+	SteelSightFileWatcher::SteelSightFileWatcher() {
+#ifdef __linux__
+		inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+		// Without inotify the watcher falls back to comparing the files
+		if (inotify < 0) _UNLIKELY std::cerr << "inotify unavailable, polling watched files: " << std::strerror(errno) << std::endl;
+#endif
+	}
+
+	SteelSightFileWatcher::~SteelSightFileWatcher() {
+#ifdef __linux__
+		if (inotify >= 0) _LIKELY close(inotify);
+#endif
+	}
+
+	std::string SteelSightFileWatcher::normalize(const std::string& filepath) {
+		std::error_code error{};
+		const std::filesystem::path absolute = std::filesystem::absolute(filepath, error);
+		return (error ? std::filesystem::path{ filepath } : absolute).lexically_normal().string();
+	}
+
+	void SteelSightFileWatcher::stat(WatchedFile& file) noexcept {
+		std::error_code error{};
+		file.writeTime = std::filesystem::last_write_time(file.path, error);
+		if (error) file.writeTime = {};
+
+		file.fileSize = std::filesystem::file_size(file.path, error);
+		if (error) file.fileSize = 0;
+	}
+
+	void SteelSightFileWatcher::watch(const std::string& filepath) {
+		const std::string key = normalize(filepath);
+		auto [it, inserted] = files.try_emplace(key);
+		if (!inserted) return;
+
+		it->second.path = filepath;
+		stat(it->second);
+
+#ifdef __linux__
+		if (inotify < 0) _UNLIKELY return;
+
+		const std::string directory = std::filesystem::path{ key }.parent_path().string();
+		if (directoryWatches.contains(directory)) return;
+
+		// Exporters often write a temporary file and rename it, so the directory is watched instead of the file
+		const int watch = inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watch < 0) _UNLIKELY {
+			std::cerr << "Failed to watch " << directory << ": " << std::strerror(errno) << std::endl;
+			return;
+		}
+
+		directories[watch] = directory;
+		directoryWatches[directory] = watch;
+#endif
+	}
+
+	void SteelSightFileWatcher::unwatch(const std::string& filepath) {
+		const std::string key = normalize(filepath);
+		if (files.erase(key) == 0) return;
+
+#ifdef __linux__
+		const std::string directory = std::filesystem::path{ key }.parent_path().string();
+		for (const auto& [other, file] : files) {
+			if (std::filesystem::path{ other }.parent_path().string() == directory) return;
+		}
+
+		if (const auto it = directoryWatches.find(directory); it != directoryWatches.end()) {
+			inotify_rm_watch(inotify, it->second);
+			directories.erase(it->second);
+			directoryWatches.erase(it);
+		}
+#endif
+	}
+
+	std::vector<std::string> SteelSightFileWatcher::poll() {
+		std::vector<std::string> changed{};
+
+#ifdef __linux__
+		if (inotify >= 0) _LIKELY {
+			ankerl::unordered_dense::set<std::string> seen{};
+
+			// Events are variable length, the buffer is aligned for the header of the first one
+			alignas(inotify_event) char buffer[4096];
+			while (true) {
+				const ssize_t length = read(inotify, buffer, sizeof(buffer));
+				if (length <= 0) break;
+
+				for (ssize_t offset = 0; offset < length;) {
+					const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+					offset += sizeof(inotify_event) + event->len;
+
+					const auto directory = directories.find(event->wd);
+					if (directory == directories.end() || event->len == 0) continue;
+
+					const std::string key = (std::filesystem::path{ directory->second } / event->name).string();
+					const auto file = files.find(key);
+					if (file == files.end() || !seen.insert(key).second) continue;
+
+					stat(file->second);
+					changed.push_back(file->second.path);
+				}
+			}
+
+			return changed;
+		}
+#endif
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - lastPoll < POLL_INTERVAL) _LIKELY return changed;
+		lastPoll = now;
+
+		for (auto& [key, file] : files) {
+			const auto writeTime = file.writeTime;
+			const auto fileSize = file.fileSize;
+			stat(file);
+
+			if (file.writeTime != writeTime || file.fileSize != fileSize) {
+				file.settling = true;
+			}
+			else if (file.settling) {
+				file.settling = false;
+				changed.push_back(file.path);
+			}
+		}
+
+		return changed;
+	}
+}
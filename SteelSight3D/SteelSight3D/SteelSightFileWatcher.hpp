@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include "unordered_dense.h"
+
+namespace Voortman {
+	/// <summary>
+	/// Reports files that were written since the last poll. On Linux the parent directories are watched with inotify, a file counts as written once the writer closed it
+	/// or once it was renamed over the watched path, which is how most exporters save. Other platforms compare the write time and size of every watched file
+	/// every POLL_INTERVAL and report a change once the file stayed the same for one interval, so a file that is still being written is not reported halfway.
+	/// Only used on the render thread.
+	/// </summary>
+	class SteelSightFileWatcher final {
+	public:
+		static constexpr std::chrono::milliseconds POLL_INTERVAL{ 500 };
+
+		SteelSightFileWatcher();
+		~SteelSightFileWatcher();
+
+		SteelSightFileWatcher(const SteelSightFileWatcher&) = delete;
+		SteelSightFileWatcher& operator=(const SteelSightFileWatcher&) = delete;
+
+		// Watching a file that is already watched does nothing, a file that does not exist yet is reported once it is written
+		void watch(const std::string& filepath);
+		void unwatch(const std::string& filepath);
+
+		/// <summary>
+		/// Collects the changes since the last call, does not block.
+		/// </summary>
+		/// <returns>Every changed file once, as the path that was passed to watch</returns>
+		_NODISCARD std::vector<std::string> poll();
+
+		_NODISCARD inline size_t size() const noexcept { return files.size(); }
+
+	private:
+		struct WatchedFile final {
+			std::string path{};
+			std::filesystem::file_time_type writeTime{};
+			uintmax_t fileSize{ 0 };
+			// Changed in the last interval, reported once it stays the same for another one
+			bool settling{ false };
+		};
+
+		// Absolute normal form of a path, so different spellings of a file find the same entry
+		_NODISCARD static std::string normalize(const std::string& filepath);
+		static void stat(WatchedFile& file) noexcept;
+
+		ankerl::unordered_dense::map<std::string, WatchedFile> files{};
+		std::chrono::steady_clock::time_point lastPoll{};
+
+#ifdef __linux__
+		int inotify{ -1 };
+		// Watch descriptor of every watched directory and the other way around
+		ankerl::unordered_dense::map<int, std::string> directories{};
+		ankerl::unordered_dense::map<std::string, int> directoryWatches{};
+#endif
+	};
+}
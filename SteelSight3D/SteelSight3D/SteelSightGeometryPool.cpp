@@ -0,0 +1,108 @@
+#include "SteelSightGeometryPool.hpp"
+#include "SteelSightDevice.hpp"
+#include "SteelSightUploadBatch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+namespace Voortman {
+	SteelSightGeometryPool::SteelSightGeometryPool(SteelSightDevice& device) : SSDevice{ device } {
+		vertexArena.name = "vertex";
+		vertexArena.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		vertexArena.pageSize = VERTEX_PAGE_SIZE;
+
+		indexArena.name = "index";
+		indexArena.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		indexArena.pageSize = INDEX_PAGE_SIZE;
+	}
+
+	SteelSightGeometryPool::~SteelSightGeometryPool() {
+		// The models, and with them their ranges, are destroyed before the device
+		for (Arena* arena : { &vertexArena, &indexArena }) {
+			for (auto& page : arena->pages) destroyPage(*page);
+		}
+	}
+
+	std::shared_ptr<SteelSightGeometryRange> SteelSightGeometryPool::allocateVertices(uint32_t stride, uint32_t count) {
+		// A range starts at a multiple of the stride, so its first vertex is the byte offset divided by the stride
+		return allocate(vertexArena, static_cast<VkDeviceSize>(stride) * count, stride);
+	}
+
+	std::shared_ptr<SteelSightGeometryRange> SteelSightGeometryPool::allocateIndices(uint32_t count) {
+		return allocate(indexArena, sizeof(uint32_t) * static_cast<VkDeviceSize>(count), sizeof(uint32_t));
+	}
+
+	std::shared_ptr<SteelSightGeometryRange> SteelSightGeometryPool::allocate(Arena& arena, VkDeviceSize size, VkDeviceSize alignment) {
+		if (size == 0) _UNLIKELY throw std::runtime_error("empty geometry range!");
+
+		std::lock_guard lock{ poolMutex };
+
+		for (auto& page : arena.pages) {
+			if (const auto offset = page->ranges.allocate(size, alignment)) _LIKELY {
+				return std::shared_ptr<SteelSightGeometryRange>(new SteelSightGeometryRange{ *this, arena, *page, *offset, size });
+			}
+		}
+
+		// Nothing fits, a model larger than a page gets a page of exactly its size
+		auto page = std::make_unique<Page>(std::max(size, arena.pageSize));
+		SSDevice.createBuffer(page->ranges.getCapacity(), arena.usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, page->buffer, page->allocation, true);
+
+		const auto offset = page->ranges.allocate(size, alignment);
+		auto range = std::shared_ptr<SteelSightGeometryRange>(new SteelSightGeometryRange{ *this, arena, *page, *offset, size });
+		arena.pages.push_back(std::move(page));
+
+		// Every page after the first costs a bind whenever the draws move from one page to another
+		if (arena.pages.size() > 1) _UNLIKELY std::cout << "Geometry pool: added " << arena.name << " page " << arena.pages.size() << " of " << arena.pages.back()->ranges.getCapacity() / (1024 * 1024) << " MB" << std::endl;
+		return range;
+	}
+
+	void SteelSightGeometryPool::free(const SteelSightGeometryRange& range) noexcept {
+		std::lock_guard lock{ poolMutex };
+
+		Page& page = range.page;
+		page.ranges.free(range.offset, range.size);
+		if (!page.ranges.empty() || &page == range.arena.pages.front().get()) _LIKELY return;
+
+		// The first page stays for the next model, a page that was added when it was full goes as soon as nothing uses it
+		auto& pages = range.arena.pages;
+		const auto it = std::find_if(pages.begin(), pages.end(), [&](const auto& candidate) { return candidate.get() == &page; });
+		destroyPage(page);
+		pages.erase(it);
+	}
+
+	void SteelSightGeometryPool::destroyPage(Page& page) noexcept {
+		SSDevice.destroyBuffer(page.buffer, page.allocation);
+		page.buffer = VK_NULL_HANDLE;
+		page.allocation = VK_NULL_HANDLE;
+	}
+
+	void SteelSightGeometryPool::printStatistics() const {
+		std::lock_guard lock{ poolMutex };
+
+		for (const Arena* arena : { &vertexArena, &indexArena }) {
+			VkDeviceSize used{ 0 }, capacity{ 0 }, largestFree{ 0 };
+			size_t freeRanges{ 0 };
+			for (const auto& page : arena->pages) {
+				used += page->ranges.getUsed();
+				capacity += page->ranges.getCapacity();
+				largestFree = std::max(largestFree, page->ranges.getLargestFreeRange());
+				freeRanges += page->ranges.getFreeRangeCount();
+			}
+
+			std::cout << "Geometry pool " << arena->name << " buffer: " << used / 1024 << " of " << capacity / 1024 << " KB used in " << arena->pages.size() << " pages, "
+				<< freeRanges << " free ranges, largest " << largestFree / 1024 << " KB" << std::endl;
+		}
+	}
+
+	SteelSightGeometryRange::~SteelSightGeometryRange() {
+		pool.free(*this);
+	}
+
+	void SteelSightGeometryRange::upload(SteelSightUploadBatch& batch, const void* data, VkDeviceSize bytes, VkDeviceSize rangeOffset) const {
+		if (rangeOffset + bytes > size) _UNLIKELY throw std::out_of_range("upload outside of the geometry range");
+
+		// The pages are shared by both queue families, the copy is made visible by the upload semaphore alone
+		batch.copyToBuffer(buffer, data, bytes, offset + rangeOffset, true);
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "SteelSightRangeAllocator.hpp"
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+
+namespace Voortman {
+	class SteelSightDevice;
+	class SteelSightUploadBatch;
+	class SteelSightGeometryRange;
+
+	// The pool pages bound to a command buffer, draws from pages that are already bound skip the bind
+	struct SteelSightGeometryBinding final {
+		VkBuffer vertexBuffer{ VK_NULL_HANDLE };
+		VkBuffer indexBuffer{ VK_NULL_HANDLE };
+	};
+
+	/// <summary>
+	/// One large vertex buffer and one large index buffer that the geometry of every model is sub-allocated from, instead of two buffers per model.
+	/// A model is a range of vertices and a range of indices, its draws add the first index of its range and pass the first vertex as vertex offset.
+	/// All vertex formats share the vertex buffer, a range starts at a multiple of its stride. So every model of a frame is drawn after a single bind of both
+	/// buffers, the prerequisite for merging the draws into multi-draw or indirect draws.
+	/// A model larger than a page, or one that fits no page anymore, gets a page of its own, a page other than the first is destroyed once it is empty.
+	/// The pages are shared by the graphics and the transfer queue family, so an upload to one range needs no ownership transfer of the buffer the frames draw from.
+	/// Safe to use from the loader threads.
+	/// </summary>
+	class SteelSightGeometryPool final {
+	public:
+		static constexpr VkDeviceSize VERTEX_PAGE_SIZE{ 128ull << 20 };
+		static constexpr VkDeviceSize INDEX_PAGE_SIZE{ 64ull << 20 };
+
+		explicit SteelSightGeometryPool(SteelSightDevice& device);
+		~SteelSightGeometryPool();
+
+		SteelSightGeometryPool(const SteelSightGeometryPool&) = delete;
+		SteelSightGeometryPool& operator=(const SteelSightGeometryPool&) = delete;
+
+		// Range of count vertices of stride bytes, its first element is the vertex offset of the draws
+		_NODISCARD std::shared_ptr<SteelSightGeometryRange> allocateVertices(uint32_t stride, uint32_t count);
+
+		// Range of count 32 bit indices, its first element is added to the first index of the draws
+		_NODISCARD std::shared_ptr<SteelSightGeometryRange> allocateIndices(uint32_t count);
+
+		void printStatistics() const;
+
+	private:
+		friend class SteelSightGeometryRange;
+
+		struct Page final {
+			Page(VkDeviceSize capacity) : ranges{ capacity } {}
+
+			VkBuffer buffer{ VK_NULL_HANDLE };
+			VmaAllocation allocation{ VK_NULL_HANDLE };
+			SteelSightRangeAllocator ranges;
+		};
+
+		struct Arena final {
+			const char* name{ nullptr };
+			VkBufferUsageFlags usage{ 0 };
+			VkDeviceSize pageSize{ 0 };
+			std::vector<std::unique_ptr<Page>> pages{};
+		};
+
+		std::shared_ptr<SteelSightGeometryRange> allocate(Arena& arena, VkDeviceSize size, VkDeviceSize alignment);
+		void free(const SteelSightGeometryRange& range) noexcept;
+		void destroyPage(Page& page) noexcept;
+
+		SteelSightDevice& SSDevice;
+
+		mutable std::mutex poolMutex{};
+		Arena vertexArena{};
+		Arena indexArena{};
+	};
+
+	/// <summary>
+	/// The vertices or indices of one model in a page of the geometry pool. Shared by the models of a reload whose content did not change,
+	/// the range goes back to the pool when the last of them is destroyed.
+	/// </summary>
+	class SteelSightGeometryRange final {
+	public:
+		~SteelSightGeometryRange();
+
+		SteelSightGeometryRange(const SteelSightGeometryRange&) = delete;
+		SteelSightGeometryRange& operator=(const SteelSightGeometryRange&) = delete;
+
+		_NODISCARD inline VkBuffer getBuffer() const noexcept { return buffer; }
+		_NODISCARD inline VkDeviceSize getOffset() const noexcept { return offset; }
+		_NODISCARD inline VkDeviceSize getSize() const noexcept { return size; }
+
+		// Index of the first element of the range in its page, the offset is a multiple of the element size
+		_NODISCARD inline uint32_t getFirstElement(VkDeviceSize elementSize) const noexcept { return static_cast<uint32_t>(offset / elementSize); }
+
+		/// <summary>
+		/// Records a copy of data into the range.
+		/// </summary>
+		/// <param name="batch">The batch to record into</param>
+		/// <param name="data">Data to copy, copied into the staging ring before the call returns</param>
+		/// <param name="bytes">Bytes to copy</param>
+		/// <param name="rangeOffset">Where the data goes, relative to the start of the range</param>
+		void upload(SteelSightUploadBatch& batch, const void* data, VkDeviceSize bytes, VkDeviceSize rangeOffset = 0) const;
+
+	private:
+		friend class SteelSightGeometryPool;
+
+		SteelSightGeometryRange(SteelSightGeometryPool& pool, SteelSightGeometryPool::Arena& arena, SteelSightGeometryPool::Page& page, VkDeviceSize offset, VkDeviceSize size)
+			: pool{ pool }, arena{ arena }, page{ page }, buffer{ page.buffer }, offset{ offset }, size{ size } {}
+
+		SteelSightGeometryPool& pool;
+		// The pool page the range was taken from and the pages it belongs to
+		SteelSightGeometryPool::Arena& arena;
+		SteelSightGeometryPool::Page& page;
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VkDeviceSize offset{ 0 };
+		VkDeviceSize size{ 0 };
+	};
+}
@@ -0,0 +1,748 @@
+#include "SteelSightGltf.hpp"
+#include "SteelSightMappedFile.hpp"
+#include "unordered_dense.h"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <cstddef>
+#include <cctype>
+#include <cmath>
+#include <tuple>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace Voortman {
+	namespace {
+		using Vertex = SteelSightModel::Vertex;
+
+		// The block copy relies on the layout of the vertex
+		static_assert(sizeof(Vertex) == 32 && offsetof(Vertex, normal) == 12 && offsetof(Vertex, uv) == 24, "Vertex no longer matches the interleaved glTF layout");
+
+		constexpr uint32_t GLB_MAGIC{ 0x46546C67 };
+		constexpr uint32_t GLB_VERSION{ 2 };
+		constexpr uint32_t CHUNK_JSON{ 0x4E4F534A };
+		constexpr uint32_t CHUNK_BIN{ 0x004E4942 };
+
+		constexpr uint32_t COMPONENT_BYTE{ 5120 };
+		constexpr uint32_t COMPONENT_UNSIGNED_BYTE{ 5121 };
+		constexpr uint32_t COMPONENT_SHORT{ 5122 };
+		constexpr uint32_t COMPONENT_UNSIGNED_SHORT{ 5123 };
+		constexpr uint32_t COMPONENT_UNSIGNED_INT{ 5125 };
+		constexpr uint32_t COMPONENT_FLOAT{ 5126 };
+
+		constexpr uint32_t MODE_TRIANGLES{ 4 };
+		constexpr uint32_t NO_ACCESSOR{ UINT32_MAX };
+
+		// Nested arrays and objects deeper than this are rejected instead of overflowing the stack
+		constexpr uint32_t MAX_JSON_DEPTH{ 256 };
+
+		/// <summary>
+		/// Just enough JSON for the glTF header. Objects keep their keys in order, lookups are linear because glTF objects only have a handful of keys.
+		/// </summary>
+		struct Json final {
+			enum class Type : uint8_t { Null, Boolean, Number, String, Array, Object };
+
+			Type type{ Type::Null };
+			bool boolean{ false };
+			double number{ 0.0 };
+			std::string string{};
+
+			// Elements of an array, values of an object
+			std::vector<Json> values{};
+			std::vector<std::string> keys{};
+
+			_NODISCARD const Json& operator[](std::string_view key) const noexcept {
+				for (size_t i = 0; i < keys.size(); ++i) {
+					if (keys[i] == key) return values[i];
+				}
+				return null();
+			}
+
+			_NODISCARD const Json& operator[](size_t index) const noexcept { return type == Type::Array && index < values.size() ? values[index] : null(); }
+
+			_NODISCARD inline bool isNull() const noexcept { return type == Type::Null; }
+			_NODISCARD inline size_t size() const noexcept { return type == Type::Array ? values.size() : 0; }
+
+			_NODISCARD inline double getNumber(double fallback) const noexcept { return type == Type::Number ? number : fallback; }
+
+			// Indices and counts, a missing one is fallback
+			_NODISCARD uint32_t getIndex(uint32_t fallback) const {
+				if (type != Type::Number) return fallback;
+				if (number < 0.0 || number >= static_cast<double>(UINT32_MAX) || number != std::floor(number)) _UNLIKELY throw std::runtime_error("invalid glTF index");
+				return static_cast<uint32_t>(number);
+			}
+
+			static const Json& null() noexcept {
+				static const Json value{};
+				return value;
+			}
+		};
+
+		class JsonParser final {
+		public:
+			explicit JsonParser(std::string_view text) : text{ text } {}
+
+			_NODISCARD Json parse() {
+				Json value = parseValue(0);
+				skipSpace();
+				if (position != text.size()) _UNLIKELY fail();
+				return value;
+			}
+
+		private:
+			void skipSpace() noexcept {
+				while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) ++position;
+			}
+
+			void expect(char c) {
+				skipSpace();
+				if (position >= text.size() || text[position] != c) _UNLIKELY fail();
+				++position;
+			}
+
+			// Consumes c when it is the next character
+			bool accept(char c) {
+				skipSpace();
+				if (position >= text.size() || text[position] != c) return false;
+				++position;
+				return true;
+			}
+
+			Json parseValue(uint32_t depth) {
+				if (depth > MAX_JSON_DEPTH) _UNLIKELY fail();
+
+				skipSpace();
+				if (position >= text.size()) _UNLIKELY fail();
+
+				Json value{};
+				const char c = text[position];
+				if (c == '{') {
+					++position;
+					value.type = Json::Type::Object;
+					if (accept('}')) return value;
+					do {
+						skipSpace();
+						value.keys.push_back(parseString());
+						expect(':');
+						value.values.push_back(parseValue(depth + 1));
+					} while (accept(','));
+					expect('}');
+				}
+				else if (c == '[') {
+					++position;
+					value.type = Json::Type::Array;
+					if (accept(']')) return value;
+					do {
+						value.values.push_back(parseValue(depth + 1));
+					} while (accept(','));
+					expect(']');
+				}
+				else if (c == '"') {
+					value.type = Json::Type::String;
+					value.string = parseString();
+				}
+				else if (text.substr(position, 4) == "true" || text.substr(position, 5) == "false") {
+					value.type = Json::Type::Boolean;
+					value.boolean = c == 't';
+					position += value.boolean ? 4 : 5;
+				}
+				else if (text.substr(position, 4) == "null") {
+					position += 4;
+				}
+				else {
+					value.type = Json::Type::Number;
+					const auto [end, error] = std::from_chars(text.data() + position, text.data() + text.size(), value.number);
+					if (error != std::errc{}) _UNLIKELY fail();
+					position = static_cast<size_t>(end - text.data());
+				}
+				return value;
+			}
+
+			std::string parseString() {
+				if (position >= text.size() || text[position] != '"') _UNLIKELY fail();
+				++position;
+
+				std::string result{};
+				while (position < text.size() && text[position] != '"') {
+					const char c = text[position++];
+					if (c != '\\') _LIKELY {
+						result.push_back(c);
+						continue;
+					}
+
+					if (position >= text.size()) _UNLIKELY fail();
+					switch (const char escaped = text[position++]) {
+					case 'b': result.push_back('\b'); break;
+					case 'f': result.push_back('\f'); break;
+					case 'n': result.push_back('\n'); break;
+					case 'r': result.push_back('\r'); break;
+					case 't': result.push_back('\t'); break;
+					case 'u': appendUtf8(result, parseCodePoint()); break;
+					default: result.push_back(escaped); break;
+					}
+				}
+				if (position >= text.size()) _UNLIKELY fail();
+				++position;
+				return result;
+			}
+
+			uint32_t parseHex() {
+				uint32_t value{ 0 };
+				if (position + 4 > text.size()) _UNLIKELY fail();
+				const auto [end, error] = std::from_chars(text.data() + position, text.data() + position + 4, value, 16);
+				if (error != std::errc{} || end != text.data() + position + 4) _UNLIKELY fail();
+				position += 4;
+				return value;
+			}
+
+			// A code point outside the basic plane is written as a surrogate pair of two escapes
+			uint32_t parseCodePoint() {
+				const uint32_t high = parseHex();
+				if (high < 0xD800 || high > 0xDBFF || text.substr(position, 2) != "\\u") return high;
+
+				position += 2;
+				const uint32_t low = parseHex();
+				return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+			}
+
+			static void appendUtf8(std::string& result, uint32_t codePoint) {
+				if (codePoint < 0x80) {
+					result.push_back(static_cast<char>(codePoint));
+				}
+				else if (codePoint < 0x800) {
+					result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+					result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+				}
+				else if (codePoint < 0x10000) {
+					result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+					result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+					result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+				}
+				else {
+					result.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+					result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+					result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+					result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+				}
+			}
+
+			[[noreturn]] void fail() const {
+				throw std::runtime_error("invalid glTF JSON at offset " + std::to_string(position));
+			}
+
+			std::string_view text;
+			size_t position{ 0 };
+		};
+
+		// A validated accessor, element i starts at data + i * stride
+		struct Accessor final {
+			const std::byte* data{ nullptr };
+			size_t count{ 0 };
+			size_t stride{ 0 };
+			uint32_t bufferView{ 0 };
+			uint32_t componentType{ 0 };
+			uint32_t components{ 0 };
+			bool normalized{ false };
+		};
+
+		_NODISCARD uint32_t getComponentSize(uint32_t componentType) {
+			switch (componentType) {
+			case COMPONENT_BYTE:
+			case COMPONENT_UNSIGNED_BYTE: return 1;
+			case COMPONENT_SHORT:
+			case COMPONENT_UNSIGNED_SHORT: return 2;
+			case COMPONENT_UNSIGNED_INT:
+			case COMPONENT_FLOAT: return 4;
+			default: throw std::runtime_error("unsupported glTF component type " + std::to_string(componentType));
+			}
+		}
+
+		_NODISCARD uint32_t getComponentCount(const std::string& type) {
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			throw std::runtime_error("unsupported glTF accessor type " + type);
+		}
+
+		/// <summary>
+		/// Resolves an accessor to a range of the binary chunk and checks that every element lies inside its buffer view.
+		/// </summary>
+		Accessor getAccessor(const Json& json, std::span<const std::byte> binary, uint32_t index, uint32_t components) {
+			const Json& accessor = json["accessors"][index];
+			if (accessor.isNull()) _UNLIKELY throw std::runtime_error("glTF accessor " + std::to_string(index) + " does not exist");
+			if (!accessor["sparse"].isNull()) _UNLIKELY throw std::runtime_error("sparse glTF accessors are not supported");
+
+			Accessor result{};
+			result.count = accessor["count"].getIndex(0);
+			result.componentType = accessor["componentType"].getIndex(0);
+			result.components = getComponentCount(accessor["type"].string);
+			result.normalized = accessor["normalized"].boolean;
+			result.bufferView = accessor["bufferView"].getIndex(NO_ACCESSOR);
+			if (result.components != components) _UNLIKELY throw std::runtime_error("glTF accessor " + std::to_string(index) + " has the wrong type");
+			if (result.bufferView == NO_ACCESSOR) _UNLIKELY throw std::runtime_error("glTF accessors without a buffer view are not supported");
+
+			const Json& view = json["bufferViews"][result.bufferView];
+			if (view["buffer"].getIndex(0) != 0 || !json["buffers"][0]["uri"].isNull()) _UNLIKELY throw std::runtime_error("external glTF buffers are not supported");
+
+			const size_t elementSize = static_cast<size_t>(getComponentSize(result.componentType)) * result.components;
+			const size_t viewOffset = view["byteOffset"].getIndex(0);
+			const size_t viewLength = view["byteLength"].getIndex(0);
+			const size_t offset = accessor["byteOffset"].getIndex(0);
+			result.stride = view["byteStride"].getIndex(static_cast<uint32_t>(elementSize));
+
+			if (viewOffset > binary.size() || viewLength > binary.size() - viewOffset) _UNLIKELY throw std::runtime_error("glTF buffer view outside of the binary chunk");
+			if (result.count > 0 && (offset > viewLength || (result.count - 1) * result.stride + elementSize > viewLength - offset)) _UNLIKELY {
+				throw std::runtime_error("glTF accessor " + std::to_string(index) + " outside of its buffer view");
+			}
+
+			result.data = binary.data() + viewOffset + offset;
+			return result;
+		}
+
+		_NODISCARD float readComponent(const std::byte* data, uint32_t componentType, bool normalized) noexcept {
+			switch (componentType) {
+			case COMPONENT_FLOAT: {
+				float value{};
+				std::memcpy(&value, data, sizeof(float));
+				return value;
+			}
+			case COMPONENT_UNSIGNED_BYTE: {
+				const uint8_t value = static_cast<uint8_t>(*data);
+				return normalized ? value / 255.f : value;
+			}
+			case COMPONENT_BYTE: {
+				const int8_t value = static_cast<int8_t>(*data);
+				return normalized ? std::max(value / 127.f, -1.f) : value;
+			}
+			case COMPONENT_UNSIGNED_SHORT: {
+				uint16_t value{};
+				std::memcpy(&value, data, sizeof(uint16_t));
+				return normalized ? value / 65535.f : value;
+			}
+			case COMPONENT_SHORT: {
+				int16_t value{};
+				std::memcpy(&value, data, sizeof(int16_t));
+				return normalized ? std::max(value / 32767.f, -1.f) : value;
+			}
+			default: {
+				uint32_t value{};
+				std::memcpy(&value, data, sizeof(uint32_t));
+				return static_cast<float>(value);
+			}
+			}
+		}
+
+		_NODISCARD uint32_t readIndex(const std::byte* data, uint32_t componentType) {
+			switch (componentType) {
+			case COMPONENT_UNSIGNED_BYTE: return static_cast<uint8_t>(*data);
+			case COMPONENT_UNSIGNED_SHORT: {
+				uint16_t value{};
+				std::memcpy(&value, data, sizeof(uint16_t));
+				return value;
+			}
+			case COMPONENT_UNSIGNED_INT: {
+				uint32_t value{};
+				std::memcpy(&value, data, sizeof(uint32_t));
+				return value;
+			}
+			default: throw std::runtime_error("unsupported glTF index component type " + std::to_string(componentType));
+			}
+		}
+
+		// Converts one attribute of every vertex, used when the buffer view does not have the layout of Vertex
+		template <glm::length_t Components>
+		void readAttribute(const Accessor& accessor, std::span<Vertex> vertices, glm::vec<Components, float> Vertex::* attribute) {
+			const uint32_t componentSize = getComponentSize(accessor.componentType);
+			for (size_t i = 0; i < vertices.size(); ++i) {
+				const std::byte* element = accessor.data + i * accessor.stride;
+				auto& value = vertices[i].*attribute;
+				for (glm::length_t c = 0; c < Components; ++c) value[c] = readComponent(element + c * componentSize, accessor.componentType, accessor.normalized);
+			}
+		}
+
+		_NODISCARD glm::mat4 getNodeTransform(const Json& node) {
+			const Json& matrix = node["matrix"];
+			if (matrix.size() == 16) {
+				glm::mat4 transform{};
+				for (glm::length_t i = 0; i < 16; ++i) transform[i / 4][i % 4] = static_cast<float>(matrix[static_cast<size_t>(i)].getNumber(0.0));
+				return transform;
+			}
+
+			const Json& translation = node["translation"];
+			const Json& rotation = node["rotation"];
+			const Json& scale = node["scale"];
+
+			glm::mat4 transform{ 1.f };
+			if (translation.size() == 3) transform = glm::translate(transform, { translation[0].getNumber(0.0), translation[1].getNumber(0.0), translation[2].getNumber(0.0) });
+			if (rotation.size() == 4) {
+				// glTF stores x, y, z, w
+				transform *= glm::mat4_cast(glm::quat{ static_cast<float>(rotation[3].getNumber(1.0)), static_cast<float>(rotation[0].getNumber(0.0)),
+					static_cast<float>(rotation[1].getNumber(0.0)), static_cast<float>(rotation[2].getNumber(0.0)) });
+			}
+			if (scale.size() == 3) transform = glm::scale(transform, { scale[0].getNumber(1.0), scale[1].getNumber(1.0), scale[2].getNumber(1.0) });
+			return transform;
+		}
+
+		struct NodeMesh final {
+			uint32_t mesh{ 0 };
+			glm::mat4 transform{ 1.f };
+		};
+
+		/// <summary>
+		/// Collects every node of the default scene that references a mesh with its transform in model space, depth first in the order of the file.
+		/// A file without scenes uses every node that is no child of another node.
+		/// </summary>
+		std::vector<NodeMesh> collectNodeMeshes(const Json& json) {
+			const Json& nodes = json["nodes"];
+
+			std::vector<uint32_t> roots{};
+			const Json& scene = json["scenes"][json["scene"].getIndex(0)];
+			if (!scene.isNull()) {
+				for (const Json& root : scene["nodes"].values) roots.push_back(root.getIndex(0));
+			}
+			else {
+				std::vector<bool> isChild(nodes.size(), false);
+				for (const Json& node : nodes.values) {
+					for (const Json& child : node["children"].values) {
+						if (const uint32_t index = child.getIndex(0); index < isChild.size()) isChild[index] = true;
+					}
+				}
+				for (uint32_t node = 0; node < nodes.size(); ++node) {
+					if (!isChild[node]) roots.push_back(node);
+				}
+			}
+
+			std::vector<NodeMesh> result{};
+
+			// The depth guards against a node that is its own ancestor
+			std::vector<std::tuple<uint32_t, glm::mat4, size_t>> stack{};
+			for (auto root = roots.rbegin(); root != roots.rend(); ++root) stack.emplace_back(*root, glm::mat4{ 1.f }, 0);
+
+			while (!stack.empty()) {
+				const auto [index, parent, depth] = stack.back();
+				stack.pop_back();
+
+				const Json& node = nodes[index];
+				if (node.isNull() || depth > nodes.size()) _UNLIKELY throw std::runtime_error("invalid glTF node hierarchy");
+
+				const glm::mat4 transform = parent * getNodeTransform(node);
+				if (const uint32_t mesh = node["mesh"].getIndex(NO_ACCESSOR); mesh != NO_ACCESSOR) result.push_back({ mesh, transform });
+
+				const auto& children = node["children"].values;
+				for (auto child = children.rbegin(); child != children.rend(); ++child) stack.emplace_back(child->getIndex(0), transform, depth + 1);
+			}
+
+			return result;
+		}
+
+		// The attribute accessors of a primitive, primitives that share them share their vertices
+		struct AttributeKey final {
+			uint32_t position{ NO_ACCESSOR };
+			uint32_t normal{ NO_ACCESSOR };
+			uint32_t texcoord{ NO_ACCESSOR };
+
+			_NODISCARD inline bool operator==(const AttributeKey& other) const noexcept = default;
+		};
+
+		struct AttributeKeyHash final {
+			using is_avalanching = void;
+			_NODISCARD inline uint64_t operator()(const AttributeKey& key) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(&key, sizeof(AttributeKey)); }
+		};
+
+		/// <summary>
+		/// Appends the vertices of a primitive. When the three attributes are interleaved in one buffer view exactly like Vertex, the whole range is one memcpy.
+		/// </summary>
+		/// <returns>Index of the first appended vertex</returns>
+		uint32_t appendVertices(const Json& json, std::span<const std::byte> binary, const AttributeKey& key, SteelSightGltf::Result& result) {
+			const Accessor positions = getAccessor(json, binary, key.position, 3);
+			const size_t first = result.vertices.size();
+			if (first + positions.count > UINT32_MAX) _UNLIKELY throw std::runtime_error("glTF file has too many vertices");
+
+			result.vertices.resize(first + positions.count);
+			const std::span<Vertex> vertices{ result.vertices.data() + first, positions.count };
+
+			if (key.normal != NO_ACCESSOR && key.texcoord != NO_ACCESSOR) {
+				const Accessor normals = getAccessor(json, binary, key.normal, 3);
+				const Accessor texcoords = getAccessor(json, binary, key.texcoord, 2);
+
+				const bool interleaved = positions.stride == sizeof(Vertex) && normals.bufferView == positions.bufferView && texcoords.bufferView == positions.bufferView
+					&& normals.data == positions.data + offsetof(Vertex, normal) && texcoords.data == positions.data + offsetof(Vertex, uv)
+					&& normals.count == positions.count && texcoords.count == positions.count
+					&& positions.componentType == COMPONENT_FLOAT && normals.componentType == COMPONENT_FLOAT && texcoords.componentType == COMPONENT_FLOAT;
+
+				// The texture coordinate accessor was checked to end inside the buffer view, so the last vertex is complete
+				if (interleaved) _LIKELY {
+					std::memcpy(vertices.data(), positions.data, vertices.size_bytes());
+					result.blockCopiedVertices += vertices.size();
+					return static_cast<uint32_t>(first);
+				}
+
+				readAttribute(normals, vertices, &Vertex::normal);
+				readAttribute(texcoords, vertices, &Vertex::uv);
+			}
+			else {
+				if (key.normal != NO_ACCESSOR) readAttribute(getAccessor(json, binary, key.normal, 3), vertices, &Vertex::normal);
+				if (key.texcoord != NO_ACCESSOR) readAttribute(getAccessor(json, binary, key.texcoord, 2), vertices, &Vertex::uv);
+			}
+
+			readAttribute(positions, vertices, &Vertex::position);
+			return static_cast<uint32_t>(first);
+		}
+
+		// Appends the indices of a primitive offset by its first vertex, a primitive without indices draws its vertices in order
+		void appendIndices(const Json& json, std::span<const std::byte> binary, const Json& primitive, uint32_t firstVertex, uint32_t vertexCount, std::vector<uint32_t>& indices) {
+			const uint32_t accessorIndex = primitive["indices"].getIndex(NO_ACCESSOR);
+			const size_t first = indices.size();
+
+			if (accessorIndex == NO_ACCESSOR) {
+				indices.resize(first + vertexCount);
+				for (uint32_t i = 0; i < vertexCount; ++i) indices[first + i] = firstVertex + i;
+			}
+			else {
+				const Accessor accessor = getAccessor(json, binary, accessorIndex, 1);
+				indices.resize(first + accessor.count);
+
+				if (accessor.componentType == COMPONENT_UNSIGNED_INT && accessor.stride == sizeof(uint32_t)) _LIKELY {
+					std::memcpy(indices.data() + first, accessor.data, accessor.count * sizeof(uint32_t));
+					if (firstVertex != 0) {
+						for (size_t i = first; i < indices.size(); ++i) indices[i] += firstVertex;
+					}
+				}
+				else {
+					for (size_t i = 0; i < accessor.count; ++i) indices[first + i] = firstVertex + readIndex(accessor.data + i * accessor.stride, accessor.componentType);
+				}
+
+				for (size_t i = first; i < indices.size(); ++i) {
+					if (indices[i] - firstVertex >= vertexCount) _UNLIKELY throw std::runtime_error("glTF index out of range");
+				}
+			}
+
+			// A trailing incomplete triangle is dropped
+			indices.resize(first + (indices.size() - first) / 3 * 3);
+		}
+
+		template <typename T>
+		void writeBinary(std::ostream& file, const T& value) {
+			file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+	}
+
+	bool SteelSightGltf::isBinaryGltf(const std::string& filepath) {
+		std::string extension = std::filesystem::path{ filepath }.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".glb";
+	}
+
+	SteelSightGltf::Result SteelSightGltf::load(const std::string& filepath, const glm::vec4& defaultMaterial) {
+		const SteelSightMappedFile file{ filepath };
+
+		struct Header final {
+			uint32_t magic{ 0 };
+			uint32_t version{ 0 };
+			uint32_t length{ 0 };
+		};
+
+		Header header{};
+		if (file.size() < sizeof(Header)) _UNLIKELY throw std::runtime_error("not a binary glTF file: " + filepath);
+		std::memcpy(&header, file.data(), sizeof(Header));
+		if (header.magic != GLB_MAGIC || header.version != GLB_VERSION || header.length > file.size()) _UNLIKELY throw std::runtime_error("not a binary glTF 2.0 file: " + filepath);
+
+		// The JSON chunk comes first, the binary chunk is optional
+		std::string_view text{};
+		std::span<const std::byte> binary{};
+		for (size_t offset = sizeof(Header); offset + 8 <= header.length;) {
+			uint32_t chunk[2]{};
+			std::memcpy(chunk, file.data() + offset, sizeof(chunk));
+			offset += sizeof(chunk);
+			if (chunk[0] > header.length - offset) _UNLIKELY throw std::runtime_error("truncated binary glTF file: " + filepath);
+
+			if (chunk[1] == CHUNK_JSON && text.empty()) text = { reinterpret_cast<const char*>(file.data() + offset), chunk[0] };
+			else if (chunk[1] == CHUNK_BIN && binary.empty()) binary = { file.data() + offset, chunk[0] };
+			offset += chunk[0];
+		}
+		if (text.empty()) _UNLIKELY throw std::runtime_error("binary glTF file without JSON: " + filepath);
+
+		const Json json = JsonParser{ text }.parse();
+
+		Result result{};
+		for (const Json& material : json["materials"].values) {
+			const Json& color = material["pbrMetallicRoughness"]["baseColorFactor"];
+			result.materials.emplace_back(color[0].getNumber(1.0), color[1].getNumber(1.0), color[2].getNumber(1.0), color[3].getNumber(1.0));
+		}
+
+		const uint32_t defaultId = static_cast<uint32_t>(result.materials.size());
+		bool usesDefault{ false };
+
+		// A file with meshes but without nodes still shows every mesh once
+		std::vector<NodeMesh> nodeMeshes = collectNodeMeshes(json);
+		const Json& meshes = json["meshes"];
+		if (json["nodes"].size() == 0) {
+			for (uint32_t mesh = 0; mesh < meshes.size(); ++mesh) nodeMeshes.push_back({ mesh, glm::mat4{ 1.f } });
+		}
+
+		// Only meshes a node uses become parts, in the order of the file
+		constexpr uint32_t NO_PART{ UINT32_MAX };
+		std::vector<uint32_t> meshParts(meshes.size(), NO_PART);
+		for (const auto& nodeMesh : nodeMeshes) {
+			if (nodeMesh.mesh >= meshes.size()) _UNLIKELY throw std::runtime_error("glTF node references mesh " + std::to_string(nodeMesh.mesh) + " which does not exist");
+			meshParts[nodeMesh.mesh] = 0;
+		}
+
+		ankerl::unordered_dense::map<AttributeKey, uint32_t, AttributeKeyHash> sharedVertices{};
+		std::vector<std::pair<glm::vec3, glm::vec3>> partBounds{};
+
+		for (uint32_t mesh = 0; mesh < meshes.size(); ++mesh) {
+			if (meshParts[mesh] == NO_PART) continue;
+			meshParts[mesh] = static_cast<uint32_t>(result.partCorners.size());
+
+			const size_t firstCorner = result.indices.size();
+			for (const Json& primitive : meshes[mesh]["primitives"].values) {
+				// Lines and points of the export are not drawn
+				if (primitive["mode"].getIndex(MODE_TRIANGLES) != MODE_TRIANGLES) continue;
+
+				const Json& attributes = primitive["attributes"];
+				const AttributeKey key{ attributes["POSITION"].getIndex(NO_ACCESSOR), attributes["NORMAL"].getIndex(NO_ACCESSOR), attributes["TEXCOORD_0"].getIndex(NO_ACCESSOR) };
+				if (key.position == NO_ACCESSOR) _UNLIKELY continue;
+
+				auto [it, inserted] = sharedVertices.try_emplace(key, 0);
+				if (inserted) it->second = appendVertices(json, binary, key, result);
+
+				const uint32_t vertexCount = static_cast<uint32_t>(getAccessor(json, binary, key.position, 3).count);
+				appendIndices(json, binary, primitive, it->second, vertexCount, result.indices);
+
+				uint32_t material = primitive["material"].getIndex(NO_ACCESSOR);
+				if (material >= defaultId) {
+					material = defaultId;
+					usesDefault = true;
+				}
+				result.triangleMaterials.resize(result.indices.size() / 3, material);
+			}
+			// A mesh of only lines or points has nothing to draw
+			if (result.indices.size() == firstCorner) _UNLIKELY {
+				meshParts[mesh] = NO_PART;
+				continue;
+			}
+			result.partCorners.push_back(result.indices.size() - firstCorner);
+
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+			for (size_t corner = firstCorner; corner < result.indices.size(); ++corner) {
+				minimum = glm::min(minimum, result.vertices[result.indices[corner]].position);
+				maximum = glm::max(maximum, result.vertices[result.indices[corner]].position);
+			}
+			partBounds.emplace_back(minimum, maximum);
+		}
+
+		if (usesDefault || result.materials.empty()) result.materials.push_back(defaultMaterial);
+
+		for (const auto& nodeMesh : nodeMeshes) {
+			const uint32_t part = meshParts[nodeMesh.mesh];
+			if (part == NO_PART) _UNLIKELY continue;
+			result.instances.push_back({ nodeMesh.transform, part });
+
+			// The corners of the box of the part in model space
+			const auto& [minimum, maximum] = partBounds[part];
+			for (uint32_t corner = 0; corner < 8; ++corner) {
+				const glm::vec3 local{ corner & 1 ? maximum.x : minimum.x, corner & 2 ? maximum.y : minimum.y, corner & 4 ? maximum.z : minimum.z };
+				const glm::vec3 position{ nodeMesh.transform * glm::vec4{ local, 1.f } };
+				result.minimum = glm::min(result.minimum, position);
+				result.maximum = glm::max(result.maximum, position);
+			}
+		}
+
+		return result;
+	}
+
+	void SteelSightGltf::write(const std::string& filepath, const SteelSightModel::Builder& builder) {
+		const auto vertices = builder.getVertices();
+		const auto indices = builder.getIndices();
+		const auto lods = builder.getLods();
+		const auto submeshes = builder.getSubmeshes();
+		const auto parts = builder.getParts();
+		const auto instances = builder.getInstances();
+		const auto materials = builder.getMaterials();
+
+		glm::vec3 minimum{ std::numeric_limits<float>::max() };
+		glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+		for (const auto& vertex : vertices) {
+			minimum = glm::min(minimum, vertex.position);
+			maximum = glm::max(maximum, vertex.position);
+		}
+		if (vertices.empty()) _UNLIKELY minimum = maximum = glm::vec3{ 0.f };
+
+		// 9 significant digits write every float exactly
+		std::ostringstream json{};
+		json << std::setprecision(9);
+
+		json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"SteelSight3D\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+		for (size_t instance = 0; instance < instances.size(); ++instance) json << (instance ? "," : "") << instance;
+		json << "]}],\"nodes\":[";
+		for (size_t instance = 0; instance < instances.size(); ++instance) {
+			const float* matrix = glm::value_ptr(instances[instance].transform);
+			json << (instance ? "," : "") << "{\"mesh\":" << instances[instance].part << ",\"matrix\":[";
+			for (size_t i = 0; i < 16; ++i) json << (i ? "," : "") << matrix[i];
+			json << "]}";
+		}
+
+		// Accessors 0 to 2 are the interleaved attributes, every primitive adds its index range behind them
+		json << "],\"meshes\":[";
+		uint32_t indexAccessor{ 3 };
+		std::ostringstream indexAccessors{};
+		for (size_t part = 0; part < parts.size(); ++part) {
+			const auto& fullDetail = lods[parts[part].firstLod];
+			json << (part ? "," : "") << "{\"primitives\":[";
+			for (uint32_t submesh = fullDetail.firstSubmesh; submesh < fullDetail.firstSubmesh + fullDetail.submeshCount; ++submesh) {
+				json << (submesh != fullDetail.firstSubmesh ? "," : "") << "{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":" << indexAccessor++ << ",\"material\":" << submeshes[submesh].material << "}";
+				indexAccessors << ",{\"bufferView\":1,\"byteOffset\":" << submeshes[submesh].firstIndex * sizeof(uint32_t) << ",\"componentType\":" << COMPONENT_UNSIGNED_INT
+					<< ",\"count\":" << submeshes[submesh].indexCount << ",\"type\":\"SCALAR\"}";
+			}
+			json << "]}";
+		}
+
+		json << "],\"materials\":[";
+		for (size_t material = 0; material < materials.size(); ++material) {
+			const glm::vec4& color = materials[material];
+			json << (material ? "," : "") << "{\"pbrMetallicRoughness\":{\"baseColorFactor\":[" << color.r << "," << color.g << "," << color.b << "," << color.a << "]}}";
+		}
+
+		json << "],\"accessors\":[{\"bufferView\":0,\"byteOffset\":0,\"componentType\":" << COMPONENT_FLOAT << ",\"count\":" << vertices.size() << ",\"type\":\"VEC3\",\"min\":["
+			<< minimum.x << "," << minimum.y << "," << minimum.z << "],\"max\":[" << maximum.x << "," << maximum.y << "," << maximum.z << "]}";
+		json << ",{\"bufferView\":0,\"byteOffset\":" << offsetof(Vertex, normal) << ",\"componentType\":" << COMPONENT_FLOAT << ",\"count\":" << vertices.size() << ",\"type\":\"VEC3\"}";
+		json << ",{\"bufferView\":0,\"byteOffset\":" << offsetof(Vertex, uv) << ",\"componentType\":" << COMPONENT_FLOAT << ",\"count\":" << vertices.size() << ",\"type\":\"VEC2\"}";
+		json << indexAccessors.str();
+
+		const size_t vertexBytes = vertices.size_bytes();
+		const size_t indexBytes = indices.size_bytes();
+		json << "],\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" << vertexBytes << ",\"byteStride\":" << sizeof(Vertex) << ",\"target\":34962}"
+			<< ",{\"buffer\":0,\"byteOffset\":" << vertexBytes << ",\"byteLength\":" << indexBytes << ",\"target\":34963}],\"buffers\":[{\"byteLength\":" << vertexBytes + indexBytes << "}]}";
+
+		// Chunks are padded to 4 bytes, the JSON with spaces
+		std::string text = json.str();
+		text.resize((text.size() + 3) & ~size_t{ 3 }, ' ');
+		const size_t binaryBytes = vertexBytes + indexBytes;
+
+		std::ofstream file{ filepath, std::ios::binary };
+		if (!file.is_open()) _UNLIKELY throw std::runtime_error("failed to write binary glTF file: " + filepath);
+
+		writeBinary(file, GLB_MAGIC);
+		writeBinary(file, GLB_VERSION);
+		writeBinary(file, static_cast<uint32_t>(12 + 8 + text.size() + 8 + binaryBytes));
+		writeBinary(file, static_cast<uint32_t>(text.size()));
+		writeBinary(file, CHUNK_JSON);
+		file.write(text.data(), static_cast<std::streamsize>(text.size()));
+		writeBinary(file, static_cast<uint32_t>(binaryBytes));
+		writeBinary(file, CHUNK_BIN);
+		file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertexBytes));
+		file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indexBytes));
+	}
+}
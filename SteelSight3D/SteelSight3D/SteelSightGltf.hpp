@@ -0,0 +1,57 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Binary glTF 2.0 (.glb) import. The file is memory mapped and the accessor ranges are copied straight out of the binary chunk without parsing any text but the JSON header,
+	/// a vertex buffer view that already has the layout of SteelSightModel::Vertex is copied as one block, other layouts are converted per attribute.
+	/// Every mesh becomes a part and every node that references a mesh an instance of it, the file is already indexed so nothing is welded or detected again.
+	/// Reads triangle primitives with POSITION, NORMAL and TEXCOORD_0 and the base color factor of the materials. External buffers and sparse accessors are not supported.
+	/// </summary>
+	class SteelSightGltf final {
+	public:
+		struct Result final {
+			std::vector<SteelSightModel::Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+
+			// Face corners of every part, the triangles of the parts are consecutive in indices
+			std::vector<size_t> partCorners{};
+			std::vector<SteelSightModel::Instance> instances{};
+
+			// Base color of every material, followed by the default material when a primitive has none
+			std::vector<glm::vec4> materials{};
+			std::vector<uint32_t> triangleMaterials{};
+
+			// Bounding box of every instance in model space
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+
+			// Vertices that were copied as one block because their buffer view had the layout of Vertex
+			size_t blockCopiedVertices{ 0 };
+		};
+
+		// Decided by the extension, loadModel reads every other file as OBJ
+		_NODISCARD static bool isBinaryGltf(const std::string& filepath);
+
+		/// <summary>
+		/// Reads the meshes, nodes and materials of the default scene.
+		/// </summary>
+		/// <param name="filepath">Path of the .glb file</param>
+		/// <param name="defaultMaterial">Color of primitives without a material</param>
+		/// <returns>The indexed triangles of every part and the instances that place them</returns>
+		_NODISCARD static Result load(const std::string& filepath, const glm::vec4& defaultMaterial);
+
+		/// <summary>
+		/// Writes the full detail mesh of a loaded model as .glb: one mesh per part with a primitive per submesh, one node per instance.
+		/// The vertices are one interleaved buffer view with the layout of Vertex, so load copies them as one block.
+		/// </summary>
+		/// <param name="filepath">Path of the .glb file to write</param>
+		/// <param name="builder">The loaded model</param>
+		static void write(const std::string& filepath, const SteelSightModel::Builder& builder);
+	};
+}
@@ -0,0 +1,80 @@
+#include "SteelSightMappedFile.hpp"
+
+#include <stdexcept>
+#include <filesystem>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include "Windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Voortman {
+#ifdef _WIN32
+	SteelSightMappedFile::SteelSightMappedFile(const std::string& filepath) {
+		const std::filesystem::path path{ filepath };
+
+		fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE) _UNLIKELY {
+			fileHandle = nullptr;
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		LARGE_INTEGER size{};
+		GetFileSizeEx(fileHandle, &size);
+		fileSize = static_cast<size_t>(size.QuadPart);
+
+		// Windows can not map an empty file, an empty mapping is simply a nullptr with size 0
+		if (fileSize == 0) _UNLIKELY return;
+
+		mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr) _UNLIKELY {
+			CloseHandle(fileHandle);
+			throw std::runtime_error("failed to map file: " + filepath);
+		}
+
+		mapped = static_cast<const std::byte*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (mapped == nullptr) _UNLIKELY {
+			CloseHandle(mappingHandle);
+			CloseHandle(fileHandle);
+			throw std::runtime_error("failed to map file: " + filepath);
+		}
+	}
+
+	SteelSightMappedFile::~SteelSightMappedFile() {
+		if (mapped) _LIKELY UnmapViewOfFile(mapped);
+		if (mappingHandle) _LIKELY CloseHandle(mappingHandle);
+		if (fileHandle) _LIKELY CloseHandle(fileHandle);
+	}
+#else
+	SteelSightMappedFile::SteelSightMappedFile(const std::string& filepath) {
+		fileDescriptor = open(filepath.c_str(), O_RDONLY);
+		if (fileDescriptor < 0) _UNLIKELY {
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		struct stat status {};
+		fstat(fileDescriptor, &status);
+		fileSize = static_cast<size_t>(status.st_size);
+
+		if (fileSize == 0) _UNLIKELY return;
+
+		void* view = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (view == MAP_FAILED) _UNLIKELY {
+			close(fileDescriptor);
+			throw std::runtime_error("failed to map file: " + filepath);
+		}
+
+		mapped = static_cast<const std::byte*>(view);
+	}
+
+	SteelSightMappedFile::~SteelSightMappedFile() {
+		if (mapped) _LIKELY munmap(const_cast<std::byte*>(mapped), fileSize);
+		if (fileDescriptor >= 0) _LIKELY close(fileDescriptor);
+	}
+#endif
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <span>
+
+namespace Voortman {
+	/// <summary>
+	/// Read only memory mapping of a file. The mapping lives as long as the object, so spans handed out by data() must not outlive it.
+	/// </summary>
+	class SteelSightMappedFile final {
+	public:
+		/// <summary>
+		/// Maps the complete file into memory, throws when the file can not be opened or mapped.
+		/// </summary>
+		/// <param name="filepath">Path of the file to map</param>
+		SteelSightMappedFile(const std::string& filepath);
+		~SteelSightMappedFile();
+
+		SteelSightMappedFile(const SteelSightMappedFile&) = delete;
+		SteelSightMappedFile& operator=(const SteelSightMappedFile&) = delete;
+
+		_NODISCARD inline const std::byte* data() const noexcept { return mapped; }
+		_NODISCARD inline size_t size()           const noexcept { return fileSize; }
+		_NODISCARD inline std::span<const std::byte> bytes() const noexcept { return { mapped, fileSize }; }
+
+	private:
+		const std::byte* mapped{ nullptr };
+		size_t fileSize{ 0 };
+
+#ifdef _WIN32
+		void* fileHandle{ nullptr };
+		void* mappingHandle{ nullptr };
+#else
+		int fileDescriptor{ -1 };
+#endif
+	};
+}
@@ -0,0 +1,74 @@
+#include "SteelSightMaterialTable.hpp"
+
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+namespace Voortman {
+	SteelSightMaterialTable::SteelSightMaterialTable(SteelSightDevice& device) : SSDevice{ device } {
+		for (auto& buffer : buffers) {
+			buffer = std::make_unique<SteelSightBuffer>(
+				SSDevice,
+				sizeof(glm::vec4),
+				MAX_MATERIALS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			buffer->map();
+		}
+		colors.resize(MAX_MATERIALS, glm::vec4{ 0.f });
+
+		const std::array<glm::vec4, 1> fallback{ glm::vec4{ 0.6f, 0.6f, 0.6f, 1.f } };
+		if (add(fallback) != FALLBACK_MATERIAL) _UNLIKELY throw std::logic_error("the fallback material must be the first entry");
+	}
+
+	std::optional<uint32_t> SteelSightMaterialTable::add(std::span<const glm::vec4> newColors) {
+		if (newColors.empty()) _UNLIKELY return FALLBACK_MATERIAL;
+
+		const auto offset = entries.allocate(newColors.size(), 1);
+		if (!offset) _UNLIKELY {
+			std::cerr << "Material table full (" << size() << " of " << MAX_MATERIALS << " in use, largest free range " << entries.getLargestFreeRange() << "), "
+				<< newColors.size() << " materials are drawn with the fallback material" << std::endl;
+			return std::nullopt;
+		}
+
+		const uint32_t base = static_cast<uint32_t>(*offset);
+		std::copy(newColors.begin(), newColors.end(), colors.begin() + base);
+		markDirty(base, base + static_cast<uint32_t>(newColors.size()));
+		return base;
+	}
+
+	void SteelSightMaterialTable::free(uint32_t base, uint32_t count) {
+		if (base == FALLBACK_MATERIAL || count == 0) _UNLIKELY return;
+		if (base + static_cast<uint64_t>(count) > MAX_MATERIALS) _UNLIKELY throw std::out_of_range("material range out of range");
+
+		entries.free(base, count);
+	}
+
+	void SteelSightMaterialTable::setColor(uint32_t index, const glm::vec4& color) {
+		if (index >= MAX_MATERIALS) _UNLIKELY throw std::out_of_range("material index out of range");
+
+		colors[index] = color;
+		markDirty(index, index + 1);
+	}
+
+	void SteelSightMaterialTable::flush(int frameIndex) {
+		DirtyRange& range = dirty[frameIndex];
+		if (range.begin == range.end) _LIKELY return;
+
+		buffers[frameIndex]->writeToBuffer(&colors[range.begin], (range.end - range.begin) * sizeof(glm::vec4), range.begin * sizeof(glm::vec4));
+		range = DirtyRange{};
+	}
+
+	void SteelSightMaterialTable::markDirty(uint32_t begin, uint32_t end) noexcept {
+		for (DirtyRange& range : dirty) {
+			if (range.begin == range.end) range = DirtyRange{ begin, end };
+			else range = DirtyRange{ std::min(range.begin, begin), std::max(range.end, end) };
+		}
+	}
+
+	VkDescriptorBufferInfo SteelSightMaterialTable::descriptorInfo(int frameIndex) {
+		return buffers[frameIndex]->descriptorInfo();
+	}
+}
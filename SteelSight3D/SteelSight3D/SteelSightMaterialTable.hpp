@@ -0,0 +1,76 @@
+#pragma once
+#include "SteelSightDevice.hpp"
+#include "SteelSightBuffer.hpp"
+#include "SteelSightRangeAllocator.hpp"
+#include "SteelSightSwapChain.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <span>
+#include <array>
+#include <vector>
+#include <memory>
+#include <optional>
+
+namespace Voortman {
+	/// <summary>
+	/// Storage buffer with the material colors of every model, bound to binding 1 of the global descriptor set.
+	/// Every model adds its materials once, the render system pushes the material base of the model plus the material of each submesh.
+	/// The buffer has a fixed capacity so models that finish loading while frames are in flight can add materials without rebinding the descriptor set.
+	/// Every frame in flight reads its own copy of the buffer, changes go to the colors on the CPU and reach a copy when its frame is flushed after the fence wait.
+	/// The materials of released models go back to a free list and are handed out again, a model that finds no room is drawn with the fallback material.
+	/// </summary>
+	class SteelSightMaterialTable final {
+	public:
+		static constexpr uint32_t MAX_MATERIALS{ 4096 };
+
+		// A gray material that is never freed, drawn in place of the materials of a model that did not fit in the table
+		static constexpr uint32_t FALLBACK_MATERIAL{ 0 };
+
+		SteelSightMaterialTable(SteelSightDevice& device);
+		~SteelSightMaterialTable() = default;
+
+		SteelSightMaterialTable(const SteelSightMaterialTable&) = delete;
+		SteelSightMaterialTable& operator=(const SteelSightMaterialTable&) = delete;
+
+		/// <summary>
+		/// Adds consecutive colors to the table, the frames see them from their next flush on.
+		/// </summary>
+		/// <param name="colors">The colors to add</param>
+		/// <returns>Index of the first added color, empty when the table has no room for them</returns>
+		_NODISCARD std::optional<uint32_t> add(std::span<const glm::vec4> colors);
+
+		// Hands colors that add returned back to the table, the copies of frames in flight keep them until their next flush
+		void free(uint32_t base, uint32_t count);
+
+		// Changes a color, frames that are in flight keep drawing with the old color
+		void setColor(uint32_t index, const glm::vec4& color);
+
+		/// <summary>
+		/// Copies the colors that changed since the last flush of this frame into its copy of the buffer.
+		/// Called after the fence wait of the frame, so the GPU no longer reads the copy.
+		/// </summary>
+		void flush(int frameIndex);
+
+		_NODISCARD VkDescriptorBufferInfo descriptorInfo(int frameIndex);
+		_NODISCARD inline uint32_t size() const noexcept { return static_cast<uint32_t>(entries.getUsed()); }
+
+	private:
+		SteelSightDevice& SSDevice;
+
+		// The entries of a frame copy that are older than the colors, begin equals end when the copy is up to date
+		struct DirtyRange final {
+			uint32_t begin{ 0 };
+			uint32_t end{ 0 };
+		};
+
+		void markDirty(uint32_t begin, uint32_t end) noexcept;
+
+		std::vector<glm::vec4> colors{};
+		SteelSightRangeAllocator entries{ MAX_MATERIALS };
+		std::array<std::unique_ptr<SteelSightBuffer>, SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT> buffers{};
+		std::array<DirtyRange, SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT> dirty{};
+	};
+}
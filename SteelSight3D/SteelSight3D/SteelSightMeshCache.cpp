@@ -0,0 +1,249 @@
+#include "SteelSightMeshCache.hpp"
+#include "SteelSightMappedFile.hpp"
+#include "SteelSightUtils.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <cstring>
+#include <algorithm>
+
+namespace Voortman {
+	namespace {
+		constexpr char CACHE_MAGIC[4]{ 'S', 'S', 'M', 'C' };
+
+		// Sections are aligned so the mapped arrays can be used in place
+		constexpr uint64_t SECTION_ALIGNMENT{ 16 };
+
+		enum class SectionType : uint32_t {
+			Vertices = 1,
+			Indices = 2,
+			Meshlets = 3,
+			Lods = 4,
+			Submeshes = 5,
+			Materials = 6,
+			Parts = 7,
+			Instances = 8,
+		};
+
+		struct CacheSection final {
+			SectionType type{};
+			uint32_t elementSize{ 0 };
+			uint64_t offset{ 0 };
+			uint64_t count{ 0 };
+		};
+
+		struct CacheHeader final {
+			char magic[4]{};
+			uint32_t loaderVersion{ 0 };
+			uint64_t sourceHash{ 0 };
+			uint64_t coldLoadMicroseconds{ 0 };
+			uint32_t sectionCount{ 0 };
+			uint32_t reserved{ 0 };
+		};
+
+		constexpr uint64_t alignSection(uint64_t offset) noexcept {
+			return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+		}
+
+		template <typename T>
+		std::span<const T> getSection(const SteelSightMappedFile& file, const CacheSection& section) {
+			if (section.elementSize != sizeof(T) || section.offset % alignof(T) != 0) _UNLIKELY return {};
+			if (section.offset > file.size() || section.count > (file.size() - section.offset) / sizeof(T)) _UNLIKELY return {};
+
+			return { reinterpret_cast<const T*>(file.data() + section.offset), static_cast<size_t>(section.count) };
+		}
+	}
+
+	std::string SteelSightMeshCache::getCachePath(const std::string& modelPath) {
+		return modelPath + ".sscache";
+	}
+
+	uint64_t SteelSightMeshCache::hashSource(const std::string& modelPath) {
+		SteelSightMappedFile model{ modelPath };
+		const std::string_view text{ reinterpret_cast<const char*>(model.data()), model.size() };
+
+		uint64_t seed = ankerl::unordered_dense::detail::wyhash::hash(text.data(), text.size());
+
+		// The material libraries decide the material colors, so they are part of the key as well
+		const std::filesystem::path directory = std::filesystem::path(modelPath).parent_path();
+		for (size_t position = text.find("mtllib"); position != std::string_view::npos; position = text.find("mtllib", position + 6)) {
+			if (position != 0 && text[position - 1] != '\n') continue;
+
+			size_t end = text.find_first_of("\r\n", position);
+			std::string_view name = text.substr(position + 6, end == std::string_view::npos ? std::string_view::npos : end - position - 6);
+			name.remove_prefix(std::min(name.find_first_not_of(" \t"), name.size()));
+
+			const std::filesystem::path library = directory / std::filesystem::path(name);
+			if (!std::filesystem::exists(library)) continue;
+
+			SteelSightMappedFile material{ library.string() };
+			hashCombine(seed, ankerl::unordered_dense::detail::wyhash::hash(material.data(), material.size()));
+		}
+
+		return seed;
+	}
+
+	bool SteelSightMeshCache::read(const std::string& cachePath, uint64_t sourceHash, SteelSightModel::Builder& builder, std::chrono::microseconds& coldLoadTime) {
+		if (!std::filesystem::exists(cachePath)) return false;
+
+		auto file = std::make_unique<SteelSightMappedFile>(cachePath);
+		if (file->size() < sizeof(CacheHeader)) _UNLIKELY return false;
+
+		CacheHeader header{};
+		std::memcpy(&header, file->data(), sizeof(CacheHeader));
+
+		if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) _UNLIKELY return false;
+		if (header.loaderVersion != LOADER_VERSION || header.sourceHash != sourceHash) return false;
+		if (file->size() < sizeof(CacheHeader) + header.sectionCount * sizeof(CacheSection)) _UNLIKELY return false;
+
+		std::span<const SteelSightModel::Vertex> vertices{};
+		std::span<const uint32_t> indices{};
+		std::span<const SteelSightModel::Meshlet> meshlets{};
+		std::span<const SteelSightModel::Lod> lods{};
+		std::span<const SteelSightModel::Submesh> submeshes{};
+		std::span<const glm::vec4> materials{};
+		std::span<const SteelSightModel::Part> parts{};
+		std::span<const SteelSightModel::Instance> instances{};
+
+		for (uint32_t i = 0; i < header.sectionCount; ++i) {
+			CacheSection section{};
+			std::memcpy(&section, file->data() + sizeof(CacheHeader) + i * sizeof(CacheSection), sizeof(CacheSection));
+
+			switch (section.type) {
+			case SectionType::Vertices: vertices = getSection<SteelSightModel::Vertex>(*file, section); break;
+			case SectionType::Indices:  indices = getSection<uint32_t>(*file, section); break;
+			case SectionType::Meshlets: meshlets = getSection<SteelSightModel::Meshlet>(*file, section); break;
+			case SectionType::Lods:     lods = getSection<SteelSightModel::Lod>(*file, section); break;
+			case SectionType::Submeshes: submeshes = getSection<SteelSightModel::Submesh>(*file, section); break;
+			case SectionType::Materials: materials = getSection<glm::vec4>(*file, section); break;
+			case SectionType::Parts:    parts = getSection<SteelSightModel::Part>(*file, section); break;
+			case SectionType::Instances: instances = getSection<SteelSightModel::Instance>(*file, section); break;
+			default: break;
+			}
+		}
+
+		// A truncated or otherwise broken cache is treated as a miss and will be rewritten
+		if (vertices.empty()) _UNLIKELY return false;
+
+		builder.vertices.clear();
+		builder.indices.clear();
+		builder.meshlets.clear();
+		builder.lods.clear();
+		builder.submeshes.clear();
+		builder.materials.clear();
+		builder.parts.clear();
+		builder.instances.clear();
+		builder.cachedVertices = vertices;
+		builder.cachedIndices = indices;
+		builder.cachedMeshlets = meshlets;
+		builder.cachedLods = lods;
+		builder.cachedSubmeshes = submeshes;
+		builder.cachedMaterials = materials;
+		builder.cachedParts = parts;
+		builder.cachedInstances = instances;
+		builder.cacheFile = std::move(file);
+
+		coldLoadTime = std::chrono::microseconds{ header.coldLoadMicroseconds };
+		return true;
+	}
+
+	bool SteelSightMeshCache::write(const std::string& cachePath, uint64_t sourceHash, const SteelSightModel::Builder& builder, std::chrono::microseconds coldLoadTime) {
+		const auto vertices = builder.getVertices();
+		const auto indices = builder.getIndices();
+		const auto meshlets = builder.getMeshlets();
+		const auto lods = builder.getLods();
+		const auto submeshes = builder.getSubmeshes();
+		const auto materials = builder.getMaterials();
+		const auto parts = builder.getParts();
+		const auto instances = builder.getInstances();
+
+		CacheHeader header{};
+		std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header.loaderVersion = LOADER_VERSION;
+		header.sourceHash = sourceHash;
+		header.coldLoadMicroseconds = static_cast<uint64_t>(coldLoadTime.count());
+		header.sectionCount = 8;
+
+		CacheSection sections[8]{};
+		sections[0].type = SectionType::Vertices;
+		sections[0].elementSize = sizeof(SteelSightModel::Vertex);
+		sections[0].offset = alignSection(sizeof(CacheHeader) + sizeof(sections));
+		sections[0].count = vertices.size();
+
+		sections[1].type = SectionType::Indices;
+		sections[1].elementSize = sizeof(uint32_t);
+		sections[1].offset = alignSection(sections[0].offset + vertices.size_bytes());
+		sections[1].count = indices.size();
+
+		sections[2].type = SectionType::Meshlets;
+		sections[2].elementSize = sizeof(SteelSightModel::Meshlet);
+		sections[2].offset = alignSection(sections[1].offset + indices.size_bytes());
+		sections[2].count = meshlets.size();
+
+		sections[3].type = SectionType::Lods;
+		sections[3].elementSize = sizeof(SteelSightModel::Lod);
+		sections[3].offset = alignSection(sections[2].offset + meshlets.size_bytes());
+		sections[3].count = lods.size();
+
+		sections[4].type = SectionType::Submeshes;
+		sections[4].elementSize = sizeof(SteelSightModel::Submesh);
+		sections[4].offset = alignSection(sections[3].offset + lods.size_bytes());
+		sections[4].count = submeshes.size();
+
+		sections[5].type = SectionType::Materials;
+		sections[5].elementSize = sizeof(glm::vec4);
+		sections[5].offset = alignSection(sections[4].offset + submeshes.size_bytes());
+		sections[5].count = materials.size();
+
+		sections[6].type = SectionType::Parts;
+		sections[6].elementSize = sizeof(SteelSightModel::Part);
+		sections[6].offset = alignSection(sections[5].offset + materials.size_bytes());
+		sections[6].count = parts.size();
+
+		sections[7].type = SectionType::Instances;
+		sections[7].elementSize = sizeof(SteelSightModel::Instance);
+		sections[7].offset = alignSection(sections[6].offset + parts.size_bytes());
+		sections[7].count = instances.size();
+
+		// Write to a temporary file first so a crash never leaves a half written cache behind
+		const std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+			if (!file.is_open()) _UNLIKELY return false;
+
+			const char padding[SECTION_ALIGNMENT]{};
+			auto writePadded = [&](const void* data, size_t size, uint64_t offset) {
+				file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+				file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			};
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(sections), sizeof(sections));
+			writePadded(vertices.data(), vertices.size_bytes(), sections[0].offset);
+			writePadded(indices.data(), indices.size_bytes(), sections[1].offset);
+			writePadded(meshlets.data(), meshlets.size_bytes(), sections[2].offset);
+			writePadded(lods.data(), lods.size_bytes(), sections[3].offset);
+			writePadded(submeshes.data(), submeshes.size_bytes(), sections[4].offset);
+			writePadded(materials.data(), materials.size_bytes(), sections[5].offset);
+			writePadded(parts.data(), parts.size_bytes(), sections[6].offset);
+			writePadded(instances.data(), instances.size_bytes(), sections[7].offset);
+
+			if (!file.good()) _UNLIKELY {
+				file.close();
+				std::filesystem::remove(temporaryPath);
+				return false;
+			}
+		}
+
+		std::error_code error{};
+		std::filesystem::rename(temporaryPath, cachePath, error);
+		if (error) _UNLIKELY {
+			std::cerr << "Could not write mesh cache " << cachePath << ": " << error.message() << std::endl;
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Versioned binary cache of the deduplicated vertex, index, meshlet, level of detail, submesh and material arrays produced by SteelSightModel::Builder.
+	/// The cache is stored next to the model as "model.obj.sscache" and is keyed by a content hash of the model (and its material libraries) and the loader version.
+	/// On a hit the cache file is memory mapped and the Builder hands out spans straight into the mapping, so the data is copied exactly once: into the staging buffer.
+	/// </summary>
+	class SteelSightMeshCache final {
+	public:
+		/// <summary>
+		/// Version of the loader output. Bump this whenever Builder::loadModel produces different data so stale caches are rebuilt.
+		/// </summary>
+		static constexpr uint32_t LOADER_VERSION{ 7 };
+
+		/// <summary>
+		/// Path of the cache file belonging to a model.
+		/// </summary>
+		_NODISCARD static std::string getCachePath(const std::string& modelPath);
+
+		/// <summary>
+		/// Content hash of the model file and every material library it references.
+		/// </summary>
+		_NODISCARD static uint64_t hashSource(const std::string& modelPath);
+
+		/// <summary>
+		/// Maps the cache file into the builder when it exists and matches the source hash and loader version.
+		/// </summary>
+		/// <param name="cachePath">Path of the cache file</param>
+		/// <param name="sourceHash">Hash returned by hashSource</param>
+		/// <param name="builder">The builder that receives the mapping</param>
+		/// <param name="coldLoadTime">Receives the load time that was measured when the cache was written</param>
+		/// <returns>True on a cache hit</returns>
+		static bool read(const std::string& cachePath, uint64_t sourceHash, SteelSightModel::Builder& builder, std::chrono::microseconds& coldLoadTime);
+
+		/// <summary>
+		/// Writes the vertices, indices, meshlets, levels of detail, submeshes and materials of the builder to the cache file. Failing to write the cache is not fatal.
+		/// </summary>
+		/// <param name="cachePath">Path of the cache file</param>
+		/// <param name="sourceHash">Hash returned by hashSource</param>
+		/// <param name="builder">The builder with the loaded mesh</param>
+		/// <param name="coldLoadTime">Time it took to load the mesh without the cache</param>
+		/// <returns>True when the cache was written</returns>
+		static bool write(const std::string& cachePath, uint64_t sourceHash, const SteelSightModel::Builder& builder, std::chrono::microseconds coldLoadTime);
+	};
+}
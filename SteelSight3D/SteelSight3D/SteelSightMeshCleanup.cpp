@@ -0,0 +1,163 @@
+#include "SteelSightMeshCleanup.hpp"
+#include "SteelSightUtils.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+namespace Voortman {
+	namespace {
+		constexpr uint32_t NO_VERTEX{ UINT32_MAX };
+
+		struct Cell final {
+			int64_t x{ 0 };
+			int64_t y{ 0 };
+			int64_t z{ 0 };
+
+			_NODISCARD inline bool operator==(const Cell& other) const noexcept = default;
+		};
+
+		struct CellHash final {
+			using is_avalanching = void;
+			_NODISCARD inline uint64_t operator()(const Cell& cell) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(&cell, sizeof(Cell)); }
+		};
+
+		inline Cell getCell(const glm::vec3& position, float cellSize) noexcept {
+			return { static_cast<int64_t>(std::floor(position.x / cellSize)), static_cast<int64_t>(std::floor(position.y / cellSize)), static_cast<int64_t>(std::floor(position.z / cellSize)) };
+		}
+
+		// Vertices without a normal only merge with other vertices without one
+		inline bool normalsMatch(const glm::vec3& a, const glm::vec3& b, float minimumCosine) noexcept {
+			const float lengths = glm::length(a) * glm::length(b);
+			if (lengths == 0.f) _UNLIKELY return a == b;
+			return glm::dot(a, b) >= minimumCosine * lengths;
+		}
+	}
+
+	size_t SteelSightMeshCleanup::weldVertices(std::span<const SteelSightModel::Vertex> vertices, std::span<uint32_t> indices, float epsilon, float normalAngle) {
+		if (epsilon <= 0.f || vertices.empty()) _UNLIKELY return 0;
+
+		const float minimumCosine = std::cos(normalAngle * glm::pi<float>() / 180.f);
+		const float epsilonSquared = epsilon * epsilon;
+
+		// Every cell holds a linked list of the vertices kept in it
+		ankerl::unordered_dense::map<Cell, uint32_t, CellHash> cells{};
+		std::vector<uint32_t> next(vertices.size(), NO_VERTEX);
+		std::vector<uint32_t> remap(vertices.size());
+		size_t merged{ 0 };
+
+		for (uint32_t vertex = 0; vertex < vertices.size(); ++vertex) {
+			const auto& current = vertices[vertex];
+			const Cell cell = getCell(current.position, epsilon);
+
+			uint32_t match{ NO_VERTEX };
+			for (int64_t dx = -1; dx <= 1 && match == NO_VERTEX; ++dx) {
+				for (int64_t dy = -1; dy <= 1 && match == NO_VERTEX; ++dy) {
+					for (int64_t dz = -1; dz <= 1 && match == NO_VERTEX; ++dz) {
+						const auto it = cells.find({ cell.x + dx, cell.y + dy, cell.z + dz });
+						if (it == cells.end()) continue;
+
+						for (uint32_t candidate = it->second; candidate != NO_VERTEX; candidate = next[candidate]) {
+							const auto& other = vertices[candidate];
+							const glm::vec3 offset = other.position - current.position;
+							if (glm::dot(offset, offset) > epsilonSquared) continue;
+							if (glm::any(glm::greaterThan(glm::abs(other.uv - current.uv), glm::vec2{ UV_EPSILON }))) continue;
+							if (!normalsMatch(other.normal, current.normal, minimumCosine)) continue;
+
+							match = candidate;
+							break;
+						}
+					}
+				}
+			}
+
+			if (match != NO_VERTEX) {
+				remap[vertex] = match;
+				++merged;
+				continue;
+			}
+
+			remap[vertex] = vertex;
+			auto [it, inserted] = cells.try_emplace(cell, vertex);
+			if (!inserted) {
+				next[vertex] = it->second;
+				it->second = vertex;
+			}
+		}
+
+		if (merged == 0) return 0;
+
+		for (uint32_t& index : indices) index = remap[index];
+		return merged;
+	}
+
+	void SteelSightMeshCleanup::removeDegenerateTriangles(std::span<const SteelSightModel::Vertex> vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& triangleMaterials, std::span<size_t> rangeCorners, Statistics& statistics) {
+		assert(triangleMaterials.size() == indices.size() / 3 && "Every triangle needs a material");
+
+		// The range boundaries in the input, the counts themselves shrink while the triangles are removed
+		const std::vector<size_t> inputCorners(rangeCorners.begin(), rangeCorners.end());
+
+		size_t kept{ 0 };
+		size_t rangeEnd{ 0 };
+		size_t range{ 0 };
+		for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle) {
+			while (range < inputCorners.size() && 3 * triangle >= rangeEnd + inputCorners[range]) rangeEnd += inputCorners[range++];
+
+			const uint32_t a = indices[3 * triangle + 0];
+			const uint32_t b = indices[3 * triangle + 1];
+			const uint32_t c = indices[3 * triangle + 2];
+
+			bool remove{ false };
+			if (a == b || b == c || c == a) {
+				++statistics.degenerateTriangles;
+				remove = true;
+			}
+			else {
+				const glm::vec3 ab = vertices[b].position - vertices[a].position;
+				const glm::vec3 ac = vertices[c].position - vertices[a].position;
+				const float area = glm::length(glm::cross(ab, ac));
+
+				// Relative to the edges, so only truly flat corners count and not triangles that are merely thin or small
+				if (area <= ZERO_AREA_SINE * glm::length(ab) * glm::length(ac)) {
+					++statistics.zeroAreaTriangles;
+					remove = true;
+				}
+			}
+
+			if (remove) {
+				if (range < rangeCorners.size()) rangeCorners[range] -= 3;
+				continue;
+			}
+
+			for (size_t corner = 0; corner < 3; ++corner) indices[3 * kept + corner] = indices[3 * triangle + corner];
+			triangleMaterials[kept] = triangleMaterials[triangle];
+			++kept;
+		}
+
+		indices.resize(3 * kept);
+		triangleMaterials.resize(kept);
+	}
+
+	size_t SteelSightMeshCleanup::removeUnusedVertices(std::vector<SteelSightModel::Vertex>& vertices, std::span<uint32_t> indices) {
+		std::vector<uint32_t> remap(vertices.size(), NO_VERTEX);
+		for (const uint32_t index : indices) remap[index] = 0;
+
+		uint32_t count{ 0 };
+		for (size_t vertex = 0; vertex < vertices.size(); ++vertex) {
+			if (remap[vertex] == NO_VERTEX) continue;
+
+			remap[vertex] = count;
+			vertices[count++] = vertices[vertex];
+		}
+
+		const size_t removed = vertices.size() - count;
+		if (removed == 0) _LIKELY return 0;
+
+		vertices.resize(count);
+		for (uint32_t& index : indices) index = remap[index];
+		return removed;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Repairs welded triangle lists from CAD exports. The exact weld keeps vertices apart that only differ by float noise, so seams stay split.
+	/// The tolerance weld merges them with a spatial hash grid, after that triangles that collapsed to a line or a point are removed.
+	/// </summary>
+	class SteelSightMeshCleanup final {
+	public:
+		// Texture coordinates of merged vertices may differ this much, texture space has no model units
+		static constexpr float UV_EPSILON{ 1e-5f };
+
+		// A triangle whose corner angle has a smaller sine than this is a line, float noise on collinear corners stays far below it
+		static constexpr float ZERO_AREA_SINE{ 1e-6f };
+
+		struct Statistics final {
+			size_t mergedVertices{ 0 };
+			size_t unusedVertices{ 0 };
+			size_t degenerateTriangles{ 0 };
+			size_t zeroAreaTriangles{ 0 };
+		};
+
+		/// <summary>
+		/// Merges every vertex into the first earlier vertex within epsilon whose normal is less than normalAngle degrees away and whose texture coordinate matches.
+		/// Positions are bucketed in a hash grid with cells of epsilon, so only the 27 neighbouring cells are searched. The vertices are not touched, only the indices are remapped.
+		/// </summary>
+		/// <param name="vertices">The vertices</param>
+		/// <param name="indices">The triangle list, remapped in place</param>
+		/// <param name="epsilon">Largest distance between merged positions in model units</param>
+		/// <param name="normalAngle">Largest angle between merged normals in degrees</param>
+		/// <returns>Number of vertices that were merged into another one</returns>
+		static size_t weldVertices(std::span<const SteelSightModel::Vertex> vertices, std::span<uint32_t> indices, float epsilon, float normalAngle);
+
+		/// <summary>
+		/// Removes triangles with two equal indices and triangles without area, keeping the order of the others.
+		/// Long thin triangles are kept whatever their size, steel profiles are full of them (web and flange strips, chamfers) and removing one opens a hole.
+		/// </summary>
+		/// <param name="vertices">The vertices</param>
+		/// <param name="indices">The triangle list, compacted in place</param>
+		/// <param name="triangleMaterials">Material of every triangle, compacted the same way</param>
+		/// <param name="rangeCorners">Consecutive ranges of the triangle list in face corners, reduced by the corners removed from each range</param>
+		/// <param name="statistics">Receives the amount of removed triangles</param>
+		static void removeDegenerateTriangles(std::span<const SteelSightModel::Vertex> vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& triangleMaterials, std::span<size_t> rangeCorners, Statistics& statistics);
+
+		/// <summary>
+		/// Drops the vertices no triangle uses any more and remaps the indices, the other vertices keep their order.
+		/// </summary>
+		/// <returns>Number of removed vertices</returns>
+		static size_t removeUnusedVertices(std::vector<SteelSightModel::Vertex>& vertices, std::span<uint32_t> indices);
+	};
+}
@@ -0,0 +1,153 @@
+#include "SteelSightMeshOptimizer.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+namespace Voortman {
+	namespace {
+		constexpr uint32_t NO_VERTEX{ UINT32_MAX };
+
+		/// <summary>
+		/// Picks the next fanning vertex: the candidate that stays in the cache the longest while its remaining triangles are emitted.
+		/// When no candidate has live triangles left the dead end stack and finally the input order are used.
+		/// </summary>
+		uint32_t getNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& liveTriangles, const std::vector<uint32_t>& cacheTimeStamps,
+			uint32_t time, uint32_t cacheSize, std::vector<uint32_t>& deadEnds, size_t& cursor) noexcept {
+			uint32_t best{ NO_VERTEX };
+			int64_t bestPriority{ -1 };
+
+			for (uint32_t vertex : candidates) {
+				if (liveTriangles[vertex] == 0) continue;
+
+				// Vertices that would fall out of the cache before all their triangles are emitted get the lowest priority
+				int64_t priority{ 0 };
+				const int64_t age = static_cast<int64_t>(time) - cacheTimeStamps[vertex];
+				if (age + 2 * static_cast<int64_t>(liveTriangles[vertex]) <= cacheSize) priority = age;
+
+				if (priority > bestPriority) {
+					best = vertex;
+					bestPriority = priority;
+				}
+			}
+
+			if (best != NO_VERTEX) _LIKELY return best;
+
+			while (!deadEnds.empty()) {
+				const uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[vertex] > 0) return vertex;
+			}
+
+			while (cursor < liveTriangles.size()) {
+				const uint32_t vertex = static_cast<uint32_t>(cursor++);
+				if (liveTriangles[vertex] > 0) return vertex;
+			}
+
+			return NO_VERTEX;
+		}
+	}
+
+	SteelSightMeshOptimizer::VertexCacheStatistics SteelSightMeshOptimizer::analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+		VertexCacheStatistics statistics{};
+		if (indices.empty() || vertexCount == 0) _UNLIKELY return statistics;
+
+		// Time stamp at which every vertex entered the cache, a vertex is a hit when it entered less than cacheSize misses ago
+		std::vector<uint32_t> cacheTimeStamps(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		uint32_t time{ cacheSize + 1 };
+		size_t misses{ 0 };
+		size_t referencedCount{ 0 };
+
+		for (uint32_t index : indices) {
+			assert(index < vertexCount && "Index out of range");
+
+			if (time - cacheTimeStamps[index] > cacheSize) {
+				cacheTimeStamps[index] = time++;
+				++misses;
+			}
+
+			if (!referenced[index]) {
+				referenced[index] = true;
+				++referencedCount;
+			}
+		}
+
+		statistics.acmr = static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+		statistics.atvr = static_cast<double>(misses) / static_cast<double>(referencedCount);
+		return statistics;
+	}
+
+	void SteelSightMeshOptimizer::optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0) _UNLIKELY return;
+
+		// Vertex to triangle adjacency as offsets into one flat array
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (uint32_t index : indices) ++liveTriangles[index];
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t vertex = 0; vertex < vertexCount; ++vertex) adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+
+		std::vector<uint32_t> adjacency(adjacencyOffsets.back());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+				for (size_t corner = 0; corner < 3; ++corner) adjacency[fill[indices[3 * triangle + corner]]++] = static_cast<uint32_t>(triangle);
+			}
+		}
+
+		std::vector<uint32_t> cacheTimeStamps(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds{};
+		std::vector<uint32_t> candidates{};
+		std::vector<uint32_t> output{};
+		output.reserve(triangleCount * 3);
+
+		uint32_t time{ cacheSize + 1 };
+		size_t cursor{ 0 };
+		uint32_t fanningVertex = getNextVertex({}, liveTriangles, cacheTimeStamps, time, cacheSize, deadEnds, cursor);
+
+		while (fanningVertex != NO_VERTEX) {
+			candidates.clear();
+
+			// Emit every remaining triangle around the fanning vertex
+			for (uint32_t a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a) {
+				const uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) continue;
+				emitted[triangle] = true;
+
+				for (size_t corner = 0; corner < 3; ++corner) {
+					const uint32_t vertex = indices[3 * triangle + corner];
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+
+					if (time - cacheTimeStamps[vertex] > cacheSize) cacheTimeStamps[vertex] = time++;
+				}
+			}
+
+			fanningVertex = getNextVertex(candidates, liveTriangles, cacheTimeStamps, time, cacheSize, deadEnds, cursor);
+		}
+
+		assert(output.size() == triangleCount * 3 && "Tipsify must emit every triangle exactly once");
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	void SteelSightMeshOptimizer::optimizeVertexFetch(std::vector<SteelSightModel::Vertex>& vertices, std::vector<uint32_t>& indices) {
+		constexpr uint32_t UNUSED{ UINT32_MAX };
+		std::vector<uint32_t> remap(vertices.size(), UNUSED);
+		std::vector<SteelSightModel::Vertex> reordered{};
+		reordered.reserve(vertices.size());
+
+		for (uint32_t& index : indices) {
+			if (remap[index] == UNUSED) {
+				remap[index] = static_cast<uint32_t>(reordered.size());
+				reordered.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices = std::move(reordered);
+	}
+}
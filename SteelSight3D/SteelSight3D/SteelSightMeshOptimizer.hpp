@@ -0,0 +1,52 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Reorders welded triangle lists for the GPU. The triangles are reordered for the post-transform vertex cache (Tipsify),
+	/// after that the vertices are reordered by first use so the vertex fetch reads the vertex buffer mostly front to back.
+	/// Neither step changes the rendered mesh.
+	/// </summary>
+	class SteelSightMeshOptimizer final {
+	public:
+		/// <summary>
+		/// Size of the simulated FIFO post-transform cache, small enough to hold on every GPU we target.
+		/// </summary>
+		static constexpr uint32_t VERTEX_CACHE_SIZE{ 16 };
+
+		struct VertexCacheStatistics final {
+			// Average cache miss ratio: transformed vertices per triangle, 0.5 is the best a regular grid can do and 3.0 the worst
+			double acmr{ 0.0 };
+			// Average transformed vertex ratio: transformed vertices per referenced vertex, 1.0 is optimal
+			double atvr{ 0.0 };
+		};
+
+		/// <summary>
+		/// Simulates a FIFO post-transform cache over a triangle list.
+		/// </summary>
+		/// <param name="indices">The triangle list</param>
+		/// <param name="vertexCount">Number of vertices the indices point into</param>
+		/// <param name="cacheSize">Number of entries of the simulated cache</param>
+		/// <returns>The ACMR and ATVR of the triangle list</returns>
+		_NODISCARD static VertexCacheStatistics analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize);
+
+		/// <summary>
+		/// Reorders the triangles for the post-transform cache with Tipsify (Sander, Nehab and Barczak 2007), linear in the amount of triangles.
+		/// </summary>
+		/// <param name="indices">The triangle list, reordered in place. A range of a larger index buffer keeps its triangles inside the range</param>
+		/// <param name="vertexCount">Number of vertices the indices point into</param>
+		/// <param name="cacheSize">Number of entries of the cache to optimize for</param>
+		static void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize);
+
+		/// <summary>
+		/// Reorders the vertices in the order the triangles first use them and drops unreferenced vertices, the indices are remapped.
+		/// </summary>
+		/// <param name="vertices">The vertices, reordered in place</param>
+		/// <param name="indices">The triangle list, remapped in place</param>
+		static void optimizeVertexFetch(std::vector<SteelSightModel::Vertex>& vertices, std::vector<uint32_t>& indices);
+	};
+}
@@ -0,0 +1,466 @@
+#include "SteelSightMeshSimplifier.hpp"
+#include "unordered_dense.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Voortman {
+	namespace {
+		/// <summary>
+		/// Symmetric 4x4 error quadric, the sum of the squared distances to a set of weighted planes.
+		/// </summary>
+		struct Quadric final {
+			double a00{ 0.0 }, a01{ 0.0 }, a02{ 0.0 }, a11{ 0.0 }, a12{ 0.0 }, a22{ 0.0 };
+			double b0{ 0.0 }, b1{ 0.0 }, b2{ 0.0 };
+			double c{ 0.0 };
+			double weight{ 0.0 };
+
+			inline void addPlane(const glm::dvec3& normal, double distance, double planeWeight) noexcept {
+				a00 += normal.x * normal.x * planeWeight;
+				a01 += normal.x * normal.y * planeWeight;
+				a02 += normal.x * normal.z * planeWeight;
+				a11 += normal.y * normal.y * planeWeight;
+				a12 += normal.y * normal.z * planeWeight;
+				a22 += normal.z * normal.z * planeWeight;
+				b0 += normal.x * distance * planeWeight;
+				b1 += normal.y * distance * planeWeight;
+				b2 += normal.z * distance * planeWeight;
+				c += distance * distance * planeWeight;
+				weight += planeWeight;
+			}
+
+			inline Quadric& operator+=(const Quadric& other) noexcept {
+				a00 += other.a00; a01 += other.a01; a02 += other.a02; a11 += other.a11; a12 += other.a12; a22 += other.a22;
+				b0 += other.b0; b1 += other.b1; b2 += other.b2;
+				c += other.c;
+				weight += other.weight;
+				return *this;
+			}
+
+			// Weighted mean squared distance of p to the planes
+			_NODISCARD inline double evaluate(const glm::dvec3& p) const noexcept {
+				if (weight <= 0.0) _UNLIKELY return 0.0;
+
+				const double value =
+					a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+					2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+					2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+				return std::max(0.0, value) / weight;
+			}
+		};
+
+		struct PositionHash final {
+			using is_avalanching = void;
+			_NODISCARD inline uint64_t operator()(const glm::vec3& position) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(&position, sizeof(glm::vec3)); }
+		};
+
+		struct Collapse final {
+			double cost{ 0.0 };
+			uint32_t from{ 0 };
+			uint32_t to{ 0 };
+		};
+
+		/// <summary>
+		/// State of one simplification. All topology works on positions, a position is the set of vertices with the same coordinates.
+		/// </summary>
+		class Simplifier final {
+		public:
+			Simplifier(std::span<const SteelSightModel::Vertex> vertices, std::span<const uint32_t> indices, std::span<const uint32_t> materials) : vertices{ vertices }, remap(vertices.size()) {
+				ankerl::unordered_dense::map<glm::vec3, uint32_t, PositionHash> uniquePositions{};
+				positionOf.resize(vertices.size());
+
+				for (size_t vertex = 0; vertex < vertices.size(); ++vertex) {
+					// Adding zero turns -0 into +0 so both hash the same
+					const glm::vec3 position = vertices[vertex].position + glm::vec3{ 0.f };
+					auto [it, inserted] = uniquePositions.try_emplace(position, static_cast<uint32_t>(positions.size()));
+					if (inserted) positions.push_back(position);
+					positionOf[vertex] = it->second;
+				}
+
+				for (uint32_t vertex = 0; vertex < remap.size(); ++vertex) remap[vertex] = vertex;
+
+				buildAttributeClasses();
+
+				triangles.reserve(indices.size());
+				triangleMaterials.reserve(indices.size() / 3);
+				for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+					if (isDegenerate(indices[i], indices[i + 1], indices[i + 2])) continue;
+					triangles.insert(triangles.end(), { indices[i], indices[i + 1], indices[i + 2] });
+					triangleMaterials.push_back(materials.empty() ? 0 : materials[i / 3]);
+				}
+
+				buildTopology();
+				buildQuadrics();
+			}
+
+			_NODISCARD std::vector<uint32_t> simplify(size_t targetIndexCount, float maximumError, float& error, std::vector<uint32_t>& materials) {
+				const double maximumCost = static_cast<double>(maximumError) * maximumError;
+				double largestCost{ 0.0 };
+
+				while (triangles.size() > targetIndexCount) {
+					const size_t collapsed = collapsePass(targetIndexCount, maximumCost, largestCost);
+					if (collapsed == 0) break;
+
+					buildTopology();
+				}
+
+				error = static_cast<float>(std::sqrt(largestCost));
+				materials = std::move(triangleMaterials);
+				return std::move(triangles);
+			}
+
+		private:
+			_NODISCARD inline bool isDegenerate(uint32_t a, uint32_t b, uint32_t c) const noexcept {
+				return positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c];
+			}
+
+			_NODISCARD inline glm::dvec3 getPosition(uint32_t position) const noexcept { return glm::dvec3{ positions[position] }; }
+
+			/// <summary>
+			/// Groups the vertices of every position into attribute classes: same texture coordinate and normals less than SEAM_ANGLE apart.
+			/// Flat shaded CAD exports give every face its own normal, without the classes every vertex of a curved part would be a seam.
+			/// </summary>
+			void buildAttributeClasses() {
+				const float minimumCosine = std::cos(glm::radians(SteelSightMeshSimplifier::SEAM_ANGLE));
+
+				std::vector<uint32_t> order(vertices.size());
+				for (uint32_t vertex = 0; vertex < order.size(); ++vertex) order[vertex] = vertex;
+				std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return positionOf[a] < positionOf[b]; });
+
+				classOf.resize(vertices.size());
+				uint32_t classCount{ 0 };
+
+				for (size_t begin = 0, end = 0; begin < order.size(); begin = end) {
+					end = begin;
+					while (end < order.size() && positionOf[order[end]] == positionOf[order[begin]]) ++end;
+
+					// The first vertex of every class is its representative
+					const uint32_t firstClass = classCount;
+					for (size_t i = begin; i < end; ++i) {
+						const auto& vertex = vertices[order[i]];
+
+						uint32_t match{ UINT32_MAX };
+						for (size_t j = begin; j < i && match == UINT32_MAX; ++j) {
+							const auto& other = vertices[order[j]];
+							if (classOf[order[j]] < firstClass || other.uv != vertex.uv) continue;
+							if (glm::dot(other.normal, vertex.normal) >= minimumCosine * glm::length(other.normal) * glm::length(vertex.normal)) match = classOf[order[j]];
+						}
+
+						classOf[order[i]] = match != UINT32_MAX ? match : classCount++;
+					}
+				}
+			}
+
+			_NODISCARD inline std::span<const uint32_t> trianglesAround(uint32_t position) const noexcept {
+				return { triangleList.data() + triangleOffsets[position], triangleOffsets[position + 1] - triangleOffsets[position] };
+			}
+
+			_NODISCARD static inline uint64_t edgeKey(uint32_t a, uint32_t b) noexcept {
+				return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+			}
+
+			/// <summary>
+			/// Builds the triangles around every position and the unique edges with the number of triangles on them.
+			/// Open edges and edges between two materials are borders, a position where more than two borders meet cannot move without changing their shape.
+			/// </summary>
+			void buildTopology() {
+				const size_t triangleCount = triangles.size() / 3;
+
+				triangleOffsets.assign(positions.size() + 1, 0);
+				for (uint32_t index : triangles) ++triangleOffsets[positionOf[index] + 1];
+				for (size_t position = 0; position < positions.size(); ++position) triangleOffsets[position + 1] += triangleOffsets[position];
+
+				triangleList.resize(triangles.size());
+				std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+				for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+					for (size_t corner = 0; corner < 3; ++corner) triangleList[fill[positionOf[triangles[3 * triangle + corner]]]++] = static_cast<uint32_t>(triangle);
+				}
+
+				std::vector<std::pair<uint64_t, uint32_t>> corners{};
+				corners.reserve(triangles.size());
+				for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const uint32_t a = positionOf[triangles[3 * triangle + corner]];
+						const uint32_t b = positionOf[triangles[3 * triangle + (corner + 1) % 3]];
+						corners.emplace_back(edgeKey(a, b), static_cast<uint32_t>(triangle));
+					}
+				}
+				std::sort(corners.begin(), corners.end());
+
+				edges.clear();
+				edgeCounts.clear();
+				edgeTriangles.clear();
+				edgeBorders.clear();
+				for (const auto& [key, triangle] : corners) {
+					if (!edges.empty() && edges.back() == key) {
+						++edgeCounts.back();
+						if (triangleMaterials[triangle] != triangleMaterials[edgeTriangles.back()]) edgeBorders.back() = true;
+						continue;
+					}
+					edges.push_back(key);
+					edgeCounts.push_back(1);
+					edgeTriangles.push_back(triangle);
+					edgeBorders.push_back(false);
+				}
+
+				border.assign(positions.size(), false);
+				locked.assign(positions.size(), false);
+				std::vector<uint8_t> borderEdges(positions.size(), 0);
+				for (size_t edge = 0; edge < edges.size(); ++edge) {
+					const uint32_t a = static_cast<uint32_t>(edges[edge] >> 32);
+					const uint32_t b = static_cast<uint32_t>(edges[edge] & 0xffffffffu);
+
+					if (edgeCounts[edge] == 1) edgeBorders[edge] = true;
+					if (edgeBorders[edge]) {
+						border[a] = border[b] = true;
+						if (++borderEdges[a] > 2) locked[a] = true;
+						if (++borderEdges[b] > 2) locked[b] = true;
+					}
+					// Non manifold edges are never touched, collapsing around them tears the mesh
+					if (edgeCounts[edge] > 2) locked[a] = locked[b] = true;
+				}
+			}
+
+			/// <summary>
+			/// Face planes weighted by area, plus a plane perpendicular to every border edge so open borders and material boundaries keep their shape.
+			/// </summary>
+			void buildQuadrics() {
+				quadrics.assign(positions.size(), Quadric{});
+
+				for (size_t i = 0; i < triangles.size(); i += 3) {
+					const uint32_t a = positionOf[triangles[i]], b = positionOf[triangles[i + 1]], c = positionOf[triangles[i + 2]];
+					const glm::dvec3 pa = getPosition(a), pb = getPosition(b), pc = getPosition(c);
+
+					glm::dvec3 normal = glm::cross(pb - pa, pc - pa);
+					const double length = glm::length(normal);
+					if (length == 0.0) _UNLIKELY continue;
+
+					normal /= length;
+					const double distance = -glm::dot(normal, pa);
+					for (uint32_t position : { a, b, c }) quadrics[position].addPlane(normal, distance, length * 0.5);
+				}
+
+				for (size_t edge = 0; edge < edges.size(); ++edge) {
+					if (!edgeBorders[edge]) continue;
+
+					const uint32_t a = static_cast<uint32_t>(edges[edge] >> 32);
+					const uint32_t b = static_cast<uint32_t>(edges[edge] & 0xffffffffu);
+					const uint32_t triangle = edgeTriangles[edge];
+
+					const glm::dvec3 pa = getPosition(a), pb = getPosition(b);
+					const glm::dvec3 faceNormal = glm::cross(getPosition(positionOf[triangles[3 * triangle + 1]]) - getPosition(positionOf[triangles[3 * triangle]]),
+						getPosition(positionOf[triangles[3 * triangle + 2]]) - getPosition(positionOf[triangles[3 * triangle]]));
+
+					glm::dvec3 normal = glm::cross(pb - pa, faceNormal);
+					const double length = glm::length(normal);
+					if (length == 0.0) _UNLIKELY continue;
+
+					normal /= length;
+					const double distance = -glm::dot(normal, pa);
+					const double planeWeight = glm::dot(pb - pa, pb - pa) * SteelSightMeshSimplifier::BORDER_WEIGHT;
+					quadrics[a].addPlane(normal, distance, planeWeight);
+					quadrics[b].addPlane(normal, distance, planeWeight);
+				}
+			}
+
+			_NODISCARD inline size_t edgeTriangleCount(uint32_t a, uint32_t b) const noexcept {
+				const uint64_t key = edgeKey(a, b);
+				auto it = std::lower_bound(edges.begin(), edges.end(), key);
+				return it != edges.end() && *it == key ? edgeCounts[it - edges.begin()] : 0;
+			}
+
+			void collectNeighbours(uint32_t position, std::vector<uint32_t>& neighbours) const {
+				neighbours.clear();
+				for (uint32_t triangle : trianglesAround(position)) {
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const uint32_t neighbour = positionOf[triangles[3 * triangle + corner]];
+						if (neighbour != position) neighbours.push_back(neighbour);
+					}
+				}
+				std::sort(neighbours.begin(), neighbours.end());
+				neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+			}
+
+			/// <summary>
+			/// Checks whether position from can collapse onto position to and finds the vertex every vertex of from is replaced with.
+			/// Every attribute class of from must share a triangle with exactly one class of to, otherwise the collapse would tear a seam.
+			/// A vertex that shares a triangle with to takes the vertex of that triangle, the other vertices take the vertex found for their class.
+			/// </summary>
+			_NODISCARD bool canCollapse(uint32_t from, uint32_t to, std::vector<std::pair<uint32_t, uint32_t>>& partners) {
+				partners.clear();
+				classPartners.clear();
+				size_t sharedTriangles{ 0 };
+
+				for (uint32_t triangle : trianglesAround(from)) {
+					uint32_t fromVertex{ UINT32_MAX }, toVertex{ UINT32_MAX };
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const uint32_t vertex = triangles[3 * triangle + corner];
+						if (positionOf[vertex] == from) fromVertex = vertex;
+						else if (positionOf[vertex] == to) toVertex = vertex;
+					}
+					if (toVertex == UINT32_MAX) continue;
+
+					++sharedTriangles;
+					auto it = std::find_if(classPartners.begin(), classPartners.end(), [this, fromVertex](const auto& pair) { return pair.first == classOf[fromVertex]; });
+					if (it == classPartners.end()) classPartners.emplace_back(classOf[fromVertex], toVertex);
+					else if (classOf[it->second] != classOf[toVertex]) return false;
+
+					if (std::none_of(partners.begin(), partners.end(), [fromVertex](const auto& pair) { return pair.first == fromVertex; })) partners.emplace_back(fromVertex, toVertex);
+				}
+
+				for (uint32_t triangle : trianglesAround(from)) {
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const uint32_t vertex = triangles[3 * triangle + corner];
+						if (positionOf[vertex] != from) continue;
+						if (std::any_of(partners.begin(), partners.end(), [vertex](const auto& pair) { return pair.first == vertex; })) continue;
+
+						auto it = std::find_if(classPartners.begin(), classPartners.end(), [this, vertex](const auto& pair) { return pair.first == classOf[vertex]; });
+						if (it == classPartners.end()) return false;
+						partners.emplace_back(vertex, it->second);
+					}
+				}
+
+				// Link condition: the edge may only have the triangles on it as common neighbours, otherwise the collapse pinches the surface
+				collectNeighbours(from, fromNeighbours);
+				collectNeighbours(to, toNeighbours);
+				size_t common{ 0 };
+				for (size_t i = 0, j = 0; i < fromNeighbours.size() && j < toNeighbours.size();) {
+					if (fromNeighbours[i] < toNeighbours[j]) ++i;
+					else if (fromNeighbours[i] > toNeighbours[j]) ++j;
+					else { ++common; ++i; ++j; }
+				}
+				if (common != sharedTriangles) return false;
+
+				// Reject collapses that flip or fold a remaining triangle
+				const glm::dvec3 target = getPosition(to);
+				for (uint32_t triangle : trianglesAround(from)) {
+					glm::dvec3 before[3]{}, after[3]{};
+					bool hasTo{ false };
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const uint32_t position = positionOf[triangles[3 * triangle + corner]];
+						hasTo |= position == to;
+						before[corner] = getPosition(position);
+						after[corner] = position == from ? target : before[corner];
+					}
+					if (hasTo) continue;
+
+					const glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					const glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					if (glm::dot(normalBefore, normalAfter) <= 0.25 * glm::length(normalBefore) * glm::length(normalAfter)) return false;
+				}
+
+				return true;
+			}
+
+			/// <summary>
+			/// Collapses the cheapest independent edges, a position touched by a collapse is not used again until the next pass.
+			/// </summary>
+			/// <returns>The number of collapses</returns>
+			size_t collapsePass(size_t targetIndexCount, double maximumCost, double& largestCost) {
+				std::vector<Collapse> collapses{};
+				collapses.reserve(edges.size());
+
+				for (size_t edge = 0; edge < edges.size(); ++edge) {
+					if (edgeCounts[edge] > 2) continue;
+
+					const uint32_t a = static_cast<uint32_t>(edges[edge] >> 32);
+					const uint32_t b = static_cast<uint32_t>(edges[edge] & 0xffffffffu);
+
+					Collapse best{ -1.0, 0, 0 };
+					for (auto [from, to] : { std::pair{ a, b }, std::pair{ b, a } }) {
+						if (locked[from]) continue;
+						// A border position may only slide along the border
+						if (border[from] && !edgeBorders[edge]) continue;
+
+						Quadric quadric = quadrics[from];
+						quadric += quadrics[to];
+						const double cost = quadric.evaluate(getPosition(to));
+						if (best.cost < 0.0 || cost < best.cost) best = { cost, from, to };
+					}
+
+					if (best.cost >= 0.0) collapses.push_back(best);
+				}
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+					return a.cost != b.cost ? a.cost < b.cost : a.from != b.from ? a.from < b.from : a.to < b.to;
+				});
+
+				std::vector<bool> touched(positions.size(), false);
+				std::vector<std::pair<uint32_t, uint32_t>> partners{};
+				size_t removedIndices{ 0 };
+				size_t collapsed{ 0 };
+
+				for (const auto& collapse : collapses) {
+					if (collapse.cost > maximumCost) break;
+					if (triangles.size() - removedIndices <= targetIndexCount) break;
+					if (touched[collapse.from] || touched[collapse.to]) continue;
+					if (!canCollapse(collapse.from, collapse.to, partners)) continue;
+
+					for (const auto& [fromVertex, toVertex] : partners) remap[fromVertex] = toVertex;
+					quadrics[collapse.to] += quadrics[collapse.from];
+					largestCost = std::max(largestCost, collapse.cost);
+
+					for (uint32_t position : { collapse.from, collapse.to }) {
+						for (uint32_t triangle : trianglesAround(position)) {
+							for (size_t corner = 0; corner < 3; ++corner) touched[positionOf[triangles[3 * triangle + corner]]] = true;
+						}
+					}
+
+					removedIndices += edgeTriangleCount(collapse.from, collapse.to) * 3;
+					++collapsed;
+				}
+
+				if (collapsed == 0) return 0;
+
+				// Apply the collapses and drop the triangles that became degenerate
+				size_t write{ 0 };
+				for (size_t i = 0; i < triangles.size(); i += 3) {
+					const uint32_t a = remap[triangles[i]], b = remap[triangles[i + 1]], c = remap[triangles[i + 2]];
+					if (isDegenerate(a, b, c)) continue;
+
+					triangleMaterials[write / 3] = triangleMaterials[i / 3];
+					triangles[write++] = a;
+					triangles[write++] = b;
+					triangles[write++] = c;
+				}
+				triangles.resize(write);
+				triangleMaterials.resize(write / 3);
+
+				for (uint32_t vertex = 0; vertex < remap.size(); ++vertex) remap[vertex] = vertex;
+				return collapsed;
+			}
+
+			std::span<const SteelSightModel::Vertex> vertices;
+
+			std::vector<uint32_t> positionOf{};
+			std::vector<uint32_t> classOf{};
+			std::vector<glm::vec3> positions{};
+			std::vector<Quadric> quadrics{};
+			std::vector<uint32_t> remap{};
+
+			std::vector<uint32_t> triangles{};
+			std::vector<uint32_t> triangleMaterials{};
+			std::vector<uint32_t> triangleOffsets{};
+			std::vector<uint32_t> triangleList{};
+
+			// Sorted unique edges as (low position << 32 | high position)
+			std::vector<uint64_t> edges{};
+			std::vector<uint32_t> edgeCounts{};
+			std::vector<uint32_t> edgeTriangles{};
+			// Open edges and edges between triangles of different materials
+			std::vector<bool> edgeBorders{};
+
+			std::vector<bool> border{};
+			std::vector<bool> locked{};
+
+			std::vector<std::pair<uint32_t, uint32_t>> classPartners{};
+			std::vector<uint32_t> fromNeighbours{};
+			std::vector<uint32_t> toNeighbours{};
+		};
+	}
+
+	std::vector<uint32_t> SteelSightMeshSimplifier::simplify(std::span<const SteelSightModel::Vertex> vertices, std::span<const uint32_t> indices, std::vector<uint32_t>& materials, size_t targetIndexCount, float maximumError, float& error) {
+		Simplifier simplifier{ vertices, indices, materials };
+		return simplifier.simplify(targetIndexCount, maximumError, error, materials);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Quadric error edge collapse (Garland and Heckbert) that only collapses a vertex onto one of its neighbours.
+	/// The simplified triangles therefore index the original vertex buffer, so every level of detail of a model shares one vertex buffer.
+	/// Vertices at the same position with different texture coordinates or sharply different normals (UV seams and hard edges) only collapse along the seam,
+	/// open borders and the boundaries between materials only collapse along the border, so the outline of plates, the hard edges of profiles and the painted areas survive.
+	/// </summary>
+	class SteelSightMeshSimplifier final {
+	public:
+		// Levels of detail including the full detail mesh, every level has about half the triangles of the previous one
+		static constexpr uint32_t MAX_LODS{ 5 };
+
+		// A level is dropped when it removes less than this fraction of the triangles of the previous level
+		static constexpr float MIN_LOD_REDUCTION{ 0.2f };
+
+		// Largest error of a single level relative to the model radius, beyond that the shape of a part is no longer recognisable
+		static constexpr float MAX_LOD_ERROR{ 0.05f };
+
+		// Vertices at one position whose normals are less than this many degrees apart are treated as one smooth surface.
+		// Flat shaded curved parts can then be simplified while the hard edges of profiles and plates stay seams
+		static constexpr float SEAM_ANGLE{ 35.f };
+
+		// Open border edges weigh this much more than faces so plates keep their outline
+		static constexpr double BORDER_WEIGHT{ 10.0 };
+
+		/// <summary>
+		/// Simplifies a triangle list until it has at most targetIndexCount indices or the next collapse would exceed maximumError.
+		/// </summary>
+		/// <param name="vertices">The vertices, the positions decide which vertices belong together</param>
+		/// <param name="indices">The triangle list to simplify</param>
+		/// <param name="materials">Material of every triangle or empty for a single material, replaced with the materials of the simplified triangles</param>
+		/// <param name="targetIndexCount">Number of indices to stop at</param>
+		/// <param name="maximumError">Largest allowed error in model units</param>
+		/// <param name="error">Receives the largest error of all collapses in model units</param>
+		/// <returns>The simplified triangle list, indexing the same vertices</returns>
+		_NODISCARD static std::vector<uint32_t> simplify(std::span<const SteelSightModel::Vertex> vertices, std::span<const uint32_t> indices, std::vector<uint32_t>& materials, size_t targetIndexCount, float maximumError, float& error);
+	};
+}
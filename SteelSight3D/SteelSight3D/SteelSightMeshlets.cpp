@@ -0,0 +1,162 @@
+#include "SteelSightMeshlets.hpp"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace Voortman {
+	namespace {
+		/// <summary>
+		/// Computes the bounding sphere and normal cone of a meshlet, the cone follows the construction of meshoptimizer.
+		/// </summary>
+		void computeBounds(SteelSightModel::Meshlet& meshlet, std::span<const SteelSightModel::Vertex> vertices, std::span<const uint32_t> indices) noexcept {
+			const auto triangles = indices.subspan(meshlet.firstIndex, static_cast<size_t>(meshlet.triangleCount) * 3);
+
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+			for (uint32_t index : triangles) {
+				minimum = glm::min(minimum, vertices[index].position);
+				maximum = glm::max(maximum, vertices[index].position);
+			}
+
+			meshlet.center = (minimum + maximum) * 0.5f;
+			float radiusSquared{ 0.f };
+			for (uint32_t index : triangles) {
+				const glm::vec3 offset = vertices[index].position - meshlet.center;
+				radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+			}
+			meshlet.radius = std::sqrt(radiusSquared);
+
+			// Face normals, oriented like the vertex normals so the cone does not depend on the winding of the exporter
+			std::array<glm::vec3, SteelSightMeshlets::MAX_TRIANGLES> normals{};
+			std::array<glm::vec3, SteelSightMeshlets::MAX_TRIANGLES> corners{};
+			uint32_t normalCount{ 0 };
+			glm::vec3 axis{ 0.f };
+
+			for (size_t triangle = 0; triangle < meshlet.triangleCount; ++triangle) {
+				const auto& a = vertices[triangles[3 * triangle + 0]];
+				const auto& b = vertices[triangles[3 * triangle + 1]];
+				const auto& c = vertices[triangles[3 * triangle + 2]];
+
+				glm::vec3 normal = glm::cross(b.position - a.position, c.position - a.position);
+				const float length = glm::length(normal);
+				if (length == 0.f) _UNLIKELY continue;
+
+				normal /= length;
+				if (glm::dot(normal, a.normal + b.normal + c.normal) < 0.f) normal = -normal;
+
+				normals[normalCount] = normal;
+				corners[normalCount] = a.position;
+				++normalCount;
+				axis += normal;
+			}
+
+			meshlet.coneCutoff = SteelSightMeshlets::CONE_DISABLED;
+			const float axisLength = glm::length(axis);
+			if (normalCount == 0 || axisLength == 0.f) _UNLIKELY return;
+
+			meshlet.coneAxis = axis / axisLength;
+
+			float minimumDot{ 1.f };
+			for (uint32_t n = 0; n < normalCount; ++n) minimumDot = std::min(minimumDot, glm::dot(normals[n], meshlet.coneAxis));
+
+			// A cone wider than about 84 degrees almost never culls anything and makes the apex run off to infinity
+			if (minimumDot <= 0.1f) return;
+
+			// Move the apex back along the axis until it is behind the plane of every triangle
+			float maximumT{ 0.f };
+			for (uint32_t n = 0; n < normalCount; ++n) {
+				const float t = glm::dot(meshlet.center - corners[n], normals[n]) / glm::dot(meshlet.coneAxis, normals[n]);
+				maximumT = std::max(maximumT, t);
+			}
+
+			meshlet.coneApex = meshlet.center - meshlet.coneAxis * maximumT;
+			meshlet.coneCutoff = std::sqrt(1.f - minimumDot * minimumDot);
+		}
+	}
+
+	std::vector<SteelSightMeshlets::Meshlet> SteelSightMeshlets::build(std::span<const SteelSightModel::Vertex> vertices, std::span<const uint32_t> indices) {
+		std::vector<Meshlet> meshlets{};
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) _UNLIKELY return meshlets;
+
+		meshlets.reserve(triangleCount / MAX_TRIANGLES + 1);
+
+		// The meshlet that last used every vertex, so the unique vertex count of the open meshlet is known without a set
+		constexpr uint32_t NO_MESHLET{ UINT32_MAX };
+		std::vector<uint32_t> lastMeshlet(vertices.size(), NO_MESHLET);
+
+		Meshlet current{};
+
+		auto countNewVertices = [&](size_t triangle) noexcept {
+			const uint32_t id = static_cast<uint32_t>(meshlets.size());
+			const uint32_t a = indices[3 * triangle + 0], b = indices[3 * triangle + 1], c = indices[3 * triangle + 2];
+
+			uint32_t count{ 0 };
+			count += lastMeshlet[a] != id;
+			count += lastMeshlet[b] != id && b != a;
+			count += lastMeshlet[c] != id && c != a && c != b;
+			return count;
+		};
+
+		for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+			uint32_t newVertices = countNewVertices(triangle);
+
+			if (current.triangleCount == MAX_TRIANGLES || current.vertexCount + newVertices > MAX_VERTICES) {
+				computeBounds(current, vertices, indices);
+				meshlets.push_back(current);
+
+				current = {};
+				current.firstIndex = static_cast<uint32_t>(triangle * 3);
+				newVertices = countNewVertices(triangle);
+			}
+
+			const uint32_t id = static_cast<uint32_t>(meshlets.size());
+			for (size_t corner = 0; corner < 3; ++corner) lastMeshlet[indices[3 * triangle + corner]] = id;
+
+			current.vertexCount += newVertices;
+			++current.triangleCount;
+		}
+
+		computeBounds(current, vertices, indices);
+		meshlets.push_back(current);
+
+		return meshlets;
+	}
+
+	SteelSightMeshlets::Frustum SteelSightMeshlets::makeFrustum(const glm::mat4& modelMatrix, const glm::mat4& projectionView, const glm::vec3& cameraPosition, bool coneCulling) noexcept {
+		// Planes of the clip space of projectionView * modelMatrix are the frustum planes in model space (Gribb and Hartmann), depth is 0 to 1
+		const glm::mat4 clip = projectionView * modelMatrix;
+		auto row = [&clip](int i) noexcept { return glm::vec4{ clip[0][i], clip[1][i], clip[2][i], clip[3][i] }; };
+
+		Frustum frustum{};
+		frustum.planes[0] = row(3) + row(0);
+		frustum.planes[1] = row(3) - row(0);
+		frustum.planes[2] = row(3) + row(1);
+		frustum.planes[3] = row(3) - row(1);
+		frustum.planes[4] = row(2);
+		frustum.planes[5] = row(3) - row(2);
+
+		frustum.cameraPosition = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.f));
+		frustum.coneCulling = coneCulling;
+		return frustum;
+	}
+
+	bool SteelSightMeshlets::isVisible(const Meshlet& meshlet, const Frustum& frustum) noexcept {
+		// The planes are not normalized, scaling the radius by the plane normal length keeps the test exact for a non uniform model scale
+		for (const auto& plane : frustum.planes) {
+			const glm::vec3 normal{ plane };
+			if (glm::dot(normal, meshlet.center) + plane.w < -meshlet.radius * glm::length(normal)) return false;
+		}
+
+		if (frustum.coneCulling && meshlet.coneCutoff <= 1.f) {
+			// Backfacing is preserved by affine transforms, so the test in model space gives the same answer as in world space
+			const glm::vec3 direction = meshlet.coneApex - frustum.cameraPosition;
+			const float distance = glm::length(direction);
+			if (distance > 0.f && glm::dot(direction, meshlet.coneAxis) >= meshlet.coneCutoff * distance) return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Splits triangle lists into meshlets and culls them against the camera. The meshlets follow the triangle order of the index buffer,
+	/// so running SteelSightMeshOptimizer first gives compact clusters and every meshlet stays one contiguous index range.
+	/// </summary>
+	class SteelSightMeshlets final {
+	public:
+		using Meshlet = SteelSightModel::Meshlet;
+
+		// The usual mesh shader limits, small enough that culling a meshlet saves work and large enough that the culling itself stays cheap
+		static constexpr uint32_t MAX_VERTICES{ 64 };
+		static constexpr uint32_t MAX_TRIANGLES{ 124 };
+
+		// Cone cutoff of meshlets whose triangles face too many directions to ever be backface culled
+		static constexpr float CONE_DISABLED{ 2.f };
+
+		/// <summary>
+		/// Everything needed to cull the meshlets of one object, in the model space of that object.
+		/// </summary>
+		struct Frustum final {
+			// Left, right, bottom, top, near and far plane, a point p is inside when dot(plane.xyz, p) + plane.w >= 0
+			glm::vec4 planes[6]{};
+			glm::vec3 cameraPosition{};
+			bool coneCulling{ false };
+		};
+
+		/// <summary>
+		/// Builds the meshlets greedily in index buffer order, including the bounding sphere and normal cone of every meshlet.
+		/// </summary>
+		/// <param name="vertices">The vertices</param>
+		/// <param name="indices">The triangle list</param>
+		/// <returns>The meshlets, together they cover every triangle exactly once</returns>
+		_NODISCARD static std::vector<Meshlet> build(std::span<const SteelSightModel::Vertex> vertices, std::span<const uint32_t> indices);
+
+		/// <summary>
+		/// Moves the view frustum and camera into the model space of an object, this handles any affine model matrix including non uniform scale.
+		/// </summary>
+		/// <param name="modelMatrix">Model to world transform of the object</param>
+		/// <param name="projectionView">Projection * view of the camera</param>
+		/// <param name="cameraPosition">Camera position in world space</param>
+		/// <param name="coneCulling">Also cull meshlets that face away from the camera</param>
+		_NODISCARD static Frustum makeFrustum(const glm::mat4& modelMatrix, const glm::mat4& projectionView, const glm::vec3& cameraPosition, bool coneCulling) noexcept;
+
+		/// <summary>
+		/// Conservative visibility test, a meshlet that is reported invisible never covers a pixel.
+		/// </summary>
+		_NODISCARD static bool isVisible(const Meshlet& meshlet, const Frustum& frustum) noexcept;
+	};
+}
@@ -1,6 +1,16 @@
 #include "SteelSightModel.hpp"
 #include <stddef.h>
 #include "SteelSightUtils.hpp"
+#include "SteelSightMeshCache.hpp"
+#include "SteelSightMeshOptimizer.hpp"
+#include "SteelSightMeshlets.hpp"
+#include "SteelSightMeshSimplifier.hpp"
+#include "SteelSightMeshCleanup.hpp"
+#include "SteelSightObjStream.hpp"
+#include "SteelSightGltf.hpp"
+#include "SteelSightStl.hpp"
+#include "SteelSightDstv.hpp"
+#include "SteelSightProgressive.hpp"
 
 #include <rapidobj.hpp>
 
@@ -8,9 +18,16 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include <cstring>
 #include <cassert>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
 
 #include <iostream>
 #include <chrono>
@@ -21,20 +38,658 @@ namespace std {
 	struct hash<Voortman::SteelSightModel::Vertex> {
 		_NODISCARD inline size_t operator()(Voortman::SteelSightModel::Vertex const& vertex) const noexcept {
 			size_t seed{0};
-			Voortman::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+			Voortman::hashCombine(seed, vertex.position, vertex.normal, vertex.uv);
 			return seed;
 		}
 	};
 }
 
 namespace Voortman {
-	SteelSightModel::SteelSightModel(SteelSightDevice& device, const SteelSightModel::Builder& builder) : SSDevice{ device } {
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
+	namespace {
+		using Vertex = SteelSightModel::Vertex;
+		using Submesh = SteelSightModel::Submesh;
+
+		// Color of faces without a material
+		constexpr glm::vec4 DEFAULT_MATERIAL{ 0.5f, 0.5f, 0.5f, 1.f };
+
+		// Below this amount of face corners the weld runs on a single thread, starting the workers costs more than it saves
+		constexpr size_t PARALLEL_WELD_MIN_CORNERS{ 1 << 16 };
+
+		// Builds the vertex of face corner i of a shape
+		inline Vertex makeVertex(const rapidobj::Result& result, const rapidobj::Mesh& mesh, size_t i) noexcept {
+			Vertex vertex{};
+
+			const auto& index = mesh.indices[i];
+
+			// Position
+			if (index.position_index >= 0) _LIKELY {
+				vertex.position = {
+					result.attributes.positions[3 * index.position_index + 0],
+					result.attributes.positions[3 * index.position_index + 1],
+					result.attributes.positions[3 * index.position_index + 2]
+				};
+			}
+
+			// Normals
+			if (index.normal_index >= 0) _LIKELY {
+				vertex.normal = {
+					result.attributes.normals[3 * index.normal_index + 0],
+					result.attributes.normals[3 * index.normal_index + 1],
+					result.attributes.normals[3 * index.normal_index + 2]
+				};
+			}
+
+			// Texture Coordinates
+			if (index.texcoord_index >= 0) _LIKELY {
+				vertex.uv = {
+					result.attributes.texcoords[2 * index.texcoord_index + 0],
+					result.attributes.texcoords[2 * index.texcoord_index + 1]
+				};
+			}
+
+			return vertex;
+		}
+
+		// Reports the bounding box of a flat xyz position array to the onBounds callback of a builder
+		void reportBounds(const SteelSightModel::Builder& builder, std::span<const float> positions, size_t stride) {
+			if (!builder.onBounds || positions.size() < 3) return;
+
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+			for (size_t i = 0; i + 2 < positions.size(); i += stride) {
+				const glm::vec3 position{ positions[i], positions[i + 1], positions[i + 2] };
+				minimum = glm::min(minimum, position);
+				maximum = glm::max(maximum, position);
+			}
+			builder.onBounds(minimum, maximum);
+		}
+
+		// Reports the bounding box of the positions of welded vertices, a mesh without vertices reports nothing
+		void reportBounds(const SteelSightModel::Builder& builder, std::span<const Vertex> vertices) {
+			if (vertices.empty()) return;
+
+			constexpr size_t stride = sizeof(Vertex) / sizeof(float);
+			reportBounds(builder, { &vertices.front().position.x, (vertices.size() - 1) * stride + 3 }, stride);
+		}
+
+		// Writes the progressive file of a model after a load, a model that cannot be written is still loaded
+		void writeProgressive(const std::string& filepath, const SteelSightModel::Builder& builder, std::chrono::microseconds loadTime) {
+			const std::string progressivePath = SteelSightProgressive::getProgressivePath(filepath);
+			try {
+				const auto batches = SteelSightProgressive::write(progressivePath, builder, loadTime);
+				std::cout << "Progressive file written to " << progressivePath << ": " << batches.size() << " batches, base mesh " << batches.front().indexCount / 3
+					<< " of " << builder.getIndices().size() / 3 << " triangles" << std::endl;
+			}
+			catch (const std::exception& exception) {
+				std::cerr << "Progressive file not written: " << exception.what() << std::endl;
+			}
+		}
+
+		// Sphere around the center of the bounding box, xyz is the center and w the radius
+		glm::vec4 computeBoundingSphere(std::span<const Vertex> vertices) noexcept {
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+			for (const auto& vertex : vertices) {
+				minimum = glm::min(minimum, vertex.position);
+				maximum = glm::max(maximum, vertex.position);
+			}
+			if (vertices.empty()) _UNLIKELY return glm::vec4{ 0.f };
+
+			const glm::vec3 center = (minimum + maximum) * 0.5f;
+			float radiusSquared{ 0.f };
+			for (const auto& vertex : vertices) radiusSquared = std::max(radiusSquared, glm::dot(vertex.position - center, vertex.position - center));
+			return glm::vec4{ center, std::sqrt(radiusSquared) };
+		}
+
+		// Same sphere around only the vertices a triangle list uses
+		glm::vec4 computeBoundingSphere(std::span<const Vertex> vertices, std::span<const uint32_t> indices) noexcept {
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+			for (const uint32_t index : indices) {
+				minimum = glm::min(minimum, vertices[index].position);
+				maximum = glm::max(maximum, vertices[index].position);
+			}
+			if (indices.empty()) _UNLIKELY return glm::vec4{ 0.f };
+
+			const glm::vec3 center = (minimum + maximum) * 0.5f;
+			float radiusSquared{ 0.f };
+			for (const uint32_t index : indices) radiusSquared = std::max(radiusSquared, glm::dot(vertices[index].position - center, vertices[index].position - center));
+			return glm::vec4{ center, std::sqrt(radiusSquared) };
+		}
+
+		// Octahedral normal encoding (Meyer et al. 2010), both components in [-1, 1]
+		glm::vec2 encodeOctahedral(const glm::vec3& normal) noexcept {
+			const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			if (length == 0.f) _UNLIKELY return glm::vec2{ 0.f };
+
+			const glm::vec3 n = normal / length;
+			if (n.z >= 0.f) return glm::vec2{ n.x, n.y };
+
+			return glm::vec2{
+				(1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f),
+				(1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f)
+			};
+		}
+
+		// Same decode as simple_shader_compact.vert
+		glm::vec3 decodeOctahedral(const glm::vec2& encoded) noexcept {
+			glm::vec3 n{ encoded.x, encoded.y, 1.f - std::abs(encoded.x) - std::abs(encoded.y) };
+			const float t = std::max(-n.z, 0.f);
+			n.x += n.x >= 0.f ? -t : t;
+			n.y += n.y >= 0.f ? -t : t;
+			return glm::normalize(n);
+		}
+
+		// Quantization range of compact positions, a flat axis still needs a non zero scale
+		glm::vec3 compactExtent(const glm::vec3& minimum, const glm::vec3& maximum) noexcept {
+			glm::vec3 extent = maximum - minimum;
+			for (int axis = 0; axis < 3; ++axis) if (extent[axis] <= 0.f) extent[axis] = 1.f;
+			return extent;
+		}
+
+		SteelSightModel::CompactVertex encodeCompact(const Vertex& vertex, const glm::vec3& minimum, const glm::vec3& extent) noexcept {
+			SteelSightModel::CompactVertex compact{};
+
+			const glm::vec3 normalized = glm::clamp((vertex.position - minimum) / extent, 0.f, 1.f);
+			for (int axis = 0; axis < 3; ++axis) compact.position[axis] = static_cast<uint16_t>(std::lround(normalized[axis] * UINT16_MAX));
+
+			const glm::vec2 octahedral = encodeOctahedral(vertex.normal);
+			compact.normal[0] = static_cast<int16_t>(std::lround(octahedral.x * INT16_MAX));
+			compact.normal[1] = static_cast<int16_t>(std::lround(octahedral.y * INT16_MAX));
+
+			compact.uv[0] = static_cast<uint16_t>(glm::packHalf1x16(vertex.uv.x));
+			compact.uv[1] = static_cast<uint16_t>(glm::packHalf1x16(vertex.uv.y));
+			return compact;
+		}
+
+		// The flat layouts are the full and the compact vertex without the normal
+		SteelSightModel::FlatVertex stripNormal(const Vertex& vertex) noexcept {
+			return { vertex.position, vertex.uv };
+		}
+
+		SteelSightModel::CompactFlatVertex stripNormal(const SteelSightModel::CompactVertex& vertex) noexcept {
+			SteelSightModel::CompactFlatVertex flat{};
+			std::copy(std::begin(vertex.position), std::end(vertex.position), flat.position);
+			std::copy(std::begin(vertex.uv), std::end(vertex.uv), flat.uv);
+			return flat;
+		}
+
+		template <typename Source>
+		auto stripNormals(std::span<const Source> vertices) {
+			std::vector<decltype(stripNormal(std::declval<const Source&>()))> flat(vertices.size());
+			for (size_t v = 0; v < vertices.size(); ++v) flat[v] = stripNormal(vertices[v]);
+			return flat;
+		}
+
+		uint32_t getVertexStride(SteelSightModel::VertexFormat format, bool flat) noexcept {
+			if (format == SteelSightModel::VertexFormat::Compact) return flat ? sizeof(SteelSightModel::CompactFlatVertex) : sizeof(SteelSightModel::CompactVertex);
+			return flat ? sizeof(SteelSightModel::FlatVertex) : sizeof(Vertex);
+		}
+
+		/// <summary>
+		/// Collects the diffuse color of every material and the material of every triangle, in the order the welds emit the triangles.
+		/// Rapidobj does not support vertex colors, the colors come from the .mtl files. Faces without a material get DEFAULT_MATERIAL behind the OBJ materials.
+		/// </summary>
+		void collectMaterials(const rapidobj::Result& result, std::vector<glm::vec4>& materials, std::vector<uint32_t>& triangleMaterials) {
+			materials.clear();
+			for (const auto& material : result.materials) materials.emplace_back(material.diffuse[0], material.diffuse[1], material.diffuse[2], 1.f);
+
+			const uint32_t defaultMaterial = static_cast<uint32_t>(materials.size());
+			bool usesDefault{ false };
+
+			triangleMaterials.clear();
+			for (const auto& shape : result.shapes) {
+				const size_t triangleCount = shape.mesh.indices.size() / 3;
+				for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+					const int32_t material = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[triangle];
+					usesDefault |= material < 0;
+					triangleMaterials.push_back(material >= 0 ? static_cast<uint32_t>(material) : defaultMaterial);
+				}
+			}
+
+			if (usesDefault || materials.empty()) materials.push_back(DEFAULT_MATERIAL);
+		}
+
+		/// <summary>
+		/// Sorts the triangles of an index range by material, keeping their order within a material, and appends one submesh per material that is used.
+		/// </summary>
+		/// <param name="indices">The triangle list of one level of detail</param>
+		/// <param name="triangleMaterials">Material of every triangle of indices</param>
+		/// <param name="firstIndex">Position of indices in the index buffer of the model</param>
+		/// <param name="submeshes">Receives the submeshes</param>
+		void groupByMaterial(std::span<uint32_t> indices, std::span<const uint32_t> triangleMaterials, uint32_t firstIndex, std::vector<Submesh>& submeshes) {
+			const size_t triangleCount = indices.size() / 3;
+
+			std::vector<uint32_t> order(triangleCount);
+			for (uint32_t triangle = 0; triangle < order.size(); ++triangle) order[triangle] = triangle;
+			std::stable_sort(order.begin(), order.end(), [&triangleMaterials](uint32_t a, uint32_t b) { return triangleMaterials[a] < triangleMaterials[b]; });
+
+			const std::vector<uint32_t> unsorted(indices.begin(), indices.end());
+			for (size_t i = 0; i < triangleCount; ++i) {
+				const uint32_t triangle = order[i];
+				for (size_t corner = 0; corner < 3; ++corner) indices[3 * i + corner] = unsorted[3 * triangle + corner];
+
+				if (i == 0 || triangleMaterials[triangle] != triangleMaterials[order[i - 1]]) {
+					Submesh submesh{};
+					submesh.firstIndex = firstIndex + static_cast<uint32_t>(3 * i);
+					submesh.material = triangleMaterials[triangle];
+					submeshes.push_back(submesh);
+				}
+				submeshes.back().indexCount += 3;
+			}
+		}
+
+		// A corner farther than this fraction of the largest distance from the center of a shape may define an axis of its canonical frame
+		constexpr float INSTANCE_AXIS_THRESHOLD{ 0.5f };
+
+		// Two shapes are copies when their canonical positions differ less than this fraction of their radius
+		constexpr float INSTANCE_TOLERANCE{ 1e-4f };
+		constexpr float INSTANCE_NORMAL_TOLERANCE{ 1e-3f };
+
+		/// <summary>
+		/// Rigid frame of a shape that only depends on the shape itself: the origin is the mean of its corners, the first axis points to the first corner far from the origin
+		/// and the second axis to the first corner far from the first axis. Copies of a shape list their corners in the same order, so a rotated and moved copy has the same canonical corners.
+		/// </summary>
+		struct ShapeFrame final {
+			// Canonical space to model space
+			glm::mat4 frame{ 1.f };
+			float radius{ 0.f };
+			// Hash of everything the transform does not change: the corner count, which corners share a position, the materials and the size
+			uint64_t hash{ 0 };
+			bool valid{ false };
+		};
+
+		ShapeFrame computeShapeFrame(const rapidobj::Result& result, const rapidobj::Mesh& mesh) {
+			ShapeFrame shape{};
+			const size_t cornerCount = mesh.indices.size();
+			if (cornerCount < 3) _UNLIKELY return shape;
+
+			glm::dvec3 sum{ 0.0 };
+			for (size_t i = 0; i < cornerCount; ++i) sum += glm::dvec3{ makeVertex(result, mesh, i).position };
+			const glm::vec3 center{ sum / static_cast<double>(cornerCount) };
+
+			for (size_t i = 0; i < cornerCount; ++i) shape.radius = std::max(shape.radius, glm::length(makeVertex(result, mesh, i).position - center));
+			if (shape.radius == 0.f) _UNLIKELY return shape;
+
+			glm::vec3 x{ 0.f };
+			for (size_t i = 0; i < cornerCount; ++i) {
+				const glm::vec3 offset = makeVertex(result, mesh, i).position - center;
+				if (glm::length(offset) < INSTANCE_AXIS_THRESHOLD * shape.radius) continue;
+
+				x = glm::normalize(offset);
+				break;
+			}
+
+			auto perpendicular = [&](size_t i) {
+				const glm::vec3 offset = makeVertex(result, mesh, i).position - center;
+				return offset - glm::dot(offset, x) * x;
+			};
+
+			float maximumPerpendicular{ 0.f };
+			for (size_t i = 0; i < cornerCount; ++i) maximumPerpendicular = std::max(maximumPerpendicular, glm::length(perpendicular(i)));
+
+			// A shape that is a line has no second axis, it is never instanced
+			if (maximumPerpendicular <= INSTANCE_TOLERANCE * shape.radius) _UNLIKELY return shape;
+
+			glm::vec3 y{ 0.f };
+			for (size_t i = 0; i < cornerCount; ++i) {
+				const glm::vec3 offset = perpendicular(i);
+				if (glm::length(offset) < INSTANCE_AXIS_THRESHOLD * maximumPerpendicular) continue;
+
+				y = glm::normalize(offset);
+				break;
+			}
+
+			shape.frame = glm::mat4{ glm::vec4{ x, 0.f }, glm::vec4{ y, 0.f }, glm::vec4{ glm::cross(x, y), 0.f }, glm::vec4{ center, 1.f } };
+			shape.valid = true;
+
+			// The canonical positions are compared with a tolerance afterwards, only exact properties are hashed.
+			// The radius is rounded on a logarithmic scale, copies only differ in the last bits so they practically never round apart
+			size_t seed{ cornerCount };
+			hashCombine(seed, static_cast<int32_t>(std::round(std::log2(shape.radius) * 64.f)));
+
+			ankerl::unordered_dense::map<int32_t, uint32_t> localPositions{};
+			for (size_t i = 0; i < cornerCount; ++i) {
+				auto [it, inserted] = localPositions.try_emplace(mesh.indices[i].position_index, static_cast<uint32_t>(localPositions.size()));
+				hashCombine(seed, it->second);
+			}
+			for (const int32_t material : mesh.material_ids) hashCombine(seed, material);
+
+			shape.hash = seed;
+			return shape;
+		}
+
+		// Inverse of a frame without scale
+		glm::mat4 inverseRigid(const glm::mat4& frame) noexcept {
+			const glm::mat3 rotation = glm::transpose(glm::mat3{ frame });
+			glm::mat4 inverse{ rotation };
+			inverse[3] = glm::vec4{ -(rotation * glm::vec3{ frame[3] }), 1.f };
+			return inverse;
+		}
+
+		// True when shape b is a rigidly transformed copy of shape a with the same materials
+		bool isCopy(const rapidobj::Result& result, const rapidobj::Mesh& a, const ShapeFrame& frameA, const rapidobj::Mesh& b, const ShapeFrame& frameB) {
+			if (a.indices.size() != b.indices.size() || !std::equal(a.material_ids.begin(), a.material_ids.end(), b.material_ids.begin(), b.material_ids.end())) return false;
+
+			// Far from the origin the float precision of the positions limits how close two copies can be
+			const float magnitude = std::max(glm::length(glm::vec3{ frameA.frame[3] }), glm::length(glm::vec3{ frameB.frame[3] })) + frameA.radius;
+			const float tolerance = INSTANCE_TOLERANCE * frameA.radius + 16.f * std::numeric_limits<float>::epsilon() * magnitude;
+
+			const glm::mat4 toA = inverseRigid(frameA.frame);
+			const glm::mat4 toB = inverseRigid(frameB.frame);
+			for (size_t i = 0; i < a.indices.size(); ++i) {
+				const Vertex vertexA = makeVertex(result, a, i);
+				const Vertex vertexB = makeVertex(result, b, i);
+
+				if (glm::length(glm::vec3{ toA * glm::vec4{ vertexA.position, 1.f } } - glm::vec3{ toB * glm::vec4{ vertexB.position, 1.f } }) > tolerance) return false;
+				if (glm::length(glm::mat3{ toA } * vertexA.normal - glm::mat3{ toB } * vertexB.normal) > INSTANCE_NORMAL_TOLERANCE) return false;
+				if (vertexA.uv != vertexB.uv) return false;
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Finds the shapes that are rigid copies of an earlier shape and removes them from the result, so the weld only sees one copy of every repeated shape.
+		/// The remaining shapes are reordered into parts: part 0 holds every shape that occurs once (when there is one), every following part one repeated shape.
+		/// </summary>
+		/// <param name="result">The parsed file, its shapes are reordered and the copies removed</param>
+		/// <param name="workerCount">Threads used to compute the frames of the shapes</param>
+		/// <param name="instances">Receives one instance per part occurrence</param>
+		/// <returns>The face corner count of every part, in the new shape order</returns>
+		std::vector<size_t> extractInstances(rapidobj::Result& result, uint32_t workerCount, std::vector<SteelSightModel::Instance>& instances) {
+			const size_t shapeCount = result.shapes.size();
+
+			std::vector<ShapeFrame> frames(shapeCount);
+			parallelFor(shapeCount, std::min<uint32_t>(workerCount, static_cast<uint32_t>(std::max<size_t>(shapeCount, 1))), [&](size_t begin, size_t end, uint32_t) {
+				for (size_t shape = begin; shape < end; ++shape) frames[shape] = computeShapeFrame(result, result.shapes[shape].mesh);
+			});
+
+			// Every group starts with the shape that keeps its geometry, the hash only narrows down the groups a shape is compared with
+			std::vector<std::vector<uint32_t>> groups{};
+			ankerl::unordered_dense::map<uint64_t, std::vector<uint32_t>> groupsByHash{};
+
+			for (uint32_t shape = 0; shape < shapeCount; ++shape) {
+				if (frames[shape].valid) _LIKELY {
+					auto& candidates = groupsByHash[frames[shape].hash];
+
+					bool found{ false };
+					for (const uint32_t group : candidates) {
+						const uint32_t first = groups[group].front();
+						if (!isCopy(result, result.shapes[first].mesh, frames[first], result.shapes[shape].mesh, frames[shape])) continue;
+
+						groups[group].push_back(shape);
+						found = true;
+						break;
+					}
+					if (found) continue;
+
+					candidates.push_back(static_cast<uint32_t>(groups.size()));
+				}
+				groups.push_back({ shape });
+			}
+
+			std::vector<rapidobj::Shape> shapes{};
+			std::vector<size_t> partCorners{};
+			instances.clear();
+
+			size_t uniqueCorners{ 0 };
+			for (const auto& group : groups) {
+				if (group.size() > 1) continue;
+
+				uniqueCorners += result.shapes[group.front()].mesh.indices.size();
+				shapes.push_back(std::move(result.shapes[group.front()]));
+			}
+			if (!shapes.empty()) {
+				partCorners.push_back(uniqueCorners);
+				instances.push_back({});
+			}
+
+			for (const auto& group : groups) {
+				if (group.size() == 1) continue;
+
+				const uint32_t part = static_cast<uint32_t>(partCorners.size());
+				const glm::mat4 toPrototype = inverseRigid(frames[group.front()].frame);
+
+				instances.push_back({ glm::mat4{ 1.f }, part });
+				for (size_t copy = 1; copy < group.size(); ++copy) instances.push_back({ frames[group[copy]].frame * toPrototype, part });
+
+				partCorners.push_back(result.shapes[group.front()].mesh.indices.size());
+				shapes.push_back(std::move(result.shapes[group.front()]));
+			}
+
+			result.shapes = std::move(shapes);
+			return partCorners;
+		}
+
+		// The bounding sphere of a part placed by an instance, the radius grows with the largest scale of the transform
+		glm::vec4 transformSphere(const glm::mat4& transform, const glm::vec4& sphere) noexcept {
+			const float scale = std::max({ glm::length(glm::vec3{ transform[0] }), glm::length(glm::vec3{ transform[1] }), glm::length(glm::vec3{ transform[2] }) });
+			return glm::vec4{ glm::vec3{ transform * glm::vec4{ glm::vec3{ sphere }, 1.f } }, sphere.w * scale };
+		}
+
+		// Sphere around every instance of the parts
+		glm::vec4 computeInstanceSphere(std::span<const SteelSightModel::Part> parts, std::span<const SteelSightModel::Instance> instances) noexcept {
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+			for (const auto& instance : instances) {
+				const glm::vec4 sphere = transformSphere(instance.transform, parts[instance.part].boundingSphere);
+				minimum = glm::min(minimum, glm::vec3{ sphere } - sphere.w);
+				maximum = glm::max(maximum, glm::vec3{ sphere } + sphere.w);
+			}
+			if (instances.empty()) _UNLIKELY return glm::vec4{ 0.f };
+
+			const glm::vec3 center = (minimum + maximum) * 0.5f;
+			float radius{ 0.f };
+			for (const auto& instance : instances) {
+				const glm::vec4 sphere = transformSphere(instance.transform, parts[instance.part].boundingSphere);
+				radius = std::max(radius, glm::length(glm::vec3{ sphere } - center) + sphere.w);
+			}
+			return glm::vec4{ center, radius };
+		}
+
+		// The OBJ attribute indices of a face corner, corners with the same key always produce the same vertex.
+		// The material is not part of the key, faces of different materials share their vertices
+		struct CornerKey final {
+			int32_t position{ -1 };
+			int32_t normal{ -1 };
+			int32_t texcoord{ -1 };
+
+			_NODISCARD inline bool operator==(const CornerKey& other) const noexcept = default;
+		};
+
+		struct CornerKeyHash final {
+			using is_avalanching = void;
+			_NODISCARD inline uint64_t operator()(const CornerKey& key) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(&key, sizeof(CornerKey)); }
+		};
+
+		inline CornerKey makeCornerKey(const rapidobj::Mesh& mesh, size_t i) noexcept {
+			const auto& index = mesh.indices[i];
+			return { index.position_index, index.normal_index, index.texcoord_index };
+		}
+
+		// Hash used to shard and look up the corners in the parallel weld
+		_NODISCARD inline uint64_t hashKey(const Vertex& vertex) noexcept { return ankerl::unordered_dense::detail::wyhash::hash(std::hash<Vertex>{}(vertex)); }
+		_NODISCARD inline uint64_t hashKey(const CornerKey& key) noexcept { return CornerKeyHash{}(key); }
+
+		void weldSerial(const rapidobj::Result& result, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+			// Significantly faster than std::unordered_map
+			ankerl::unordered_dense::map<Vertex, uint32_t> uniqueVertices{};
+
+			for (const auto& shape : result.shapes) _LIKELY {
+				for (size_t i = 0; i < shape.mesh.indices.size(); ++i) _LIKELY {
+					Vertex vertex = makeVertex(result, shape.mesh, i);
+
+					// Check for unique vertex and update indices
+					auto [it, inserted] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(vertices.size()));
+					if (inserted) _LIKELY vertices.push_back(vertex);
+					indices.push_back(it->second);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Merges vertices with equal values, keeping the first one. Vertices that come from different OBJ attribute indices can still be equal,
+		/// running this after the index tuple weld makes its output identical to the weld on full vertices.
+		/// </summary>
+		void mergeEqualVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t workerCount) {
+			ankerl::unordered_dense::map<Vertex, uint32_t> uniqueVertices{};
+			uniqueVertices.reserve(vertices.size());
+
+			std::vector<uint32_t> remap(vertices.size());
+			uint32_t count{ 0 };
+
+			for (size_t v = 0; v < vertices.size(); ++v) {
+				auto [it, inserted] = uniqueVertices.try_emplace(vertices[v], count);
+				if (inserted) vertices[count++] = vertices[v];
+				remap[v] = it->second;
+			}
+
+			// Nothing merged, the indices are already correct
+			if (count == vertices.size()) _LIKELY return;
+
+			vertices.resize(count);
+			parallelFor(indices.size(), indices.size() >= PARALLEL_WELD_MIN_CORNERS ? workerCount : 1, [&](size_t begin, size_t end, uint32_t) {
+				for (size_t i = begin; i < end; ++i) indices[i] = remap[indices[i]];
+			});
+		}
+
+		/// <summary>
+		/// Welds on the packed OBJ index tuple of every corner, so only one small key is hashed per corner and every unique vertex is built once.
+		/// </summary>
+		void weldSerialTuples(const rapidobj::Result& result, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+			ankerl::unordered_dense::map<CornerKey, uint32_t, CornerKeyHash> uniqueCorners{};
+
+			for (const auto& shape : result.shapes) _LIKELY {
+				for (size_t i = 0; i < shape.mesh.indices.size(); ++i) _LIKELY {
+					auto [it, inserted] = uniqueCorners.try_emplace(makeCornerKey(shape.mesh, i), static_cast<uint32_t>(vertices.size()));
+					if (inserted) _UNLIKELY vertices.push_back(makeVertex(result, shape.mesh, i));
+					indices.push_back(it->second);
+				}
+			}
+
+			mergeEqualVertices(vertices, indices, 1);
+		}
+
+		/// <summary>
+		/// Welds the face corners of every shape on multiple threads with weldParallel, the result is identical to the serial weld on the same key.
+		/// Only the first corner of every unique key is turned into a vertex.
+		/// </summary>
+		/// <typeparam name="Key">Vertex to weld on the full vertex, CornerKey to weld on the OBJ index tuple</typeparam>
+		template <typename Key, typename MakeKey>
+		void weldShapesParallel(const rapidobj::Result& result, size_t cornerCount, uint32_t workerCount, MakeKey&& makeKey, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+			// Start of every shape in the flattened corner array
+			std::vector<size_t> shapeOffsets{};
+			shapeOffsets.reserve(result.shapes.size() + 1);
+			shapeOffsets.push_back(0);
+			for (const auto& shape : result.shapes) shapeOffsets.push_back(shapeOffsets.back() + shape.mesh.indices.size());
+
+			auto findShape = [&](size_t corner) -> size_t {
+				return std::upper_bound(shapeOffsets.begin(), shapeOffsets.end(), corner) - shapeOffsets.begin() - 1;
+			};
+
+			std::vector<Key> keys(cornerCount);
+			parallelFor(cornerCount, workerCount, [&](size_t begin, size_t end, uint32_t) {
+				if (begin >= end) return;
+
+				size_t shape = findShape(begin);
+				for (size_t corner = begin; corner < end; ++corner) {
+					while (corner >= shapeOffsets[shape + 1]) ++shape;
+					keys[corner] = makeKey(result.shapes[shape].mesh, corner - shapeOffsets[shape]);
+				}
+			});
+
+			std::vector<uint32_t> vertexCorners{};
+			weldParallel(keys, workerCount, [](const Key& key) { return hashKey(key); }, indices, vertexCorners);
+
+			// The first corners are ascending, so every range walks the shapes forward
+			vertices.resize(vertexCorners.size());
+			parallelFor(vertexCorners.size(), workerCount, [&](size_t begin, size_t end, uint32_t) {
+				if (begin >= end) return;
+
+				size_t shape = findShape(vertexCorners[begin]);
+				for (size_t vertex = begin; vertex < end; ++vertex) {
+					const uint32_t corner = vertexCorners[vertex];
+					if constexpr (std::is_same_v<Key, Vertex>) {
+						vertices[vertex] = keys[corner];
+					}
+					else {
+						// Only the unique index tuples are turned into a vertex
+						while (corner >= shapeOffsets[shape + 1]) ++shape;
+						vertices[vertex] = makeVertex(result, result.shapes[shape].mesh, corner - shapeOffsets[shape]);
+					}
+				}
+			});
+
+			if constexpr (!std::is_same_v<Key, Vertex>) {
+				mergeEqualVertices(vertices, indices, workerCount);
+			}
+		}
+	}
+
+	SteelSightModel::SteelSightModel(SteelSightDevice& device, const SteelSightModel::Builder& builder) : SteelSightModel{ device, builder, nullptr } {}
+
+	SteelSightModel::SteelSightModel(SteelSightDevice& device, const SteelSightModel::Builder& builder, const SteelSightModel* previous) : SSDevice{ device } {
+		// The vertices and indices go out in one submission, the loader hands the model over without waiting for the copies
+		SteelSightUploadBatch batch{ SSDevice };
+		createVertexBuffers(builder.getVertices(), builder.options.vertexFormat, builder.options.flatShading, previous, batch);
+		createIndexBuffers(builder.getIndices(), previous, batch);
+		uploadToken = batch.submit();
+
+		assignTables(builder);
+	}
+
+	SteelSightModel::SteelSightModel(SteelSightDevice& device, const SteelSightModel::Builder& layout, uint32_t vertexCount, uint32_t indexCount, uint32_t batchCount, const glm::vec3& minimum, const glm::vec3& maximum)
+		: SSDevice{ device }, vertexCount{ vertexCount }, hasIndexBuffer{ true }, indexCount{ indexCount }, batchCount{ batchCount }, streamedBatches{ 0 } {
+		if (vertexCount == 0 || indexCount == 0 || batchCount == 0) _UNLIKELY throw std::runtime_error("a progressive model needs vertices, indices and batches");
+
+		// The compact range comes from the bounds of the whole model, the batches are encoded against it as they arrive
+		vertexFormat = layout.options.vertexFormat;
+		flatShading = layout.options.flatShading;
+		if (vertexFormat == VertexFormat::Compact) dequantization = glm::scale(glm::translate(glm::mat4{ 1.f }, minimum), compactExtent(minimum, maximum));
+
+		const uint32_t vertexSize = getVertexStride(vertexFormat, flatShading);
+		vertexRange = SSDevice.getGeometryPool().allocateVertices(vertexSize, vertexCount);
+		indexRange = SSDevice.getGeometryPool().allocateIndices(indexCount);
+
+		assignTables(layout);
+	}
+
+	void SteelSightModel::assignTables(const SteelSightModel::Builder& builder) {
+		// The meshlets are culled on the CPU every frame, so they are kept after the builder and its cache mapping are gone
+		const auto builderMeshlets = builder.getMeshlets();
+		meshlets.assign(builderMeshlets.begin(), builderMeshlets.end());
+		meshletConeCulling = builder.options.meshletConeCulling;
+
+		const auto builderMaterials = builder.getMaterials();
+		materials.assign(builderMaterials.begin(), builderMaterials.end());
+		if (materials.empty()) _UNLIKELY materials.push_back(DEFAULT_MATERIAL);
+
+		const auto builderSubmeshes = builder.getSubmeshes();
+		submeshes.assign(builderSubmeshes.begin(), builderSubmeshes.end());
+		if (submeshes.empty()) _UNLIKELY submeshes.push_back({ 0, indexCount, 0 });
+
+		const auto builderLods = builder.getLods();
+		lods.assign(builderLods.begin(), builderLods.end());
+		if (lods.empty()) _UNLIKELY lods.push_back({ 0, indexCount, 0.f, 0, static_cast<uint32_t>(submeshes.size()) });
+
+		const auto builderParts = builder.getParts();
+		parts.assign(builderParts.begin(), builderParts.end());
+		if (parts.empty()) _UNLIKELY parts.push_back({ computeBoundingSphere(builder.getVertices()), 0, static_cast<uint32_t>(lods.size()) });
+
+		const auto builderInstances = builder.getInstances();
+		instances.assign(builderInstances.begin(), builderInstances.end());
+		if (instances.empty()) _UNLIKELY instances.push_back({});
+
+		boundingSphere = computeInstanceSphere(parts, instances);
 	}
 
 	std::unique_ptr<SteelSightModel> SteelSightModel::createModelFromFile(SteelSightDevice& device, const std::string& filepath) {
+		return createModelFromFile(device, filepath, LoadOptions{});
+	}
+
+	std::unique_ptr<SteelSightModel> SteelSightModel::createModelFromFile(SteelSightDevice& device, const std::string& filepath, const LoadOptions& options) {
 		Builder builder{};
+		builder.options = options;
 		builder.loadModel(filepath);
 
 		// show the amount of vertices into the console
@@ -43,55 +698,329 @@ namespace Voortman {
 		return std::make_unique<SteelSightModel>(device, builder);
 	}
 
-	void SteelSightModel::bind(VkCommandBuffer commandBuffer) {
-		VkBuffer buffers[] = { vertexBuffer->getBuffer() };
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+	std::unique_ptr<SteelSightModel> SteelSightModel::createUnitBox(SteelSightDevice& device) {
+		Builder builder{};
+
+		// Four vertices per face so every face has its own normal
+		const glm::vec3 normals[6]{ { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f } };
+		for (const auto& normal : normals) {
+			// Two axes spanning the face, ordered so the corners run counter clockwise seen from outside
+			const glm::vec3 u = normal.x != 0.f ? glm::vec3{ 0.f, 1.f, 0.f } : glm::vec3{ 1.f, 0.f, 0.f };
+			const glm::vec3 v = glm::abs(glm::cross(normal, u));
+			const glm::vec3 origin = glm::max(normal, glm::vec3{ 0.f });
+			const bool flip = glm::dot(glm::cross(u, v), normal) < 0.f;
+
+			const uint32_t first = static_cast<uint32_t>(builder.vertices.size());
+			for (const glm::vec2 corner : { glm::vec2{ 0.f, 0.f }, glm::vec2{ 1.f, 0.f }, glm::vec2{ 1.f, 1.f }, glm::vec2{ 0.f, 1.f } }) {
+				builder.vertices.push_back({ origin + u * corner.x + v * corner.y, normal, corner });
+			}
+
+			const uint32_t quad[6]{ 0, 1, 2, 0, 2, 3 };
+			for (size_t i = 0; i < 6; ++i) builder.indices.push_back(first + quad[flip ? 5 - i : i]);
+		}
+
+		builder.materials.push_back(DEFAULT_MATERIAL);
+		return std::make_unique<SteelSightModel>(device, builder);
+	}
+
+	void SteelSightModel::swapContents(SteelSightModel& other) noexcept {
+		std::swap(vertexRange, other.vertexRange);
+		std::swap(vertexCount, other.vertexCount);
+		std::swap(hasIndexBuffer, other.hasIndexBuffer);
+		std::swap(indexRange, other.indexRange);
+		std::swap(indexCount, other.indexCount);
+		std::swap(vertexHash, other.vertexHash);
+		std::swap(indexHash, other.indexHash);
+		std::swap(vertexBufferReused, other.vertexBufferReused);
+		std::swap(indexBufferReused, other.indexBufferReused);
+		std::swap(uploadToken, other.uploadToken);
+		std::swap(meshlets, other.meshlets);
+		std::swap(meshletConeCulling, other.meshletConeCulling);
+		std::swap(lods, other.lods);
+		std::swap(submeshes, other.submeshes);
+		std::swap(parts, other.parts);
+		std::swap(instances, other.instances);
+		std::swap(boundingSphere, other.boundingSphere);
+		std::swap(vertexFormat, other.vertexFormat);
+		std::swap(flatShading, other.flatShading);
+		std::swap(dequantization, other.dequantization);
+		std::swap(materials, other.materials);
+		std::swap(batchCount, other.batchCount);
+		const uint32_t streamed = streamedBatches.load(std::memory_order_acquire);
+		streamedBatches.store(other.streamedBatches.load(std::memory_order_acquire), std::memory_order_release);
+		other.streamedBatches.store(streamed, std::memory_order_release);
+	}
+
+	void SteelSightModel::uploadBatch(std::span<const Vertex> vertices, uint32_t firstVertex, std::span<const uint32_t> indices, uint32_t firstIndex) {
+		if (firstVertex + static_cast<uint64_t>(vertices.size()) > vertexCount || firstIndex + static_cast<uint64_t>(indices.size()) > indexCount) _UNLIKELY {
+			throw std::out_of_range("progressive batch outside of the model buffers");
+		}
+
+		SteelSightUploadBatch batch{ SSDevice };
+		if (!vertices.empty()) _LIKELY {
+			if (vertexFormat == VertexFormat::Compact) {
+				const glm::vec3 minimum{ dequantization[3] };
+				const glm::vec3 extent{ dequantization[0][0], dequantization[1][1], dequantization[2][2] };
+
+				std::vector<CompactVertex> compactVertices(vertices.size());
+				for (size_t v = 0; v < vertices.size(); ++v) compactVertices[v] = encodeCompact(vertices[v], minimum, extent);
+
+				if (flatShading) {
+					const auto flatVertices = stripNormals(std::span<const CompactVertex>{ compactVertices });
+					uploadRange(batch, *vertexRange, flatVertices.data(), sizeof(CompactFlatVertex), static_cast<uint32_t>(flatVertices.size()), firstVertex);
+				}
+				else {
+					uploadRange(batch, *vertexRange, compactVertices.data(), sizeof(CompactVertex), static_cast<uint32_t>(compactVertices.size()), firstVertex);
+				}
+			}
+			else if (flatShading) {
+				const auto flatVertices = stripNormals(vertices);
+				uploadRange(batch, *vertexRange, flatVertices.data(), sizeof(FlatVertex), static_cast<uint32_t>(flatVertices.size()), firstVertex);
+			}
+			else {
+				uploadRange(batch, *vertexRange, vertices.data(), sizeof(Vertex), static_cast<uint32_t>(vertices.size()), firstVertex);
+			}
+		}
+
+		if (!indices.empty()) _LIKELY uploadRange(batch, *indexRange, indices.data(), sizeof(uint32_t), static_cast<uint32_t>(indices.size()), firstIndex);
+
+		// The base mesh is polled before the model is drawn at all. A finer level is drawn as soon as the render thread sees the new count,
+		// so it is only counted by the render thread once the upload is complete and the loader goes on with the next batch
+		const SteelSightUploadToken token = batch.submit();
+		if (streamedBatches.load(std::memory_order_acquire) == 0) {
+			uploadToken = token;
+			streamedBatches.store(1, std::memory_order_release);
+			return;
+		}
+
+		std::lock_guard lock{ streamMutex };
+		pendingBatches.push_back(token);
+	}
+
+	void SteelSightModel::updateStreaming() {
+		std::lock_guard lock{ streamMutex };
+
+		// Uploads complete in submission order, a batch is never counted before the ones it builds on
+		size_t complete{ 0 };
+		while (complete < pendingBatches.size() && pendingBatches[complete].isComplete()) ++complete;
+		if (complete == 0) return;
+
+		pendingBatches.erase(pendingBatches.begin(), pendingBatches.begin() + static_cast<std::ptrdiff_t>(complete));
+		streamedBatches.fetch_add(static_cast<uint32_t>(complete), std::memory_order_release);
+	}
+
+	void SteelSightModel::uploadRange(SteelSightUploadBatch& batch, const SteelSightGeometryRange& range, const void* data, uint32_t elementSize, uint32_t count, uint32_t firstElement) {
+		const VkDeviceSize size = static_cast<VkDeviceSize>(elementSize) * count;
+		range.upload(batch, data, size, static_cast<VkDeviceSize>(elementSize) * firstElement);
+	}
+
+	VkDeviceSize SteelSightModel::getGpuMemorySize() const noexcept {
+		VkDeviceSize size = vertexRange->getSize();
+		if (hasIndexBuffer) _LIKELY size += indexRange->getSize();
+		return size;
+	}
+
+	int32_t SteelSightModel::getVertexOffset() const noexcept {
+		return static_cast<int32_t>(vertexRange->getFirstElement(getVertexStride(vertexFormat, flatShading)));
+	}
+
+	uint32_t SteelSightModel::getIndexOffset() const noexcept {
+		return hasIndexBuffer ? indexRange->getFirstElement(sizeof(uint32_t)) : 0;
+	}
+
+	void SteelSightModel::bind(VkCommandBuffer commandBuffer, SteelSightGeometryBinding& bound) {
+		// The pages are bound at offset 0, the draws address the model through its vertex offset and first index
+		if (vertexRange->getBuffer() != bound.vertexBuffer) {
+			VkBuffer buffers[] = { vertexRange->getBuffer() };
+			VkDeviceSize offsets[] = { 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+			bound.vertexBuffer = buffers[0];
+		}
 
-		if (hasIndexBuffer) _LIKELY {
+		if (hasIndexBuffer && indexRange->getBuffer() != bound.indexBuffer) _LIKELY {
 			// UINT32 is used because models can have easy have more than 65000 triangles
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(commandBuffer, indexRange->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			bound.indexBuffer = indexRange->getBuffer();
 		}
 	}
 
-	void SteelSightModel::draw(VkCommandBuffer commandBuffer) {
-		if (hasIndexBuffer) _LIKELY {
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+	void SteelSightModel::drawInstances(VkCommandBuffer commandBuffer, uint32_t part, uint32_t lod, uint32_t firstInstance, uint32_t instanceCount, const SetMaterial& setMaterial) {
+		if (!hasIndexBuffer) _UNLIKELY {
+			if (setMaterial) setMaterial(0);
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, static_cast<uint32_t>(getVertexOffset()), firstInstance);
+			return;
+		}
+
+		// The index buffer also holds the coarser levels of detail after the full detail meshes, a progressive model that is still streaming draws the finest level that arrived
+		const Part& drawnPart = parts[part];
+		lod = std::max(lod, getFinestLod(part));
+		drawLevel(commandBuffer, lods[drawnPart.firstLod + std::min(lod, drawnPart.lodCount - 1)], firstInstance, instanceCount, setMaterial);
+	}
+
+	void SteelSightModel::drawVisible(VkCommandBuffer commandBuffer, uint32_t part, const glm::mat4& modelMatrix, const glm::mat4& projectionView, const glm::vec3& cameraPosition, uint32_t lod, uint32_t firstInstance, const SetMaterial& setMaterial) {
+		if (!hasIndexBuffer) _UNLIKELY {
+			drawInstances(commandBuffer, part, lod, firstInstance, 1, setMaterial);
+			return;
+		}
+
+		const auto frustum = SteelSightMeshlets::makeFrustum(modelMatrix, projectionView, cameraPosition, meshletConeCulling);
+		const Part& drawnPart = parts[part];
+		const int32_t vertexOffset = getVertexOffset();
+		const uint32_t indexOffset = getIndexOffset();
+
+		// A progressive model that is still streaming draws the finest level that arrived
+		lod = std::max(lod, getFinestLod(part));
+
+		if (lod > 0 || meshlets.empty()) {
+			Meshlet bounds{};
+			bounds.center = glm::vec3{ drawnPart.boundingSphere };
+			bounds.radius = drawnPart.boundingSphere.w;
+			bounds.coneCutoff = SteelSightMeshlets::CONE_DISABLED;
+			if (SteelSightMeshlets::isVisible(bounds, frustum)) drawLevel(commandBuffer, lods[drawnPart.firstLod + std::min(lod, drawnPart.lodCount - 1)], firstInstance, 1, setMaterial);
+			return;
+		}
+
+		const Lod& fullDetail = lods[drawnPart.firstLod];
+		for (uint32_t s = fullDetail.firstSubmesh; s < fullDetail.firstSubmesh + fullDetail.submeshCount; ++s) {
+			const auto& submesh = submeshes[s];
+			bool materialSet{ false };
+
+			// Meshlets are consecutive index ranges, so a run of visible meshlets is a single draw
+			uint32_t firstIndex{ 0 };
+			uint32_t drawIndexCount{ 0 };
+
+			auto flush = [&]() {
+				if (drawIndexCount == 0) return;
+				if (!materialSet && setMaterial) setMaterial(submesh.material);
+				materialSet = true;
+				vkCmdDrawIndexed(commandBuffer, drawIndexCount, 1, indexOffset + firstIndex, vertexOffset, firstInstance);
+			};
+
+			for (uint32_t m = submesh.firstMeshlet; m < submesh.firstMeshlet + submesh.meshletCount; ++m) {
+				const auto& meshlet = meshlets[m];
+				if (!SteelSightMeshlets::isVisible(meshlet, frustum)) continue;
+
+				if (drawIndexCount > 0 && firstIndex + drawIndexCount == meshlet.firstIndex) _LIKELY {
+					drawIndexCount += meshlet.triangleCount * 3;
+					continue;
+				}
+
+				flush();
+				firstIndex = meshlet.firstIndex;
+				drawIndexCount = meshlet.triangleCount * 3;
+			}
+
+			flush();
 		}
-		else _UNLIKELY {
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+	}
+
+	void SteelSightModel::drawLevel(VkCommandBuffer commandBuffer, const Lod& level, uint32_t firstInstance, uint32_t instanceCount, const SetMaterial& setMaterial) {
+		const int32_t vertexOffset = getVertexOffset();
+		const uint32_t indexOffset = getIndexOffset();
+
+		for (uint32_t s = level.firstSubmesh; s < level.firstSubmesh + level.submeshCount; ++s) {
+			const auto& submesh = submeshes[s];
+			if (submesh.indexCount == 0) _UNLIKELY continue;
+
+			if (setMaterial) setMaterial(submesh.material);
+			vkCmdDrawIndexed(commandBuffer, submesh.indexCount, instanceCount, indexOffset + submesh.firstIndex, vertexOffset, firstInstance);
 		}
 	}
 
-	void SteelSightModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
+	void SteelSightModel::createVertexBuffers(std::span<const Vertex> vertices, VertexFormat format, bool flat, const SteelSightModel* previous, SteelSightUploadBatch& batch) {
 		vertexCount = static_cast<uint32_t>(vertices.size());
 		assert(vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
-
-		SteelSightBuffer stagingBuffer{
-			SSDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
+		// Hashing runs at memory speed, far below the cost of the staging copy and the transfer it can save
+		std::size_t hash = ankerl::unordered_dense::detail::wyhash::hash(vertices.data(), vertices.size_bytes());
+		hashCombine(hash, format, flat);
+		vertexHash = hash;
 
-		vertexBuffer = std::make_unique<SteelSightBuffer>(
-			SSDevice,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+		// The same vertices in the same format give the same buffer and the same dequantization
+		if (previous != nullptr && previous->vertexHash == vertexHash && previous->vertexCount == vertexCount) {
+			vertexRange = previous->vertexRange;
+			vertexFormat = previous->vertexFormat;
+			flatShading = previous->flatShading;
+			dequantization = previous->dequantization;
+			vertexBufferReused = true;
+			return;
+		}
 
-		SSDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+		flatShading = flat;
+		if (format == VertexFormat::Compact) {
+			createCompactVertexBuffers(vertices, batch);
+			return;
+		}
+
+		vertexFormat = VertexFormat::Full;
+		if (flatShading) {
+			const auto flatVertices = stripNormals(vertices);
+			uploadVertexBuffer(flatVertices.data(), sizeof(FlatVertex), vertexCount, batch);
+			return;
+		}
+
+		// On a cache hit this copies straight from the memory mapped cache file
+		uploadVertexBuffer(vertices.data(), sizeof(Vertex), vertexCount, batch);
 	}
 
-	void SteelSightModel::createIndexBuffers(const std::vector<uint32_t>& indices) {
+	void SteelSightModel::createCompactVertexBuffers(std::span<const Vertex> vertices, SteelSightUploadBatch& batch) {
+		glm::vec3 minimum{ std::numeric_limits<float>::max() };
+		glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+		for (const auto& vertex : vertices) {
+			minimum = glm::min(minimum, vertex.position);
+			maximum = glm::max(maximum, vertex.position);
+		}
+
+		const glm::vec3 extent = compactExtent(minimum, maximum);
+
+		std::vector<CompactVertex> compactVertices(vertices.size());
+		float positionError{ 0.f };
+		float normalCosine{ 1.f };
+
+		for (size_t v = 0; v < vertices.size(); ++v) {
+			const auto& vertex = vertices[v];
+			auto& compact = compactVertices[v];
+			compact = encodeCompact(vertex, minimum, extent);
+
+			// Decode again to measure the real error
+			const glm::vec3 decoded = minimum + glm::vec3{ compact.position[0], compact.position[1], compact.position[2] } / static_cast<float>(UINT16_MAX) * extent;
+			positionError = std::max(positionError, glm::length(decoded - vertex.position));
+
+			const float normalLength = glm::length(vertex.normal);
+			if (normalLength > 0.f) _LIKELY {
+				const glm::vec3 decodedNormal = decodeOctahedral(glm::vec2{ compact.normal[0], compact.normal[1] } / static_cast<float>(INT16_MAX));
+				normalCosine = std::min(normalCosine, glm::dot(decodedNormal, vertex.normal / normalLength));
+			}
+		}
+
+		vertexFormat = VertexFormat::Compact;
+		dequantization = glm::scale(glm::translate(glm::mat4{ 1.f }, minimum), extent);
+
+		if (flatShading) {
+			const auto flatVertices = stripNormals(std::span<const CompactVertex>{ compactVertices });
+			uploadVertexBuffer(flatVertices.data(), sizeof(CompactFlatVertex), vertexCount, batch);
+		}
+		else {
+			uploadVertexBuffer(compactVertices.data(), sizeof(CompactVertex), vertexCount, batch);
+		}
+
+		// The position error is at most half a quantization step of the largest axis, the normal error stays far below a degree
+		std::cout << "Compact vertices: " << getVertexStride(vertexFormat, flatShading) << " instead of " << sizeof(Vertex) << " bytes, "
+			<< "max position error: " << positionError << " (bound " << glm::length(extent) * 0.5f / UINT16_MAX << ")";
+		if (!flatShading) std::cout << ", max normal error: " << glm::degrees(std::acos(std::clamp(normalCosine, -1.f, 1.f))) << " degrees";
+		std::cout << std::endl;
+	}
+
+	void SteelSightModel::uploadVertexBuffer(const void* vertices, uint32_t vertexSize, uint32_t count, SteelSightUploadBatch& batch) {
+		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * count;
+
+		vertexRange = SSDevice.getGeometryPool().allocateVertices(vertexSize, count);
+
+		// Staged through the persistently mapped ring of the device, the vertices may be freed once the copy is recorded
+		vertexRange->upload(batch, vertices, bufferSize);
+	}
+
+	void SteelSightModel::createIndexBuffers(std::span<const uint32_t> indices, const SteelSightModel* previous, SteelSightUploadBatch& batch) {
 		indexCount = static_cast<uint32_t>(indices.size());
 		hasIndexBuffer = indexCount > 0;
 
@@ -99,28 +1028,18 @@ namespace Voortman {
 			return;
 		}
 
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-
-		SteelSightBuffer stagingBuffer{
-			SSDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
+		indexHash = ankerl::unordered_dense::detail::wyhash::hash(indices.data(), indices.size_bytes());
+		if (previous != nullptr && previous->hasIndexBuffer && previous->indexHash == indexHash && previous->indexCount == indexCount) {
+			indexRange = previous->indexRange;
+			indexBufferReused = true;
+			return;
+		}
 
-		indexBuffer = std::make_unique<SteelSightBuffer>(
-			SSDevice,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
 
-		SSDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+		// The indices stay relative to the first vertex of the model, the draws pass the vertex offset of its range
+		indexRange = SSDevice.getGeometryPool().allocateIndices(indexCount);
+		indexRange->upload(batch, indices.data(), bufferSize);
 	}
 
 	std::vector<VkVertexInputBindingDescription> SteelSightModel::Vertex::getBindingDescriptions() {
@@ -136,9 +1055,65 @@ namespace Voortman {
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
 		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) });
-		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) });
-		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) });
-		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) });
+		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) });
+		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) });
+
+		return attributeDescriptions;
+	}
+
+	std::vector<VkVertexInputBindingDescription> SteelSightModel::CompactVertex::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(CompactVertex);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> SteelSightModel::CompactVertex::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		// All three formats have mandatory vertex buffer support
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position) });
+		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal) });
+		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv) });
+
+		return attributeDescriptions;
+	}
+
+	std::vector<VkVertexInputBindingDescription> SteelSightModel::FlatVertex::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(FlatVertex);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> SteelSightModel::FlatVertex::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		// The texture coordinate keeps its location, simple_shader_flat.vert reads both flat layouts
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(FlatVertex, position) });
+		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(FlatVertex, uv) });
+
+		return attributeDescriptions;
+	}
+
+	std::vector<VkVertexInputBindingDescription> SteelSightModel::CompactFlatVertex::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(CompactFlatVertex);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> SteelSightModel::CompactFlatVertex::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactFlatVertex, position) });
+		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactFlatVertex, uv) });
 
 		return attributeDescriptions;
 	}
@@ -146,83 +1121,441 @@ namespace Voortman {
 	void SteelSightModel::Builder::loadModel(const std::string& filepath) {
 		auto start = std::chrono::high_resolution_clock::now();
 
-		// With rapidobj the .obj files will be loaded asynchronous with multi threaded parsing if the file is bigger than 1 MB
-		// rapidobj is not the most memory efficient but this should not be a big problem because loading the files takes just a few seconds at max
-		// Requires C++17 or above compiler
-		rapidobj::Result result = rapidobj::ParseFile(filepath);
+		statistics = {};
+		cacheFile.reset();
+		cachedVertices = {};
+		cachedIndices = {};
+		cachedMeshlets = {};
+		cachedLods = {};
+		cachedSubmeshes = {};
+		cachedParts = {};
+		cachedInstances = {};
+		cachedMaterials = {};
+
+		// A progressive file already holds the finished mesh, it is neither cached nor processed again
+		if (SteelSightProgressive::isProgressive(filepath)) {
+			SteelSightProgressive::read(filepath, *this);
+			reportBounds(*this, vertices);
+
+			const auto stop = std::chrono::high_resolution_clock::now();
+			statistics.totalTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+			std::cout << filepath << std::endl;
+			std::cout << "Progressive load time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << " (" << vertices.size() << " vertices, " << indices.size() << " indices, "
+				<< lods.size() << " LODs)" << std::endl << std::endl;
+			return;
+		}
+
+		const std::string cachePath = SteelSightMeshCache::getCachePath(filepath);
+		uint64_t sourceHash{ 0 };
+
+		if (options.useCache) _LIKELY {
+			sourceHash = SteelSightMeshCache::hashSource(filepath);
+			contentHash = sourceHash;
+
+			// Optimized and unoptimized meshes are different cache entries
+			size_t seed{ sourceHash };
+			hashCombine(seed, options.optimizeMesh, options.buildMeshlets, options.buildLods, options.detectInstances, options.weldEpsilon, options.weldNormalAngle, options.removeDegenerates, options.streamingParse,
+				options.stlNormals, options.stlSmoothingAngle, options.flatShading);
+			sourceHash = seed;
 
-		if (result.error) _UNLIKELY throw std::runtime_error(result.error.code.message());
+			std::chrono::microseconds coldLoadTime{};
+			if (SteelSightMeshCache::read(cachePath, sourceHash, *this, coldLoadTime)) _LIKELY {
+				reportBounds(*this, cachedVertices);
 
-		bool succes = rapidobj::Triangulate(result);
+				auto stop = std::chrono::high_resolution_clock::now();
+				statistics.cacheHit = true;
+				statistics.totalTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+				const std::chrono::duration<double, std::milli> warm = stop - start;
+				const std::chrono::duration<double, std::milli> cold = coldLoadTime;
 
-		if (!succes) _UNLIKELY throw std::runtime_error(result.error.code.message());
+				std::cout << filepath << std::endl;
+				std::cout << "Vertices: " << cachedVertices.size() << std::endl;
+				std::cout << "Indices: " << cachedIndices.size() << std::endl;
+				std::cout << "Meshlets: " << cachedMeshlets.size() << std::endl;
+				std::cout << "LODs: " << cachedLods.size() << std::endl;
+				std::cout << "Submeshes: " << cachedSubmeshes.size() << ", materials: " << cachedMaterials.size() << std::endl;
+				std::cout << "Parts: " << cachedParts.size() << ", instances: " << cachedInstances.size() << std::endl;
+				std::cout << "Warm load (mesh cache): " << warm << ", cold load: " << cold << ", speedup: " << cold.count() / std::max(warm.count(), 0.001) << "x" << std::endl;
+
+				if (options.progressive && !SteelSightProgressive::isUpToDate(filepath)) writeProgressive(filepath, *this, statistics.totalTime);
+				std::cout << std::endl;
+				return;
+			}
+		}
 
-		auto stop = std::chrono::high_resolution_clock::now();
-		std::cout << "rapidobj parse time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << std::endl << std::endl;
+		// Measured after the cache check, a warm load allocates next to nothing
+		statistics.processResidentBefore = getResidentSize();
+		statistics.processPeakBefore = getPeakResidentSize();
 
 		vertices.clear();
 		indices.clear();
+		meshlets.clear();
+		lods.clear();
+		submeshes.clear();
+		parts.clear();
+		instances.clear();
 
-		// Significantly faster than std::unordered_map
-		ankerl::unordered_dense::map<Vertex, uint32_t> uniqueVertices{};
+		const uint32_t workerCount = resolveWorkerCount(options.weldThreads);
+		const bool tuples = options.weldMode == WeldMode::IndexTuple;
+		const bool binaryGltf = SteelSightGltf::isBinaryGltf(filepath);
+		const bool stl = SteelSightStl::isStl(filepath);
+		const bool dstv = SteelSightDstv::isDstv(filepath);
+		const bool detectInstances = options.detectInstances && !options.streamingParse && !binaryGltf && !stl && !dstv;
+		bool parallel{ false };
 
-		for (const auto& shape : result.shapes) _LIKELY {
-			for (size_t i = 0; i < shape.mesh.indices.size(); ++i) _LIKELY {
-				Vertex vertex{};
+		std::vector<size_t> partCorners{};
+		std::vector<uint32_t> triangleMaterials{};
+		std::chrono::high_resolution_clock::duration instanceTime{};
+		std::chrono::high_resolution_clock::time_point weldStart{};
+		std::chrono::high_resolution_clock::time_point stop{};
 
-				const auto& index = shape.mesh.indices[i];
-				int material_index = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[i / 3]; // Assuming each face is a triangle
+		if (binaryGltf) {
+			// Already indexed, the nodes are the instances
+			auto gltf = SteelSightGltf::load(filepath, DEFAULT_MATERIAL);
+			if (onBounds && !gltf.vertices.empty()) onBounds(gltf.minimum, gltf.maximum);
 
-				// Position
-				if (index.position_index >= 0) _LIKELY {
-					vertex.position = {
-						result.attributes.positions[3 * index.position_index + 0],
-						result.attributes.positions[3 * index.position_index + 1],
-						result.attributes.positions[3 * index.position_index + 2]
-					};
-				}
+			vertices = std::move(gltf.vertices);
+			indices = std::move(gltf.indices);
+			materials = std::move(gltf.materials);
+			triangleMaterials = std::move(gltf.triangleMaterials);
+			partCorners = std::move(gltf.partCorners);
+			instances = std::move(gltf.instances);
 
-				// Assign color based on material
-				// Rapidobj does not support vertex colors instead rapidobj uses .mtl files to set each vertex color
-				if (material_index >= 0) _LIKELY {
-					vertex.color = {
-						result.materials[material_index].diffuse[0],
-						result.materials[material_index].diffuse[1],
-						result.materials[material_index].diffuse[2]
-					};
-				}
+			stop = std::chrono::high_resolution_clock::now();
+			std::cout << "glTF load time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << " (" << gltf.blockCopiedVertices << " of " << vertices.size()
+				<< " vertices copied as one block)" << std::endl << std::endl;
 
-				// Normals
-				if (index.normal_index >= 0) _LIKELY {
-					vertex.normal = {
-						result.attributes.normals[3 * index.normal_index + 0],
-						result.attributes.normals[3 * index.normal_index + 1],
-						result.attributes.normals[3 * index.normal_index + 2]
-					};
-				}
+			weldStart = stop;
+			statistics.parseTime = std::chrono::duration_cast<std::chrono::microseconds>(weldStart - start);
+		}
+		else if (stl) {
+			// Every corner is stored separately, the positions are welded while reading and the normals generated
+			auto mesh = SteelSightStl::load(filepath, options.stlNormals, options.stlSmoothingAngle, workerCount, PARALLEL_WELD_MIN_CORNERS);
+			vertices = std::move(mesh.vertices);
+			indices = std::move(mesh.indices);
+			parallel = mesh.workerCount > 1;
 
-				// Texture Coordinates
-				if (index.texcoord_index >= 0) _LIKELY {
-					vertex.uv = {
-						result.attributes.texcoords[2 * index.texcoord_index + 0],
-						result.attributes.texcoords[2 * index.texcoord_index + 1]
-					};
-				}
+			reportBounds(*this, vertices);
 
-				// Check for unique vertex and update indices
-				if (!uniqueVertices.contains(vertex)) _LIKELY {
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
-				}
-				indices.push_back(uniqueVertices[vertex]);
+			// STL has no materials
+			materials = { DEFAULT_MATERIAL };
+			triangleMaterials.assign(indices.size() / 3, 0);
+			partCorners.push_back(indices.size());
+			instances.push_back({});
+
+			stop = std::chrono::high_resolution_clock::now();
+			std::cout << "STL load and weld time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << " (" << mesh.workerCount << " threads, "
+				<< mesh.positionCount << " positions, " << (options.stlNormals == NormalMode::Flat ? "flat" : "smooth") << " normals)" << std::endl << std::endl;
+
+			weldStart = stop;
+			statistics.parseTime = std::chrono::duration_cast<std::chrono::microseconds>(weldStart - start);
+		}
+		else if (dstv) {
+			// The beam is meshed from its profile, there is nothing to weld
+			auto beam = SteelSightDstv::load(filepath);
+			vertices = std::move(beam.vertices);
+			indices = std::move(beam.indices);
+
+			reportBounds(*this, vertices);
+
+			materials = { DEFAULT_MATERIAL };
+			triangleMaterials.assign(indices.size() / 3, 0);
+			partCorners.push_back(indices.size());
+			instances.push_back({});
+
+			stop = std::chrono::high_resolution_clock::now();
+			std::cout << "DSTV load time: " << std::chrono::duration_cast<std::chrono::microseconds>(stop - start) << " (" << beam.profileName << ", profile code " << beam.profile.code
+				<< ", length " << beam.length << ", " << beam.cutHoles << " of " << beam.holeCount << " holes cut, section " << (beam.sectionShared ? "shared" : "built") << ")" << std::endl << std::endl;
+
+			weldStart = stop;
+			statistics.parseTime = std::chrono::duration_cast<std::chrono::microseconds>(weldStart - start);
+		}
+		else if (options.streamingParse) {
+			// The parse and the weld are one pass, the text and the face corners are never held for the whole file
+			auto streamed = SteelSightObjStream::load(filepath, DEFAULT_MATERIAL);
+			vertices = std::move(streamed.vertices);
+			indices = std::move(streamed.indices);
+			materials = std::move(streamed.materials);
+			triangleMaterials = std::move(streamed.triangleMaterials);
+
+			reportBounds(*this, vertices);
+			mergeEqualVertices(vertices, indices, workerCount);
+
+			partCorners.push_back(indices.size());
+			instances.push_back({});
+
+			stop = std::chrono::high_resolution_clock::now();
+			std::cout << "Streaming parse and weld time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << std::endl << std::endl;
+
+			weldStart = stop;
+			statistics.parseTime = std::chrono::duration_cast<std::chrono::microseconds>(weldStart - start);
+		}
+		else {
+			// With rapidobj the .obj files will be loaded asynchronous with multi threaded parsing if the file is bigger than 1 MB
+			// rapidobj keeps the whole file and every face corner in memory until the weld finished, streamingParse avoids that for very large exports
+			// Requires C++17 or above compiler
+			rapidobj::Result result = rapidobj::ParseFile(filepath);
+
+			if (result.error) _UNLIKELY throw std::runtime_error(result.error.code.message());
+
+			reportBounds(*this, { result.attributes.positions.data(), result.attributes.positions.size() }, 3);
+
+			bool succes = rapidobj::Triangulate(result);
+
+			if (!succes) _UNLIKELY throw std::runtime_error(result.error.code.message());
+
+			stop = std::chrono::high_resolution_clock::now();
+			std::cout << "rapidobj parse time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << std::endl << std::endl;
+
+			weldStart = std::chrono::high_resolution_clock::now();
+			statistics.parseTime = std::chrono::duration_cast<std::chrono::microseconds>(weldStart - start);
+
+			// Repeated shapes are removed before the weld, so they are neither welded, optimized nor uploaded more than once
+			const auto instanceStart = std::chrono::high_resolution_clock::now();
+			statistics.shapeCount = result.shapes.size();
+			if (detectInstances) _LIKELY partCorners = extractInstances(result, workerCount, instances);
+			statistics.instancedShapes = statistics.shapeCount - result.shapes.size();
+			instanceTime = std::chrono::high_resolution_clock::now() - instanceStart;
+
+			size_t cornerCount{ 0 };
+			for (const auto& shape : result.shapes) cornerCount += shape.mesh.indices.size();
+
+			if (!detectInstances) _UNLIKELY {
+				partCorners.push_back(cornerCount);
+				instances.push_back({});
+			}
+
+			parallel = workerCount > 1 && cornerCount >= PARALLEL_WELD_MIN_CORNERS;
+
+			if (parallel && tuples) _LIKELY {
+				weldShapesParallel<CornerKey>(result, cornerCount, workerCount, makeCornerKey, vertices, indices);
+			}
+			else if (parallel) {
+				weldShapesParallel<Vertex>(result, cornerCount, workerCount, [&result](const rapidobj::Mesh& mesh, size_t i) { return makeVertex(result, mesh, i); }, vertices, indices);
+			}
+			else if (tuples) {
+				weldSerialTuples(result, vertices, indices);
+			}
+			else _UNLIKELY {
+				weldSerial(result, vertices, indices);
+			}
+
+			collectMaterials(result, materials, triangleMaterials);
+		}
+
+		// The parse and the weld are where the two parsers differ, everything after works on the same welded mesh
+		statistics.processPeakAfterWeld = getPeakResidentSize();
+
+		// Without normals the corners of the faces around a hard edge are the same vertex
+		if (options.flatShading) {
+			const size_t weldedVertices = vertices.size();
+			for (auto& vertex : vertices) vertex.normal = glm::vec3{ 0.f };
+			mergeEqualVertices(vertices, indices, workerCount);
+
+			statistics.flatMergedVertices = weldedVertices - vertices.size();
+			std::cout << "Flat shading: " << weldedVertices << " -> " << vertices.size() << " vertices" << std::endl;
+		}
+
+		// The cleanup removes triangles, so it runs before the triangles are grouped by material
+		SteelSightMeshCleanup::Statistics cleanup{};
+		const bool cleaned = options.weldEpsilon > 0.f || options.removeDegenerates;
+		if (options.weldEpsilon > 0.f) cleanup.mergedVertices = SteelSightMeshCleanup::weldVertices(vertices, indices, options.weldEpsilon, options.weldNormalAngle);
+		if (options.removeDegenerates) _LIKELY SteelSightMeshCleanup::removeDegenerateTriangles(vertices, indices, triangleMaterials, partCorners, cleanup);
+		if (cleaned) _LIKELY cleanup.unusedVertices = SteelSightMeshCleanup::removeUnusedVertices(vertices, indices);
+
+		// Merged vertices are unused afterwards, so the unused vertices are every vertex the cleanup removed
+		statistics.removedVertices = cleanup.unusedVertices;
+		statistics.removedTriangles = cleanup.degenerateTriangles + cleanup.zeroAreaTriangles;
+
+		// One submesh per material of every part, the full detail mesh of a part is its first level of detail
+
+		size_t firstCorner{ 0 };
+		for (const size_t corners : partCorners) {
+			const uint32_t firstSubmesh = static_cast<uint32_t>(submeshes.size());
+			groupByMaterial(std::span<uint32_t>{ indices }.subspan(firstCorner, corners), std::span<const uint32_t>{ triangleMaterials }.subspan(firstCorner / 3, corners / 3), static_cast<uint32_t>(firstCorner), submeshes);
+
+			parts.push_back({ glm::vec4{ 0.f }, static_cast<uint32_t>(lods.size()), 1 });
+			lods.push_back({ static_cast<uint32_t>(firstCorner), static_cast<uint32_t>(corners), 0.f, firstSubmesh, static_cast<uint32_t>(submeshes.size()) - firstSubmesh });
+			firstCorner += corners;
+		}
+
+		statistics.weldTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - weldStart);
+
+		if (options.optimizeMesh) _LIKELY optimize();
+
+		// The optimization renumbers the vertices, not their positions
+		for (auto& part : parts) {
+			const auto& fullDetail = lods[part.firstLod];
+			part.boundingSphere = computeBoundingSphere(vertices, std::span<const uint32_t>{ indices }.subspan(fullDetail.firstIndex, fullDetail.indexCount));
+		}
+
+		// Built after the optimization so every meshlet is a compact cluster of the cache optimized triangle order, a meshlet never spans two materials
+		const auto meshletStart = std::chrono::high_resolution_clock::now();
+		if (options.buildMeshlets) _LIKELY {
+			for (auto& submesh : submeshes) {
+				auto submeshMeshlets = SteelSightMeshlets::build(vertices, std::span<const uint32_t>{ indices }.subspan(submesh.firstIndex, submesh.indexCount));
+				for (auto& meshlet : submeshMeshlets) meshlet.firstIndex += submesh.firstIndex;
+
+				submesh.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+				submesh.meshletCount = static_cast<uint32_t>(submeshMeshlets.size());
+				meshlets.insert(meshlets.end(), submeshMeshlets.begin(), submeshMeshlets.end());
 			}
 		}
+		const auto meshletTime = std::chrono::high_resolution_clock::now() - meshletStart;
+
+		// Last, the coarser levels are appended to the index buffer behind the full detail mesh the meshlets point into
+		const auto lodStart = std::chrono::high_resolution_clock::now();
+		if (options.buildLods) _LIKELY buildLods();
+		const auto lodTime = std::chrono::high_resolution_clock::now() - lodStart;
 
 		// Information about the 3D models
 		stop = std::chrono::high_resolution_clock::now();
 		std::cout << filepath << std::endl;
 		std::cout << "Vertices: " << vertices.size() << std::endl;
 		std::cout << "Indices: " << indices.size() << std::endl;
-		std::cout << "Total time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << std::endl << std::endl;
+		std::cout << "Submeshes: " << submeshes.size() << ", materials: " << materials.size() << std::endl;
+		if (detectInstances) _LIKELY {
+			std::cout << "Instancing: " << statistics.instancedShapes << " of " << statistics.shapeCount << " shapes are copies, " << parts.size() << " parts, "
+				<< instances.size() << " instances (" << std::chrono::duration_cast<std::chrono::milliseconds>(instanceTime) << ")" << std::endl;
+		}
+		if (binaryGltf) {
+			std::cout << "glTF nodes: " << parts.size() << " meshes, " << instances.size() << " instances" << std::endl;
+			std::cout << "Weld time: " << std::chrono::duration_cast<std::chrono::milliseconds>(statistics.weldTime) << " (already indexed)" << std::endl;
+		}
+		else if (dstv) {
+			std::cout << "Weld time: " << std::chrono::duration_cast<std::chrono::milliseconds>(statistics.weldTime) << " (meshed procedurally)" << std::endl;
+		}
+		else if (stl) {
+			std::cout << "Weld time: " << std::chrono::duration_cast<std::chrono::milliseconds>(statistics.weldTime) << " (welded while reading)" << std::endl;
+		}
+		else if (options.streamingParse) {
+			std::cout << "Weld time: " << std::chrono::duration_cast<std::chrono::milliseconds>(statistics.weldTime) << " (welded while streaming)" << std::endl;
+		}
+		else {
+			std::cout << "Weld time: " << std::chrono::duration_cast<std::chrono::milliseconds>(statistics.weldTime) << " (" << (parallel ? workerCount : 1) << " threads, " << (tuples ? "index tuples" : "vertices") << ")" << std::endl;
+		}
+		if (cleaned) _LIKELY {
+			std::cout << "Cleanup: removed " << statistics.removedVertices << " vertices (" << cleanup.mergedVertices << " merged within " << options.weldEpsilon << "), "
+				<< statistics.removedTriangles << " triangles (" << cleanup.degenerateTriangles << " degenerate, " << cleanup.zeroAreaTriangles << " zero area)" << std::endl;
+		}
+		if (options.buildMeshlets) _LIKELY {
+			std::cout << "Meshlets: " << meshlets.size() << " (" << std::chrono::duration_cast<std::chrono::milliseconds>(meshletTime) << ")" << std::endl;
+		}
+		if (options.buildLods && !parts.empty()) _LIKELY {
+			std::cout << "LODs: " << lods.size() << " (" << std::chrono::duration_cast<std::chrono::milliseconds>(lodTime) << ") triangles of the largest part:";
+			const auto largest = std::max_element(parts.begin(), parts.end(), [this](const Part& a, const Part& b) { return lods[a.firstLod].indexCount < lods[b.firstLod].indexCount; });
+			for (uint32_t lod = largest->firstLod; lod < largest->firstLod + largest->lodCount; ++lod) std::cout << " " << lods[lod].indexCount / 3 << " (" << lods[lod].error << ")";
+			std::cout << std::endl;
+		}
+		if (options.optimizeMesh) _LIKELY {
+			std::cout << "Optimize time: " << std::chrono::duration_cast<std::chrono::milliseconds>(statistics.optimizeTime)
+				<< " (ACMR " << statistics.acmrBefore << " -> " << statistics.acmrAfter << ", ATVR " << statistics.atvrBefore << " -> " << statistics.atvrAfter << ")" << std::endl;
+		}
+		// The peak is only known for the whole process, with loads on the other loader threads it is not the peak of this load
+		statistics.processPeakAfter = getPeakResidentSize();
+		std::cout << "Process peak RSS: " << statistics.processPeakAfter / (1024 * 1024) << " MB, " << statistics.processPeakAfterWeld / (1024 * 1024) << " MB once the weld finished" << std::endl;
+		std::cout << "Total time: " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start) << std::endl;
+		statistics.totalTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+		if (options.useCache) _LIKELY {
+			const bool written = SteelSightMeshCache::write(cachePath, sourceHash, *this, std::chrono::duration_cast<std::chrono::microseconds>(stop - start));
+			std::cout << "Cold load, mesh cache " << (written ? "written to " + cachePath : std::string("not written")) << std::endl;
+		}
+		if (options.progressive) writeProgressive(filepath, *this, statistics.totalTime);
+		std::cout << std::endl;
+	}
+
+	void SteelSightModel::Builder::optimize() {
+		const auto start = std::chrono::high_resolution_clock::now();
+		constexpr uint32_t cacheSize = SteelSightMeshOptimizer::VERTEX_CACHE_SIZE;
+
+		const auto before = SteelSightMeshOptimizer::analyzeVertexCache(indices, vertices.size(), cacheSize);
+
+		// Triangles only move within their submesh so the material ranges stay intact
+		for (const auto& submesh : submeshes) {
+			SteelSightMeshOptimizer::optimizeVertexCache(std::span<uint32_t>{ indices }.subspan(submesh.firstIndex, submesh.indexCount), vertices.size(), cacheSize);
+		}
+		SteelSightMeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+		const auto after = SteelSightMeshOptimizer::analyzeVertexCache(indices, vertices.size(), cacheSize);
+
+		statistics.optimizeTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+		statistics.acmrBefore = before.acmr;
+		statistics.acmrAfter = after.acmr;
+		statistics.atvrBefore = before.atvr;
+		statistics.atvrAfter = after.atvr;
+	}
+
+	void SteelSightModel::Builder::buildLods() {
+		// Keep the full detail mesh of every part and their submeshes, loadModel creates them in part order before the mesh is optimized
+		if (parts.empty()) _UNLIKELY return;
+
+		std::vector<Lod> fullDetail{};
+		for (const auto& part : parts) fullDetail.push_back(lods[part.firstLod]);
+		indices.resize(fullDetail.back().firstIndex + fullDetail.back().indexCount);
+		submeshes.resize(fullDetail.back().firstSubmesh + fullDetail.back().submeshCount);
+		lods.clear();
+
+		for (size_t p = 0; p < parts.size(); ++p) {
+			auto& part = parts[p];
+			part.firstLod = static_cast<uint32_t>(lods.size());
+			part.lodCount = 1;
+			lods.push_back(fullDetail[p]);
+
+			// The errors are relative to the same sphere the render system projects to the screen
+			const float radius = part.boundingSphere.w;
+			if (fullDetail[p].indexCount == 0 || radius == 0.f) _UNLIKELY continue;
+
+			// The part is simplified on its own vertices, so the cost of a part does not grow with the rest of the model
+			std::vector<uint32_t> partVertices{};
+			std::vector<uint32_t> previous(fullDetail[p].indexCount);
+			ankerl::unordered_dense::map<uint32_t, uint32_t> localIndices{};
+			for (size_t i = 0; i < previous.size(); ++i) {
+				const uint32_t index = indices[fullDetail[p].firstIndex + i];
+				auto [it, inserted] = localIndices.try_emplace(index, static_cast<uint32_t>(partVertices.size()));
+				if (inserted) partVertices.push_back(index);
+				previous[i] = it->second;
+			}
+
+			std::vector<Vertex> localVertices(partVertices.size());
+			for (size_t v = 0; v < partVertices.size(); ++v) localVertices[v] = vertices[partVertices[v]];
+
+			// Every level is simplified from the previous one, so the errors add up
+			std::vector<uint32_t> previousMaterials(previous.size() / 3);
+			for (uint32_t s = fullDetail[p].firstSubmesh; s < fullDetail[p].firstSubmesh + fullDetail[p].submeshCount; ++s) {
+				std::fill_n(previousMaterials.begin() + (submeshes[s].firstIndex - fullDetail[p].firstIndex) / 3, submeshes[s].indexCount / 3, submeshes[s].material);
+			}
+			float error{ 0.f };
+
+			for (uint32_t level = 1; level < SteelSightMeshSimplifier::MAX_LODS; ++level) {
+				const size_t target = previous.size() / 6 * 3;
+
+				// The materials are simplified as one mesh, the boundaries between them are borders so neighbouring submeshes never crack apart
+				float levelError{ 0.f };
+				std::vector<uint32_t> simplifiedMaterials{ previousMaterials };
+				std::vector<uint32_t> simplified = SteelSightMeshSimplifier::simplify(localVertices, previous, simplifiedMaterials, target, SteelSightMeshSimplifier::MAX_LOD_ERROR * radius, levelError);
+				if (simplified.empty() || simplified.size() > previous.size() * (1.f - SteelSightMeshSimplifier::MIN_LOD_REDUCTION)) break;
+
+				const uint32_t firstIndex = static_cast<uint32_t>(indices.size());
+				const uint32_t firstSubmesh = static_cast<uint32_t>(submeshes.size());
+				groupByMaterial(simplified, simplifiedMaterials, firstIndex, submeshes);
+
+				if (options.optimizeMesh) _LIKELY {
+					for (uint32_t s = firstSubmesh; s < submeshes.size(); ++s) {
+						SteelSightMeshOptimizer::optimizeVertexCache(std::span<uint32_t>{ simplified }.subspan(submeshes[s].firstIndex - firstIndex, submeshes[s].indexCount), localVertices.size(), SteelSightMeshOptimizer::VERTEX_CACHE_SIZE);
+					}
+				}
+
+				error += levelError / radius;
+				lods.push_back({ firstIndex, static_cast<uint32_t>(simplified.size()), error, firstSubmesh, static_cast<uint32_t>(submeshes.size()) - firstSubmesh });
+				for (const uint32_t index : simplified) indices.push_back(partVertices[index]);
+				++part.lodCount;
+
+				// The simplified triangles are now sorted by material as well
+				std::stable_sort(simplifiedMaterials.begin(), simplifiedMaterials.end());
+				previous = std::move(simplified);
+				previousMaterials = std::move(simplifiedMaterials);
+			}
+		}
 	}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "SteelSightDevice.hpp"
 #include "SteelSightBuffer.hpp"
+#include "SteelSightMappedFile.hpp"
+#include "SteelSightUploadBatch.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -8,14 +10,19 @@
 
 #include <vector>
 #include <memory>
+#include <span>
+#include <chrono>
+#include <functional>
+#include <atomic>
+#include <mutex>
 #include "unordered_dense.h"
 
 namespace Voortman {
 	class SteelSightModel final {
 	public:
+		// Only geometry, the color comes from the material of the submesh so faces of different colors share their vertices
 		struct Vertex final {
 			glm::vec3 position{};
-			glm::vec3 color{0.5f,0.5f,0.5f};
 			glm::vec3 normal{};
 			glm::vec2 uv{};
 
@@ -23,39 +30,475 @@ namespace Voortman {
 			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
 
 			inline bool _NODISCARD operator==(const Vertex& other)
-				const noexcept {return position == other.position && color == other.color && normal == other.normal && uv == other.uv;}
+				const noexcept {return position == other.position && normal == other.normal && uv == other.uv;}
+		};
+
+		/// <summary>
+		/// 16 byte vertex: position quantized to the bounds of the mesh, octahedral normal and half float texture coordinate.
+		/// The dequantization is folded into the model matrix.
+		/// </summary>
+		struct CompactVertex final {
+			// xyz relative to the mesh bounds as UNORM, w is unused and keeps the normal 4 byte aligned
+			uint16_t position[4]{};
+			// Octahedral encoded unit normal as SNORM
+			int16_t normal[2]{};
+			// Half floats
+			uint16_t uv[2]{};
+
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		};
+
+		// Vertex without a normal for flat shaded models, the fragment shader takes the normal of the face from the derivatives of its position
+		struct FlatVertex final {
+			glm::vec3 position{};
+			glm::vec2 uv{};
+
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		};
+
+		// CompactVertex without a normal, 12 bytes
+		struct CompactFlatVertex final {
+			uint16_t position[4]{};
+			uint16_t uv[2]{};
+
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		};
+
+		enum class VertexFormat : uint8_t {
+			// Vertex, 32 bytes of floats
+			Full,
+			// CompactVertex, 16 bytes
+			Compact,
+		};
+
+		/// <summary>
+		/// A cluster of at most SteelSightMeshlets::MAX_VERTICES vertices and MAX_TRIANGLES triangles.
+		/// Every meshlet is a contiguous range of the index buffer, so surviving meshlets can be drawn straight from the existing index buffer.
+		/// </summary>
+		struct Meshlet final {
+			// Bounding sphere in model space
+			glm::vec3 center{};
+			float radius{ 0.f };
+
+			// Normal cone, the meshlet faces away from every camera inside the cone behind the apex
+			glm::vec3 coneApex{};
+			float coneCutoff{ 0.f };
+			glm::vec3 coneAxis{};
+
+			uint32_t firstIndex{ 0 };
+			uint32_t triangleCount{ 0 };
+			uint32_t vertexCount{ 0 };
+			uint32_t padding[2]{};
+		};
+
+		/// <summary>
+		/// The triangles of one level of detail that use one material, a range of the shared index buffer.
+		/// </summary>
+		struct Submesh final {
+			uint32_t firstIndex{ 0 };
+			uint32_t indexCount{ 0 };
+
+			// Index into the materials of the model
+			uint32_t material{ 0 };
+
+			// Meshlets of this range, only the full detail mesh has meshlets
+			uint32_t firstMeshlet{ 0 };
+			uint32_t meshletCount{ 0 };
+			uint32_t padding[3]{};
+		};
+
+		/// <summary>
+		/// One level of detail, a range of the shared index buffer sorted by material into submeshes. Level 0 is the full detail mesh.
+		/// </summary>
+		struct Lod final {
+			uint32_t firstIndex{ 0 };
+			uint32_t indexCount{ 0 };
+
+			// Simplification error relative to the radius of the model, 0 for the full detail mesh
+			float error{ 0.f };
+
+			uint32_t firstSubmesh{ 0 };
+			uint32_t submeshCount{ 0 };
+			uint32_t padding[3]{};
+		};
+
+		/// <summary>
+		/// One distinct piece of geometry of the model with its own chain of levels of detail. A model without repeated shapes has a single part.
+		/// </summary>
+		struct Part final {
+			// Bounding sphere of the full detail mesh in model space, xyz is the center and w the radius
+			glm::vec4 boundingSphere{ 0.f };
+
+			// The levels of detail of the part are consecutive, the first one is the full detail mesh
+			uint32_t firstLod{ 0 };
+			uint32_t lodCount{ 0 };
+			uint32_t padding[2]{};
+		};
+
+		/// <summary>
+		/// Places a part in the model. The geometry of a part is stored where its first occurrence sits in the file, every copy is a rigid transform of it.
+		/// The nodes of a glTF file may also scale their mesh.
+		/// </summary>
+		struct Instance final {
+			glm::mat4 transform{ 1.f };
+			uint32_t part{ 0 };
+			uint32_t padding[3]{};
+		};
+
+		// Receives the index of a material of the model before the triangles of that material are drawn
+		using SetMaterial = std::function<void(uint32_t material)>;
+
+		enum class WeldMode : uint8_t {
+			// Hash and compare the full float vertex of every face corner
+			Vertex,
+			// Hash the packed OBJ (position, normal, texcoord, material) indices of every corner and build each unique vertex once
+			IndexTuple,
+		};
+
+		enum class NormalMode : uint8_t {
+			// Every triangle uses its face normal, the vertices are split at every edge
+			Flat,
+			// Average the area weighted face normals around a position, except across edges sharper than the smoothing angle
+			Smooth,
+		};
+
+		struct LoadOptions final {
+			// Read and write the binary mesh cache next to the model so repeat loads skip rapidobj entirely
+			bool useCache{ true };
+
+			// Threads used to weld the face corners into unique vertices, 0 uses every hardware thread. The result is identical for every thread count
+			uint32_t weldThreads{ 0 };
+
+			// Both modes produce the same mesh, the index tuple weld is faster because it never hashes floats
+			WeldMode weldMode{ WeldMode::IndexTuple };
+
+			// After the exact weld, also merge vertices closer than this many model units whose normals are less than weldNormalAngle degrees apart.
+			// CAD exports often write the same seam vertex with float noise, 0 only merges equal vertices. See SteelSightMeshCleanup
+			float weldEpsilon{ 0.f };
+			float weldNormalAngle{ 10.f };
+
+			// Remove triangles with repeated corners or without area
+			bool removeDegenerates{ true };
+
+			// Reorder the triangles for the post-transform vertex cache and the vertices for fetch locality, see SteelSightMeshOptimizer
+			bool optimizeMesh{ true };
+
+			// Split the mesh into meshlets so drawVisible can skip the clusters outside of the view
+			bool buildMeshlets{ true };
+
+			// Also skip meshlets that face away from the camera. Only correct for closed solids, the pipeline draws back faces
+			bool meshletConeCulling{ false };
+
+			// Build a chain of simplified levels of detail, appended to the index buffer, see SteelSightMeshSimplifier
+			bool buildLods{ true };
+
+			// Layout of the vertex buffer on the GPU, the mesh cache always holds full vertices
+			VertexFormat vertexFormat{ VertexFormat::Full };
+
+			// Drop the normals and shade every face with its own normal, taken from the screen space derivatives of the position in simple_shader.frag.
+			// Corners that only differed by their normal become one vertex, so the hard edges of flat faced steel no longer split the vertices.
+			// The vertex buffer holds FlatVertex or CompactFlatVertex. Curved surfaces show their facets
+			bool flatShading{ false };
+
+			// Store shapes that repeat in the file (bolts, nuts, stiffeners) once and draw every copy as an instance of it
+			bool detectInstances{ true };
+
+			// Parse the OBJ in chunks and weld every face while reading instead of parsing it with rapidobj first, lowers the peak memory of large exports.
+			// Produces the same mesh as the rapidobj load without instances, the shapes of the file are not kept. See SteelSightObjStream
+			bool streamingParse{ false };
+
+			// Normals generated for STL files, which store none per vertex. See SteelSightStl
+			NormalMode stlNormals{ NormalMode::Smooth };
+			float stlSmoothingAngle{ 30.f };
+
+			// Write the level of detail chain as a progressive file next to the model (model.obj.ssprog) after a full load. SteelSightModelLoader streams that file
+			// on later loads while it is newer than the model, the model is drawn at its coarsest level as soon as that arrived. See SteelSightProgressive
+			bool progressive{ false };
+		};
+
+		struct LoadStatistics final {
+			std::chrono::microseconds parseTime{};
+			std::chrono::microseconds weldTime{};
+			std::chrono::microseconds optimizeTime{};
+			std::chrono::microseconds totalTime{};
+
+			// Vertex cache efficiency of the index buffer before and after the optimization, only filled when the mesh was optimized
+			double acmrBefore{ 0.0 };
+			double acmrAfter{ 0.0 };
+			double atvrBefore{ 0.0 };
+			double atvrAfter{ 0.0 };
+
+			// What the cleanup after the weld removed, see SteelSightMeshCleanup
+			size_t removedVertices{ 0 };
+			size_t removedTriangles{ 0 };
+
+			// Vertices that only differed by their normal, merged by LoadOptions::flatShading
+			size_t flatMergedVertices{ 0 };
+
+			// Shapes in the file and shapes whose geometry was replaced by an instance of an earlier shape
+			size_t shapeCount{ 0 };
+			size_t instancedShapes{ 0 };
+
+			// Resident memory of the process at the start of a cold load, and the peak of the process at the start, once the weld finished and at the end.
+			// Loads on other threads are part of these, only a caller that loads one model at a time can attribute their growth to the load
+			size_t processResidentBefore{ 0 };
+			size_t processPeakBefore{ 0 };
+			size_t processPeakAfterWeld{ 0 };
+			size_t processPeakAfter{ 0 };
+
+			bool cacheHit{ false };
 		};
 
 		struct Builder final {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
+			std::vector<Meshlet> meshlets{};
+			std::vector<Lod> lods{};
+			std::vector<Submesh> submeshes{};
+			std::vector<Part> parts{};
+			std::vector<Instance> instances{};
+
+			// Diffuse color of every material the submeshes point to
+			std::vector<glm::vec4> materials{};
+
+			LoadOptions options{};
+			LoadStatistics statistics{};
 
+			// Content hash of the file, see SteelSightMeshCache::hashSource. Set by loadModel when options.useCache is set, 0 otherwise
+			uint64_t contentHash{ 0 };
+
+			// Called by loadModel as soon as the bounding box of the mesh is known, before the weld. Lets a loading model show a placeholder
+			std::function<void(const glm::vec3& minimum, const glm::vec3& maximum)> onBounds{};
+
+			// Loads an OBJ file, a binary glTF file when the extension is .glb, a binary STL file when it is .stl or a DSTV file when it is .nc1, see SteelSightGltf, SteelSightStl and SteelSightDstv
 			void loadModel(const std::string& filepath);
+
+			// Runs the vertex cache optimization on every submesh and the vertex fetch optimization on vertices and indices, loadModel calls this when options.optimizeMesh is set
+			void optimize();
+
+			// Simplifies the full detail mesh of every part into its LOD chain, loadModel calls this when options.buildLods is set
+			void buildLods();
+
+			// The mesh to upload, on a cache hit these point into the memory mapped cache file instead of vertices/indices
+			_NODISCARD inline std::span<const Vertex> getVertices() const noexcept { return cacheFile ? cachedVertices : std::span<const Vertex>{ vertices }; }
+			_NODISCARD inline std::span<const uint32_t> getIndices() const noexcept { return cacheFile ? cachedIndices : std::span<const uint32_t>{ indices }; }
+			_NODISCARD inline std::span<const Meshlet> getMeshlets() const noexcept { return cacheFile ? cachedMeshlets : std::span<const Meshlet>{ meshlets }; }
+			_NODISCARD inline std::span<const Lod> getLods() const noexcept { return cacheFile ? cachedLods : std::span<const Lod>{ lods }; }
+			_NODISCARD inline std::span<const Submesh> getSubmeshes() const noexcept { return cacheFile ? cachedSubmeshes : std::span<const Submesh>{ submeshes }; }
+			_NODISCARD inline std::span<const Part> getParts() const noexcept { return cacheFile ? cachedParts : std::span<const Part>{ parts }; }
+			_NODISCARD inline std::span<const Instance> getInstances() const noexcept { return cacheFile ? cachedInstances : std::span<const Instance>{ instances }; }
+			_NODISCARD inline std::span<const glm::vec4> getMaterials() const noexcept { return cacheFile ? cachedMaterials : std::span<const glm::vec4>{ materials }; }
+
+			std::unique_ptr<SteelSightMappedFile> cacheFile{};
+			std::span<const Vertex> cachedVertices{};
+			std::span<const uint32_t> cachedIndices{};
+			std::span<const Meshlet> cachedMeshlets{};
+			std::span<const Lod> cachedLods{};
+			std::span<const Submesh> cachedSubmeshes{};
+			std::span<const Part> cachedParts{};
+			std::span<const Instance> cachedInstances{};
+			std::span<const glm::vec4> cachedMaterials{};
 		};
 
 		SteelSightModel(SteelSightDevice& device, const SteelSightModel::Builder& builder);
+
+		/// <summary>
+		/// Uploads a model that replaces an earlier load of the same file. A vertex or index range whose content did not change is shared with the previous model instead of uploaded again.
+		/// </summary>
+		/// <param name="device">The device to upload to</param>
+		/// <param name="builder">The loaded mesh</param>
+		/// <param name="previous">The model to take unchanged ranges from, may be nullptr. Only read, so the render thread can keep drawing it</param>
+		SteelSightModel(SteelSightDevice& device, const SteelSightModel::Builder& builder, const SteelSightModel* previous);
+
+		/// <summary>
+		/// Allocates the vertex and index ranges of a progressive model whose batches arrive later through uploadBatch, see SteelSightProgressive. It may only be drawn once the first batch arrived.
+		/// </summary>
+		/// <param name="device">The device to upload to</param>
+		/// <param name="layout">The tables of the model, its vertices and indices are empty</param>
+		/// <param name="vertexCount">Vertices of the whole model</param>
+		/// <param name="indexCount">Indices of the whole model</param>
+		/// <param name="batchCount">Batches that will be uploaded</param>
+		/// <param name="minimum">Bounding box of the whole model, the quantization range of compact vertices</param>
+		/// <param name="maximum">Bounding box of the whole model</param>
+		SteelSightModel(SteelSightDevice& device, const SteelSightModel::Builder& layout, uint32_t vertexCount, uint32_t indexCount, uint32_t batchCount, const glm::vec3& minimum, const glm::vec3& maximum);
 		~SteelSightModel() = default;
 
 		SteelSightModel(const SteelSightModel&) = delete;
 		SteelSightModel& operator=(const SteelSightModel&) = delete;
 
 		static std::unique_ptr<SteelSightModel> createModelFromFile(SteelSightDevice& device, const std::string& filepath);
+		static std::unique_ptr<SteelSightModel> createModelFromFile(SteelSightDevice& device, const std::string& filepath, const LoadOptions& options);
+
+		// Axis aligned box from 0 to 1 with one gray material, drawn in place of models that are still loading
+		static std::unique_ptr<SteelSightModel> createUnitBox(SteelSightDevice& device);
+
+		/// <summary>
+		/// Binds the pages of the geometry pool the model lies in, unless they are bound already. Models in the same pages are drawn without binding again.
+		/// </summary>
+		/// <param name="commandBuffer">The command buffer to record into</param>
+		/// <param name="bound">The pages bound to the command buffer, updated by the bind</param>
+		void bind(VkCommandBuffer commandBuffer, SteelSightGeometryBinding& bound);
+
+		// Where the model lies in the geometry pool, passed as vertex offset and added to the first index of every indexed draw of the model
+		_NODISCARD int32_t getVertexOffset() const noexcept;
+		_NODISCARD uint32_t getIndexOffset() const noexcept;
+
+		/// <summary>
+		/// Draws instances of a level of detail of a part with one draw per submesh, without culling. The transforms are per instance vertex data, see SteelSightRenderSystem::InstanceData.
+		/// </summary>
+		/// <param name="commandBuffer">The command buffer to record into</param>
+		/// <param name="part">The part to draw</param>
+		/// <param name="lod">Level of detail of the part to draw</param>
+		/// <param name="firstInstance">First record of the bound instance buffer</param>
+		/// <param name="instanceCount">Instances to draw</param>
+		/// <param name="setMaterial">Called before the draws of every submesh</param>
+		void drawInstances(VkCommandBuffer commandBuffer, uint32_t part, uint32_t lod, uint32_t firstInstance, uint32_t instanceCount, const SetMaterial& setMaterial);
+
+		/// <summary>
+		/// Draws only the meshlets inside the view frustum (and facing the camera when cone culling is enabled).
+		/// Adjacent surviving meshlets of one submesh are merged into one indexed draw. Falls back to drawInstances when the model has no meshlets.
+		/// The meshlets belong to the full detail mesh, a coarser level of detail is drawn whole when the bounding sphere of the part is in view.
+		/// </summary>
+		/// <param name="commandBuffer">The command buffer to record into</param>
+		/// <param name="part">The part to draw</param>
+		/// <param name="modelMatrix">Model to world transform of the instance, the object transform times the instance transform</param>
+		/// <param name="projectionView">Projection * view of the camera</param>
+		/// <param name="cameraPosition">Camera position in world space</param>
+		/// <param name="lod">Level of detail of the part to draw</param>
+		/// <param name="firstInstance">Record of the instance in the bound instance buffer</param>
+		/// <param name="setMaterial">Called before the draws of every submesh</param>
+		void drawVisible(VkCommandBuffer commandBuffer, uint32_t part, const glm::mat4& modelMatrix, const glm::mat4& projectionView, const glm::vec3& cameraPosition, uint32_t lod, uint32_t firstInstance, const SetMaterial& setMaterial);
 
-		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		_NODISCARD inline const std::vector<Lod>& getLods() const noexcept { return lods; }
+		_NODISCARD inline const std::vector<Part>& getParts() const noexcept { return parts; }
+		_NODISCARD inline const std::vector<Instance>& getInstances() const noexcept { return instances; }
+
+		_NODISCARD inline VertexFormat getVertexFormat() const noexcept { return vertexFormat; }
+
+		// The vertex buffer has no normals, see LoadOptions::flatShading
+		_NODISCARD inline bool isFlatShaded() const noexcept { return flatShading; }
+
+		// Maps the quantized positions of a compact model back to model space, identity for full vertices
+		_NODISCARD inline const glm::mat4& getDequantization() const noexcept { return dequantization; }
+
+		_NODISCARD inline const std::vector<Submesh>& getSubmeshes() const noexcept { return submeshes; }
+
+		// Diffuse color of every material, the submeshes index into this
+		_NODISCARD inline const std::vector<glm::vec4>& getMaterials() const noexcept { return materials; }
+
+		// Material base of a model whose materials are not in the material table yet
+		static constexpr uint32_t NO_MATERIAL_BASE{ UINT32_MAX };
+
+		// Index of the first material of the model in the material table of the application
+		_NODISCARD inline uint32_t getMaterialBase() const noexcept { return materialBase; }
+		_NODISCARD inline bool hasMaterialBase() const noexcept { return materialBase != NO_MATERIAL_BASE; }
+		inline void setMaterialBase(uint32_t base) noexcept { materialBase = base; materialFallback = false; }
+
+		// Draws every material of the model with one entry of the material table, when the table had no room for the materials of the model
+		inline void setFallbackMaterial(uint32_t material) noexcept { materialBase = material; materialFallback = true; }
+		_NODISCARD inline bool usesFallbackMaterial() const noexcept { return materialFallback; }
+
+		// Index in the material table of a material of the model
+		_NODISCARD inline uint32_t getMaterialIndex(uint32_t material) const noexcept { return materialFallback ? materialBase : materialBase + material; }
+
+		// Bytes of the geometry pool held by the vertex and index ranges
+		_NODISCARD VkDeviceSize getGpuMemorySize() const noexcept;
+
+		// Bounding sphere of every instance of the model in model space, xyz is the center and w the radius
+		_NODISCARD inline const glm::vec4& getBoundingSphere() const noexcept { return boundingSphere; }
+
+		/// <summary>
+		/// Exchanges the geometry, buffers and materials of two models, the material base stays. Swaps a reloaded model into the model every object points to,
+		/// afterwards other holds the old buffers and must be kept alive until the frames in flight that drew them finished.
+		/// </summary>
+		void swapContents(SteelSightModel& other) noexcept;
+
+		/// <summary>
+		/// Uploads the next batch of a progressive model, from a loader thread while the render thread draws the batches before it. Returns once the copies are submitted.
+		/// The base mesh is polled with isUploaded like the upload of any other model, a finer level is counted by updateStreaming once its upload is complete.
+		/// </summary>
+		/// <param name="vertices">The vertices of the batch</param>
+		/// <param name="firstVertex">Where they go in the vertices of the model</param>
+		/// <param name="indices">The indices of the batch</param>
+		/// <param name="firstIndex">Where they go in the indices of the model</param>
+		void uploadBatch(std::span<const Vertex> vertices, uint32_t firstVertex, std::span<const uint32_t> indices, uint32_t firstIndex);
+
+		// Counts the batches after the base mesh whose uploads are complete, in order. Called by the render thread every frame while the model streams
+		void updateStreaming();
+
+		// A progressive model that has not received all of its batches yet
+		_NODISCARD inline bool isStreaming() const noexcept { return streamedBatches.load(std::memory_order_acquire) < batchCount; }
+
+		// Finest level of detail of a part that is on the GPU, 0 once every batch arrived and for models that are not streamed
+		_NODISCARD inline uint32_t getFinestLod(uint32_t part) const noexcept {
+			const uint32_t streamed = streamedBatches.load(std::memory_order_acquire);
+			const uint32_t lodCount = parts[part].lodCount;
+			return streamed >= lodCount ? 0 : lodCount - streamed;
+		}
+
+		// Whether the copies into the vertex and index buffers finished, a loaded model is only handed to the render thread afterwards
+		_NODISCARD inline bool isUploaded() const noexcept { return uploadToken.isComplete(); }
+
+		// Whether the vertex and index ranges were shared with the previous model instead of uploaded
+		_NODISCARD inline bool reusedVertexBuffer() const noexcept { return vertexBufferReused; }
+		_NODISCARD inline bool reusedIndexBuffer() const noexcept { return indexBufferReused; }
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& verteces);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
+		void createVertexBuffers(std::span<const Vertex> vertices, VertexFormat format, bool flat, const SteelSightModel* previous, SteelSightUploadBatch& batch);
+		void createCompactVertexBuffers(std::span<const Vertex> vertices, SteelSightUploadBatch& batch);
+		void uploadVertexBuffer(const void* vertices, uint32_t vertexSize, uint32_t count, SteelSightUploadBatch& batch);
+		void createIndexBuffers(std::span<const uint32_t> indices, const SteelSightModel* previous, SteelSightUploadBatch& batch);
+		void assignTables(const SteelSightModel::Builder& builder);
+		// Records a copy of elements into a part of a range of the geometry pool
+		void uploadRange(SteelSightUploadBatch& batch, const SteelSightGeometryRange& range, const void* data, uint32_t elementSize, uint32_t count, uint32_t firstElement);
+		void drawLevel(VkCommandBuffer commandBuffer, const Lod& level, uint32_t firstInstance, uint32_t instanceCount, const SetMaterial& setMaterial);
 
 		SteelSightDevice& SSDevice;
 
-		std::unique_ptr<SteelSightBuffer> vertexBuffer;
+		// Ranges of the geometry pool of the device, shared with the model of a reload when the content did not change
+		std::shared_ptr<SteelSightGeometryRange> vertexRange;
 		uint32_t vertexCount;
 
 		bool hasIndexBuffer{ false };
 
-		std::unique_ptr<SteelSightBuffer> indexBuffer;
+		std::shared_ptr<SteelSightGeometryRange> indexRange;
 		uint32_t indexCount;
+
+		// Hash of the uploaded content, the vertex hash includes the vertex format
+		uint64_t vertexHash{ 0 };
+		uint64_t indexHash{ 0 };
+		bool vertexBufferReused{ false };
+		bool indexBufferReused{ false };
+
+		// The submission of the vertices and indices, for a progressive model the one of the base mesh
+		SteelSightUploadToken uploadToken{};
+
+		// Batches of a progressive model, a model that is not streamed counts as having all of them
+		uint32_t batchCount{ 0 };
+		std::atomic<uint32_t> streamedBatches{ UINT32_MAX };
+
+		// Submitted batches after the base mesh that are not counted yet, the loader adds and the render thread removes them
+		std::mutex streamMutex{};
+		std::vector<SteelSightUploadToken> pendingBatches{};
+
+		std::vector<Meshlet> meshlets{};
+		bool meshletConeCulling{ false };
+
+		std::vector<Lod> lods{};
+		std::vector<Submesh> submeshes{};
+		std::vector<Part> parts{};
+		std::vector<Instance> instances{};
+		glm::vec4 boundingSphere{ 0.f };
+
+		VertexFormat vertexFormat{ VertexFormat::Full };
+		bool flatShading{ false };
+		glm::mat4 dequantization{ 1.f };
+
+		std::vector<glm::vec4> materials{};
+		uint32_t materialBase{ NO_MATERIAL_BASE };
+		bool materialFallback{ false };
 	};
 }
\ No newline at end of file
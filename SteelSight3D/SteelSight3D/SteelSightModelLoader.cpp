@@ -0,0 +1,186 @@
+#include "SteelSightModelLoader.hpp"
+#include "SteelSightUtils.hpp"
+#include "SteelSightProgressive.hpp"
+#include "SteelSightMeshCache.hpp"
+
+#include <iostream>
+#include <exception>
+#include <algorithm>
+
+namespace Voortman {
+	bool SteelSightModelHandle::getBounds(glm::vec3& minimum, glm::vec3& maximum) const noexcept {
+		if (!boundsKnown.load(std::memory_order_acquire)) return false;
+
+		minimum = boundsMinimum;
+		maximum = boundsMaximum;
+		return true;
+	}
+
+	void SteelSightModelHandle::wait() const noexcept {
+		state.wait(State::Loading, std::memory_order_acquire);
+	}
+
+	void SteelSightModelHandle::setBounds(const glm::vec3& minimum, const glm::vec3& maximum) noexcept {
+		boundsMinimum = minimum;
+		boundsMaximum = maximum;
+		boundsKnown.store(true, std::memory_order_release);
+	}
+
+	void SteelSightModelHandle::setSource(const std::string& filepath) noexcept {
+		// A file that can not be read fails the load anyway
+		std::error_code error{};
+		source.writeTime = std::filesystem::last_write_time(filepath, error);
+		source.fileSize = std::filesystem::file_size(filepath, error);
+		if (source.fileSize == static_cast<uintmax_t>(-1)) _UNLIKELY source.fileSize = 0;
+	}
+
+	void SteelSightModelHandle::finish(std::shared_ptr<SteelSightModel> loadedModel) noexcept {
+		model = std::move(loadedModel);
+		state.store(State::Ready, std::memory_order_release);
+		state.notify_all();
+	}
+
+	void SteelSightModelHandle::fail(const std::string& message) {
+		error = message;
+		state.store(State::Failed, std::memory_order_release);
+		state.notify_all();
+	}
+
+	SteelSightModelLoader::SteelSightModelLoader(SteelSightDevice& device) : SteelSightModelLoader{ device, std::min(DEFAULT_THREADS, resolveWorkerCount(0)) } {}
+
+	SteelSightModelLoader::SteelSightModelLoader(SteelSightDevice& device, uint32_t threadCount) : SSDevice{ device } {
+		const uint32_t workerCount = resolveWorkerCount(threadCount);
+		workers.reserve(workerCount);
+		for (uint32_t worker = 0; worker < workerCount; ++worker) workers.emplace_back([this]() { workerLoop(); });
+	}
+
+	SteelSightModelLoader::~SteelSightModelLoader() {
+		std::deque<Job> cancelled{};
+		{
+			std::lock_guard lock{ mutex };
+			stopping = true;
+			cancelled.swap(jobs);
+		}
+		condition.notify_all();
+
+		// Loads that already started finish, the rest never starts
+		for (auto& job : cancelled) job.handle->fail("cancelled");
+		for (auto& worker : workers) worker.join();
+	}
+
+	std::shared_ptr<SteelSightModelHandle> SteelSightModelLoader::createModelFromFile(const std::string& filepath) {
+		return createModelFromFile(filepath, SteelSightModel::LoadOptions{});
+	}
+
+	std::shared_ptr<SteelSightModelHandle> SteelSightModelLoader::createModelFromFile(const std::string& filepath, const SteelSightModel::LoadOptions& options) {
+		auto handle = std::make_shared<SteelSightModelHandle>(filepath);
+		{
+			std::lock_guard lock{ mutex };
+			jobs.push_back({ handle, options });
+		}
+		condition.notify_one();
+		return handle;
+	}
+
+	std::shared_ptr<SteelSightModelHandle> SteelSightModelLoader::reloadModel(const std::string& filepath, const SteelSightModel::LoadOptions& options, std::shared_ptr<const SteelSightModel> previous) {
+		auto handle = std::make_shared<SteelSightModelHandle>(filepath);
+		{
+			std::lock_guard lock{ mutex };
+			jobs.push_back({ handle, options, std::move(previous) });
+		}
+		condition.notify_one();
+		return handle;
+	}
+
+	void SteelSightModelLoader::workerLoop() {
+		while (true) {
+			Job job{};
+			{
+				std::unique_lock lock{ mutex };
+				condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (stopping) return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			load(job);
+		}
+	}
+
+	void SteelSightModelLoader::load(const Job& job) {
+		auto& handle = *job.handle;
+
+		// A reload replaces the contents of a drawn model at once, so it is never streamed
+		if (job.previous == nullptr) _LIKELY {
+			if (SteelSightProgressive::isProgressive(handle.getPath())) {
+				stream(job, handle.getPath());
+				return;
+			}
+			if (job.options.progressive && SteelSightProgressive::isUpToDate(handle.getPath())) {
+				stream(job, SteelSightProgressive::getProgressivePath(handle.getPath()));
+				return;
+			}
+		}
+
+		try {
+			SteelSightModel::Builder builder{};
+			builder.options = job.options;
+			builder.onBounds = [&handle](const glm::vec3& minimum, const glm::vec3& maximum) { handle.setBounds(minimum, maximum); };
+			handle.setSource(handle.getPath());
+			builder.loadModel(handle.getPath());
+
+			// The registry compares the content of a reload with the drawn model, the mesh cache already hashed the file when it is on
+			handle.source.contentHash = builder.contentHash != 0 ? builder.contentHash : SteelSightMeshCache::hashSource(handle.getPath());
+
+			// The copies are submitted from this thread without waiting for them, the registry hands the model to the render thread once they finished
+			handle.finish(std::make_shared<SteelSightModel>(SSDevice, builder, job.previous.get()));
+		}
+		catch (const std::exception& exception) {
+			std::cerr << "Failed to load " << handle.getPath() << ": " << exception.what() << std::endl;
+			handle.fail(exception.what());
+		}
+	}
+
+	void SteelSightModelLoader::stream(const Job& job, const std::string& progressivePath) {
+		auto& handle = *job.handle;
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		try {
+			SteelSightModel::Builder layout{};
+			layout.options = job.options;
+			// Not hashed, the base mesh is drawn as early as possible. The first reload is always applied
+			handle.setSource(handle.getPath());
+			SteelSightProgressive::Reader reader{ progressivePath, layout };
+			handle.setBounds(reader.getMinimum(), reader.getMaximum());
+
+			auto model = std::make_shared<SteelSightModel>(SSDevice, layout, reader.getVertexCount(), reader.getIndexCount(), reader.getBatchCount(), reader.getMinimum(), reader.getMaximum());
+
+			std::vector<SteelSightModel::Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			const auto base = reader.readBatch(vertices, indices);
+			model->uploadBatch(vertices, base.firstVertex, indices, base.firstIndex);
+
+			// The coarsest level of every part is on the GPU, the model can be drawn
+			handle.finish(model);
+			const auto drawable = std::chrono::high_resolution_clock::now();
+
+			while (reader.getBatchesRead() < reader.getBatchCount()) {
+				const auto batch = reader.readBatch(vertices, indices);
+				model->uploadBatch(vertices, batch.firstVertex, indices, batch.firstIndex);
+			}
+
+			const auto complete = std::chrono::high_resolution_clock::now();
+			std::cout << progressivePath << std::endl;
+			std::cout << "Progressive load: base mesh drawable after " << std::chrono::duration_cast<std::chrono::milliseconds>(drawable - start) << ", complete after "
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(complete - start) << " (" << reader.getBatchCount() << " batches), full load "
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(reader.getFullLoadTime()) << " plus its upload" << std::endl << std::endl;
+		}
+		catch (const std::exception& exception) {
+			std::cerr << "Failed to stream " << progressivePath << ": " << exception.what() << std::endl;
+
+			// Once the base mesh is drawn the model stays at the levels that arrived
+			if (!handle.isReady()) handle.fail(exception.what());
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include "SteelSightModel.hpp"
+#include "SteelSightDevice.hpp"
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+namespace Voortman {
+	/// <summary>
+	/// A model that is loaded in the background by SteelSightModelLoader. The loader thread fills the handle, the render thread polls it every frame.
+	/// </summary>
+	class SteelSightModelHandle final {
+	public:
+		enum class State : uint8_t {
+			Loading,
+			Ready,
+			Failed,
+		};
+
+		// The file a model was loaded from, its write time and size are read before the file is
+		struct Source final {
+			std::filesystem::file_time_type writeTime{};
+			uintmax_t fileSize{ 0 };
+			// See SteelSightMeshCache::hashSource, 0 for a streamed model
+			uint64_t contentHash{ 0 };
+		};
+
+		explicit SteelSightModelHandle(const std::string& filepath) : path{ filepath }, requestTime{ std::chrono::steady_clock::now() } {}
+
+		SteelSightModelHandle(const SteelSightModelHandle&) = delete;
+		SteelSightModelHandle& operator=(const SteelSightModelHandle&) = delete;
+
+		_NODISCARD inline State getState() const noexcept { return state.load(std::memory_order_acquire); }
+		_NODISCARD inline bool isReady() const noexcept { return getState() == State::Ready; }
+		_NODISCARD inline const std::string& getPath() const noexcept { return path; }
+
+		// The uploaded model once the state is Ready, nullptr before that and after a failure
+		_NODISCARD inline std::shared_ptr<SteelSightModel> getModel() const noexcept { return isReady() ? model : nullptr; }
+
+		// The file the model was loaded from, only valid once the state is Ready
+		_NODISCARD inline const Source& getSource() const noexcept { return source; }
+
+		// Why the load failed, only valid once the state is Failed
+		_NODISCARD inline const std::string& getError() const noexcept { return error; }
+
+		// When the model was requested, to measure the time until it is first drawn
+		_NODISCARD inline std::chrono::steady_clock::time_point getRequestTime() const noexcept { return requestTime; }
+
+		/// <summary>
+		/// Model space bounding box, known as soon as the file is parsed or the mesh cache is mapped. Long before the model is uploaded.
+		/// </summary>
+		/// <returns>False while the bounds are not known yet</returns>
+		_NODISCARD bool getBounds(glm::vec3& minimum, glm::vec3& maximum) const noexcept;
+
+		// Blocks until the model is ready or failed
+		void wait() const noexcept;
+
+	private:
+		friend class SteelSightModelLoader;
+
+		void setBounds(const glm::vec3& minimum, const glm::vec3& maximum) noexcept;
+		// Takes the write time and size of the file, called before the file is read
+		void setSource(const std::string& filepath) noexcept;
+		void finish(std::shared_ptr<SteelSightModel> loadedModel) noexcept;
+		void fail(const std::string& message);
+
+		const std::string path;
+		const std::chrono::steady_clock::time_point requestTime;
+
+		// Written once by the loader thread before the matching flag or state is released
+		std::shared_ptr<SteelSightModel> model{};
+		Source source{};
+		std::string error{};
+		glm::vec3 boundsMinimum{ 0.f };
+		glm::vec3 boundsMaximum{ 0.f };
+
+		std::atomic<bool> boundsKnown{ false };
+		std::atomic<State> state{ State::Loading };
+	};
+
+	/// <summary>
+	/// Loads models on a small pool of worker threads. Parsing, welding, optimizing and the GPU upload all happen on the worker,
+	/// so the render thread keeps drawing while large files load and independent files load in parallel.
+	/// </summary>
+	class SteelSightModelLoader final {
+	public:
+		// Every load already parses and welds on multiple threads, a few loads at once are enough to hide the file and upload latency
+		static constexpr uint32_t DEFAULT_THREADS{ 4 };
+
+		SteelSightModelLoader(SteelSightDevice& device);
+		SteelSightModelLoader(SteelSightDevice& device, uint32_t threadCount);
+		~SteelSightModelLoader();
+
+		SteelSightModelLoader(const SteelSightModelLoader&) = delete;
+		SteelSightModelLoader& operator=(const SteelSightModelLoader&) = delete;
+
+		/// <summary>
+		/// Asynchronous SteelSightModel::createModelFromFile, returns at once. The handle becomes ready when the model is uploaded.
+		/// A progressive file (see SteelSightProgressive) is streamed instead, its handle becomes ready once the base mesh is uploaded and the finer levels follow.
+		/// That is a .ssprog path, or the up to date progressive file of a model loaded with LoadOptions::progressive.
+		/// </summary>
+		/// <param name="filepath">Path of the model</param>
+		/// <param name="options">Load options, see SteelSightModel::LoadOptions</param>
+		/// <returns>Handle to poll for the model</returns>
+		_NODISCARD std::shared_ptr<SteelSightModelHandle> createModelFromFile(const std::string& filepath);
+		_NODISCARD std::shared_ptr<SteelSightModelHandle> createModelFromFile(const std::string& filepath, const SteelSightModel::LoadOptions& options);
+
+		/// <summary>
+		/// Loads a changed file again in the background. Buffers whose content did not change are shared with the previous model, see SteelSightModel::swapContents to put the result in place.
+		/// </summary>
+		/// <param name="filepath">Path of the model</param>
+		/// <param name="options">Load options of the previous model</param>
+		/// <param name="previous">The model that is drawn now, kept alive by the job</param>
+		/// <returns>Handle to poll for the new model</returns>
+		_NODISCARD std::shared_ptr<SteelSightModelHandle> reloadModel(const std::string& filepath, const SteelSightModel::LoadOptions& options, std::shared_ptr<const SteelSightModel> previous);
+
+	private:
+		struct Job final {
+			std::shared_ptr<SteelSightModelHandle> handle{};
+			SteelSightModel::LoadOptions options{};
+			std::shared_ptr<const SteelSightModel> previous{};
+		};
+
+		void workerLoop();
+		void load(const Job& job);
+		// Returns once every batch is submitted, the handle is finished after the first batch
+		void stream(const Job& job, const std::string& progressivePath);
+
+		SteelSightDevice& SSDevice;
+
+		std::mutex mutex{};
+		std::condition_variable condition{};
+		std::deque<Job> jobs{};
+		bool stopping{ false };
+
+		std::vector<std::thread> workers{};
+	};
+}
@@ -0,0 +1,248 @@
+#include "SteelSightModelRegistry.hpp"
+#include "SteelSightSwapChain.hpp"
+#include "SteelSightUtils.hpp"
+
+#include <iostream>
+#include <exception>
+#include <algorithm>
+#include <vector>
+
+namespace Voortman {
+	SteelSightModelRegistry::SteelSightModelRegistry(SteelSightModelLoader& loader, SteelSightMaterialTable& materialTable) : SteelSightModelRegistry{ loader, materialTable, DEFAULT_VRAM_BUDGET } {}
+
+	SteelSightModelRegistry::SteelSightModelRegistry(SteelSightModelLoader& loader, SteelSightMaterialTable& materialTable, VkDeviceSize vramBudget)
+		: loader{ loader }, materialTable{ materialTable }, vramBudget{ vramBudget } {}
+
+	std::shared_ptr<SteelSightModelHandle> SteelSightModelRegistry::acquire(const std::string& filepath) {
+		return acquire(filepath, SteelSightModel::LoadOptions{});
+	}
+
+	std::shared_ptr<SteelSightModelHandle> SteelSightModelRegistry::acquire(const std::string& filepath, const SteelSightModel::LoadOptions& options) {
+		const uint64_t key = makeKey(filepath, options);
+
+		if (auto it = entries.find(key); it != entries.end()) {
+			it->second.lastUsedFrame = frame;
+			return it->second.handle;
+		}
+
+		auto handle = loader.createModelFromFile(filepath, options);
+		entries.emplace(key, Entry{ handle, options, 0, frame, false });
+		if (hotReload) watcher.watch(filepath);
+		return handle;
+	}
+
+	uint64_t SteelSightModelRegistry::makeKey(const std::string& filepath, const SteelSightModel::LoadOptions& options) {
+		// The loader reports why a file can not be read, the path alone still keeps concurrent requests together
+		std::error_code error{};
+		const auto writeTime = std::filesystem::last_write_time(filepath, error);
+		if (error) _UNLIKELY return makeKey(filepath, {}, 0, options);
+
+		const auto fileSize = std::filesystem::file_size(filepath, error);
+		return makeKey(filepath, writeTime, error ? 0 : fileSize, options);
+	}
+
+	uint64_t SteelSightModelRegistry::makeKey(const std::string& filepath, std::filesystem::file_time_type writeTime, uintmax_t fileSize, const SteelSightModel::LoadOptions& options) {
+		// Different spellings of the same path share the model
+		std::error_code error{};
+		const std::filesystem::path canonical = std::filesystem::weakly_canonical(filepath, error);
+
+		std::size_t key = ankerl::unordered_dense::hash<std::string>{}(error ? filepath : canonical.generic_string());
+		hashCombine(key, static_cast<int64_t>(writeTime.time_since_epoch().count()), fileSize);
+
+		// Only the options that change the uploaded or drawn model are part of the key, the weld threads and mode produce the same mesh
+		hashCombine(key, options.optimizeMesh, options.buildMeshlets, options.meshletConeCulling, options.buildLods, options.vertexFormat, options.detectInstances,
+			options.weldEpsilon, options.weldNormalAngle, options.removeDegenerates, options.streamingParse,
+			options.stlNormals, options.stlSmoothingAngle, options.flatShading, options.progressive);
+		return key;
+	}
+
+	void SteelSightModelRegistry::update() {
+		++frame;
+
+		// Every frame that could still draw a swapped out model has finished
+		std::erase_if(retired, [this](const RetiredModel& model) { return frame - model.frame > SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT; });
+
+		std::vector<std::pair<uint64_t, uint64_t>> rekeyed{};
+		updateReloads(rekeyed);
+
+		// A reloaded file has a new write time, so a later request for it must find the reloaded model under its new key
+		for (const auto& [oldKey, newKey] : rekeyed) {
+			const auto it = entries.find(oldKey);
+			Entry entry = std::move(it->second);
+			entries.erase(it);
+			entries.emplace(newKey, std::move(entry));
+		}
+
+		std::vector<uint64_t> failed{};
+		for (auto& [key, entry] : entries) {
+			const auto state = entry.handle->getState();
+			if (state == SteelSightModelHandle::State::Loading) continue;
+
+			// Failed loads are forgotten once nobody waits for them, so a fixed file can be requested again
+			if (state == SteelSightModelHandle::State::Failed) _UNLIKELY {
+				if (!isReferenced(entry)) failed.push_back(key);
+				continue;
+			}
+
+			const auto model = entry.handle->getModel();
+			if (!entry.resident) {
+				// The loader submitted the copies without waiting for them, the model is polled every frame until they are complete
+				if (!model->isUploaded()) continue;
+
+				addMaterials(*model);
+
+				entry.contentHash = entry.handle->getSource().contentHash;
+				entry.gpuSize = model->getGpuMemorySize();
+				entry.resident = true;
+				residentSize += entry.gpuSize;
+			}
+
+			// The finer levels of a progressive model are drawn once their uploads are complete
+			if (model->isStreaming()) model->updateStreaming();
+
+			if (isReferenced(entry)) entry.lastUsedFrame = frame;
+		}
+
+		for (const uint64_t key : failed) {
+			const auto it = entries.find(key);
+			const std::string path = it->second.handle->getPath();
+			entries.erase(it);
+			forget(path);
+		}
+
+		evict();
+	}
+
+	void SteelSightModelRegistry::updateReloads(std::vector<std::pair<uint64_t, uint64_t>>& rekeyed) {
+		if (hotReload) {
+			for (const auto& path : watcher.poll()) {
+				for (auto& [key, entry] : entries) {
+					if (entry.handle->getPath() == path) entry.reloadPending = true;
+				}
+			}
+		}
+
+		for (auto& [key, entry] : entries) {
+			if (entry.reload) {
+				const auto state = entry.reload->getState();
+				if (state == SteelSightModelHandle::State::Loading) continue;
+				if (state == SteelSightModelHandle::State::Ready && !entry.reload->getModel()->isUploaded()) continue;
+
+				// A file that fails to load, for example because it was read while the exporter was still writing, leaves the model as it was
+				if (state == SteelSightModelHandle::State::Failed) _UNLIKELY {
+					std::cerr << "Kept the previous " << entry.handle->getPath() << ", reloading failed: " << entry.reload->getError() << std::endl;
+				}
+				else {
+					// The loader thread hashed the file, a save without changes keeps the model and only moves it to the new key
+					const auto& source = entry.reload->getSource();
+					if (source.contentHash == 0 || source.contentHash != entry.contentHash) _LIKELY {
+						applyReload(entry, entry.reload->getModel());
+						entry.contentHash = source.contentHash;
+					}
+
+					// Keyed by the file the reload read, a change after that is already pending
+					const uint64_t newKey = makeKey(entry.handle->getPath(), source.writeTime, source.fileSize, entry.options);
+					if (newKey != key && !entries.contains(newKey)) rekeyed.emplace_back(key, newKey);
+				}
+
+				entry.reload.reset();
+			}
+
+			// A model is reloaded once its first load is uploaded and has its materials, a change during a load waits for that load.
+			// A progressive model that is still streaming waits as well, the loader keeps writing into its buffers
+			if (entry.reloadPending && entry.resident && !entry.reload && !entry.handle->getModel()->isStreaming()) {
+				entry.reloadPending = false;
+				entry.reload = loader.reloadModel(entry.handle->getPath(), entry.options, entry.handle->getModel());
+			}
+		}
+	}
+
+	void SteelSightModelRegistry::applyReload(Entry& entry, const std::shared_ptr<SteelSightModel>& reloaded) {
+		const auto model = entry.handle->getModel();
+
+		// Objects keep pointing at the same model, afterwards reloaded holds the old buffers
+		model->swapContents(*reloaded);
+		retired.push_back({ reloaded, frame });
+
+		// The colors are changed in place when the material count stayed the same, otherwise the old range goes back to the table and the model gets a new one
+		const auto& materials = model->getMaterials();
+		const auto& oldMaterials = reloaded->getMaterials();
+		if (materials.size() == oldMaterials.size() && !model->usesFallbackMaterial()) {
+			for (size_t material = 0; material < materials.size(); ++material) {
+				if (materials[material] != oldMaterials[material]) materialTable.setColor(model->getMaterialIndex(static_cast<uint32_t>(material)), materials[material]);
+			}
+		}
+		else {
+			releaseMaterials(*model, oldMaterials.size());
+			addMaterials(*model);
+		}
+
+		residentSize -= entry.gpuSize;
+		entry.gpuSize = model->getGpuMemorySize();
+		residentSize += entry.gpuSize;
+
+		std::cout << "Reloaded " << entry.handle->getPath() << ": vertex buffer " << (model->reusedVertexBuffer() ? "reused" : "uploaded")
+			<< ", index buffer " << (model->reusedIndexBuffer() ? "reused" : "uploaded") << ", " << entry.gpuSize / 1024 << " KB" << std::endl;
+	}
+
+	void SteelSightModelRegistry::addMaterials(SteelSightModel& model) {
+		if (const auto base = materialTable.add(model.getMaterials())) _LIKELY model.setMaterialBase(*base);
+		else model.setFallbackMaterial(SteelSightMaterialTable::FALLBACK_MATERIAL);
+	}
+
+	void SteelSightModelRegistry::releaseMaterials(const SteelSightModel& model, size_t count) {
+		if (!model.hasMaterialBase() || model.usesFallbackMaterial()) return;
+		materialTable.free(model.getMaterialBase(), static_cast<uint32_t>(count));
+	}
+
+	void SteelSightModelRegistry::forget(const std::string& filepath) {
+		for (const auto& [key, entry] : entries) {
+			if (entry.handle->getPath() == filepath) return;
+		}
+
+		watcher.unwatch(filepath);
+	}
+
+	bool SteelSightModelRegistry::isReferenced(const Entry& entry) noexcept {
+		if (entry.handle.use_count() > 1) return true;
+
+		// The handle and the copy returned by getModel, every other owner is an object that draws the model
+		const auto model = entry.handle->getModel();
+		return model && model.use_count() > 2;
+	}
+
+	void SteelSightModelRegistry::evict() {
+		if (residentSize <= vramBudget) _LIKELY return;
+
+		// Frames in flight may still draw a model that lost its last object, those are only released after the frames finished
+		std::vector<std::pair<uint64_t, uint64_t>> candidates{};
+		for (const auto& [key, entry] : entries) {
+			if (!entry.resident || isReferenced(entry)) continue;
+			if (frame - entry.lastUsedFrame <= SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT) continue;
+
+			candidates.emplace_back(entry.lastUsedFrame, key);
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		for (const auto& [lastUsedFrame, key] : candidates) {
+			if (residentSize <= vramBudget) break;
+
+			const auto it = entries.find(key);
+			residentSize -= it->second.gpuSize;
+			++evictedModels;
+			evictedSize += it->second.gpuSize;
+
+			// Unused for longer than the frames in flight, no frame draws with its materials any more
+			releaseMaterials(*it->second.handle->getModel(), it->second.handle->getModel()->getMaterials().size());
+
+			const std::string path = it->second.handle->getPath();
+			entries.erase(it);
+			forget(path);
+		}
+	}
+
+	void SteelSightModelRegistry::printStatistics() const {
+		std::cout << "Model registry: " << entries.size() << " models, " << residentSize / (1024 * 1024) << " of " << vramBudget / (1024 * 1024) << " MB resident, "
+			<< evictedModels << " released over the budget (" << evictedSize / 1024 << " KB)" << std::endl;
+	}
+}
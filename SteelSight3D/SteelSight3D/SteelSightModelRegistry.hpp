@@ -0,0 +1,118 @@
+#pragma once
+#include "SteelSightModel.hpp"
+#include "SteelSightModelLoader.hpp"
+#include "SteelSightMaterialTable.hpp"
+#include "SteelSightFileWatcher.hpp"
+
+#include <string>
+#include <memory>
+#include <filesystem>
+#include "unordered_dense.h"
+
+namespace Voortman {
+	/// <summary>
+	/// Shares loaded models between every object that uses the same file. A request for a model that is already loaded or still loading returns the existing handle,
+	/// so an assembly that references the same bolt a hundred times parses, uploads and stores it once.
+	/// Models are keyed by the canonical path, write time and size of the file and the load options, so a request never reads the file on the render thread.
+	/// A changed file gets a new key and is loaded again, the loader threads hash its content.
+	/// Models that no object uses any more stay resident as long as everything fits in the VRAM budget, beyond that the least recently used ones are released.
+	/// With hot reload enabled the files of the models are watched, a changed file is loaded again on the loader threads and swapped into the existing model between frames,
+	/// so the objects keep their model and only the buffers whose content changed are uploaded.
+	/// Only used on the render thread.
+	/// </summary>
+	class SteelSightModelRegistry final {
+	public:
+		static constexpr VkDeviceSize DEFAULT_VRAM_BUDGET{ 512ull * 1024 * 1024 };
+
+		SteelSightModelRegistry(SteelSightModelLoader& loader, SteelSightMaterialTable& materialTable);
+		SteelSightModelRegistry(SteelSightModelLoader& loader, SteelSightMaterialTable& materialTable, VkDeviceSize vramBudget);
+		~SteelSightModelRegistry() = default;
+
+		SteelSightModelRegistry(const SteelSightModelRegistry&) = delete;
+		SteelSightModelRegistry& operator=(const SteelSightModelRegistry&) = delete;
+
+		/// <summary>
+		/// Returns the shared handle of a model, starts loading it on the loader threads when no handle for the same file and options exists.
+		/// </summary>
+		/// <param name="filepath">Path of the model</param>
+		/// <param name="options">Load options, see SteelSightModel::LoadOptions</param>
+		/// <returns>Handle to poll for the model, the model is ready once it also has a material base</returns>
+		_NODISCARD std::shared_ptr<SteelSightModelHandle> acquire(const std::string& filepath);
+		_NODISCARD std::shared_ptr<SteelSightModelHandle> acquire(const std::string& filepath, const SteelSightModel::LoadOptions& options);
+
+		/// <summary>
+		/// Called once per frame before the frame is recorded. Adds the materials of models that finished loading to the material table, swaps in reloaded models
+		/// and releases unused models and their materials while the resident models exceed the budget.
+		/// </summary>
+		void update();
+
+		// Watches the files of the models, on by default. Only models acquired while enabled are watched
+		inline void setHotReload(bool enabled) noexcept { hotReload = enabled; }
+		_NODISCARD inline bool getHotReload() const noexcept { return hotReload; }
+
+		_NODISCARD inline VkDeviceSize getBudget() const noexcept { return vramBudget; }
+		inline void setBudget(VkDeviceSize budget) noexcept { vramBudget = budget; }
+
+		// Bytes of device memory held by every resident model, used or not
+		_NODISCARD inline VkDeviceSize getResidentSize() const noexcept { return residentSize; }
+
+		// Models that are loaded or loading
+		_NODISCARD inline size_t size() const noexcept { return entries.size(); }
+
+		// Resident models against the budget and the models released to stay within it
+		void printStatistics() const;
+
+	private:
+		struct Entry final {
+			std::shared_ptr<SteelSightModelHandle> handle{};
+			SteelSightModel::LoadOptions options{};
+			VkDeviceSize gpuSize{ 0 };
+			uint64_t lastUsedFrame{ 0 };
+			bool resident{ false };
+			// Content hash of the drawn model, see SteelSightModelHandle::Source
+			uint64_t contentHash{ 0 };
+
+			// The load of the changed file, at most one at a time
+			std::shared_ptr<SteelSightModelHandle> reload{};
+			// The file changed again, or changed before the first load finished
+			bool reloadPending{ false };
+		};
+
+		// A model that was swapped out, its buffers may still be read by the frames in flight
+		struct RetiredModel final {
+			std::shared_ptr<SteelSightModel> model{};
+			uint64_t frame{ 0 };
+		};
+
+		// Only reads the metadata of the file
+		_NODISCARD static uint64_t makeKey(const std::string& filepath, const SteelSightModel::LoadOptions& options);
+		_NODISCARD static uint64_t makeKey(const std::string& filepath, std::filesystem::file_time_type writeTime, uintmax_t fileSize, const SteelSightModel::LoadOptions& options);
+		_NODISCARD static bool isReferenced(const Entry& entry) noexcept;
+		void evict();
+		void forget(const std::string& filepath);
+
+		// Gives a model its range of the material table, or the fallback material when the table is full
+		void addMaterials(SteelSightModel& model);
+		// Hands the range of a model back to the material table, count is the material count the range was added with
+		void releaseMaterials(const SteelSightModel& model, size_t count);
+
+		// Starts reloads for changed files and swaps in the ones that finished, returns the entries whose key changed with their new key
+		void updateReloads(std::vector<std::pair<uint64_t, uint64_t>>& rekeyed);
+		void applyReload(Entry& entry, const std::shared_ptr<SteelSightModel>& reloaded);
+
+		SteelSightModelLoader& loader;
+		SteelSightMaterialTable& materialTable;
+		VkDeviceSize vramBudget;
+
+		ankerl::unordered_dense::map<uint64_t, Entry> entries{};
+
+		VkDeviceSize residentSize{ 0 };
+		uint64_t evictedModels{ 0 };
+		VkDeviceSize evictedSize{ 0 };
+		uint64_t frame{ 0 };
+
+		bool hotReload{ true };
+		SteelSightFileWatcher watcher{};
+		std::vector<RetiredModel> retired{};
+	};
+}
@@ -0,0 +1,244 @@
+#include "SteelSightObjStream.hpp"
+#include "unordered_dense.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+
+namespace Voortman {
+	namespace {
+		using Vertex = SteelSightModel::Vertex;
+
+		// Placeholder for faces without a material, replaced once every material library is known
+		constexpr uint32_t NO_MATERIAL{ UINT32_MAX };
+
+		struct CornerKey final {
+			int32_t position{ -1 };
+			int32_t normal{ -1 };
+			int32_t texcoord{ -1 };
+
+			_NODISCARD inline bool operator==(const CornerKey& other) const noexcept = default;
+		};
+
+		struct CornerKeyHash final {
+			using is_avalanching = void;
+			_NODISCARD inline uint64_t operator()(const CornerKey& key) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(&key, sizeof(CornerKey)); }
+		};
+
+		inline bool isSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+
+		// Returns the next whitespace separated token and removes it from the line
+		std::string_view nextToken(std::string_view& line) noexcept {
+			size_t begin{ 0 };
+			while (begin < line.size() && isSpace(line[begin])) ++begin;
+			size_t end{ begin };
+			while (end < line.size() && !isSpace(line[end])) ++end;
+
+			const std::string_view token = line.substr(begin, end - begin);
+			line.remove_prefix(end);
+			return token;
+		}
+
+		std::string_view trim(std::string_view text) noexcept {
+			while (!text.empty() && isSpace(text.front())) text.remove_prefix(1);
+			while (!text.empty() && isSpace(text.back())) text.remove_suffix(1);
+			return text;
+		}
+
+		class Parser final {
+		public:
+			Parser(const std::string& filepath, SteelSightObjStream::Result& result) : filepath{ filepath }, result{ result } {}
+
+			void parseLine(std::string_view line) {
+				++lineNumber;
+
+				const std::string_view keyword = nextToken(line);
+				if (keyword == "v") _LIKELY {
+					for (size_t i = 0; i < 3; ++i) positions.push_back(parseFloat(nextToken(line)));
+				}
+				else if (keyword == "f") _LIKELY {
+					parseFace(line);
+				}
+				else if (keyword == "vn") {
+					for (size_t i = 0; i < 3; ++i) normals.push_back(parseFloat(nextToken(line)));
+				}
+				else if (keyword == "vt") {
+					for (size_t i = 0; i < 2; ++i) texcoords.push_back(parseFloat(nextToken(line)));
+				}
+				else if (keyword == "usemtl") {
+					const auto it = materialIds.find(std::string{ trim(line) });
+					material = it != materialIds.end() ? it->second : NO_MATERIAL;
+				}
+				else if (keyword == "mtllib") {
+					loadMaterialLibrary(std::filesystem::path{ filepath }.parent_path() / std::filesystem::path{ std::string{ trim(line) } });
+				}
+			}
+
+		private:
+			_NODISCARD float parseFloat(std::string_view token) const {
+				float value{ 0.f };
+				const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+				if (error != std::errc{} || end != token.data() + token.size()) _UNLIKELY fail("invalid number '" + std::string{ token } + "'");
+				return value;
+			}
+
+			// OBJ indices start at 1, negative indices count back from the last attribute read so far
+			_NODISCARD int32_t resolveIndex(std::string_view token, size_t count) const {
+				if (token.empty()) return -1;
+
+				int64_t index{ 0 };
+				const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), index);
+				if (error != std::errc{} || end != token.data() + token.size()) _UNLIKELY fail("invalid index '" + std::string{ token } + "'");
+
+				const int64_t resolved = index < 0 ? static_cast<int64_t>(count) + index : index - 1;
+				if (index == 0 || resolved < 0 || resolved >= static_cast<int64_t>(count)) _UNLIKELY fail("index out of range '" + std::string{ token } + "'");
+				return static_cast<int32_t>(resolved);
+			}
+
+			void parseFace(std::string_view line) {
+				face.clear();
+
+				for (std::string_view token = nextToken(line); !token.empty(); token = nextToken(line)) {
+					// p, p/t, p//n or p/t/n
+					const size_t firstSlash = token.find('/');
+					const size_t secondSlash = firstSlash == std::string_view::npos ? std::string_view::npos : token.find('/', firstSlash + 1);
+
+					CornerKey key{};
+					key.position = resolveIndex(token.substr(0, firstSlash), positions.size() / 3);
+					if (key.position < 0) _UNLIKELY fail("face corner without a position");
+					if (firstSlash != std::string_view::npos) key.texcoord = resolveIndex(token.substr(firstSlash + 1, secondSlash - firstSlash - 1), texcoords.size() / 2);
+					if (secondSlash != std::string_view::npos) key.normal = resolveIndex(token.substr(secondSlash + 1), normals.size() / 3);
+
+					face.push_back(key);
+				}
+
+				if (face.size() < 3) _UNLIKELY fail("face with less than 3 corners");
+
+				// The corners are welded in the order the triangles use them, which numbers the vertices like the weld after rapidobj
+				if (face.size() == 4) _LIKELY {
+					// Quads are split along the shorter diagonal, the same split rapidobj makes
+					const glm::vec3 diagonal02 = getPosition(face[0]) - getPosition(face[2]);
+					const glm::vec3 diagonal13 = getPosition(face[1]) - getPosition(face[3]);
+					const bool split02 = glm::dot(diagonal02, diagonal02) < glm::dot(diagonal13, diagonal13);
+
+					for (const size_t corner : { size_t{ 0 }, size_t{ 1 }, split02 ? size_t{ 2 } : size_t{ 3 }, split02 ? size_t{ 0 } : size_t{ 1 }, size_t{ 2 }, size_t{ 3 } }) {
+						result.indices.push_back(addCorner(face[corner]));
+					}
+					result.triangleMaterials.insert(result.triangleMaterials.end(), 2, material);
+					return;
+				}
+
+				for (size_t corner = 1; corner + 1 < face.size(); ++corner) {
+					result.indices.push_back(addCorner(face[0]));
+					result.indices.push_back(addCorner(face[corner]));
+					result.indices.push_back(addCorner(face[corner + 1]));
+					result.triangleMaterials.push_back(material);
+				}
+			}
+
+			_NODISCARD inline glm::vec3 getPosition(const CornerKey& key) const noexcept {
+				return { positions[3 * key.position + 0], positions[3 * key.position + 1], positions[3 * key.position + 2] };
+			}
+
+			// The vertex of a corner is built the first time its index tuple is seen
+			uint32_t addCorner(const CornerKey& key) {
+				auto [it, inserted] = corners.try_emplace(key, static_cast<uint32_t>(result.vertices.size()));
+				if (!inserted) _LIKELY return it->second;
+
+				Vertex vertex{};
+				vertex.position = getPosition(key);
+				if (key.normal >= 0) vertex.normal = { normals[3 * key.normal + 0], normals[3 * key.normal + 1], normals[3 * key.normal + 2] };
+				if (key.texcoord >= 0) vertex.uv = { texcoords[2 * key.texcoord + 0], texcoords[2 * key.texcoord + 1] };
+				result.vertices.push_back(vertex);
+				return it->second;
+			}
+
+			// Only the diffuse color is used, like the materials rapidobj reads
+			void loadMaterialLibrary(const std::filesystem::path& path) {
+				std::ifstream file{ path };
+				if (!file) _UNLIKELY fail("failed to open material library " + path.string());
+
+				std::string text{};
+				while (std::getline(file, text)) {
+					std::string_view line{ text };
+					const std::string_view keyword = nextToken(line);
+
+					if (keyword == "newmtl") {
+						materialIds.try_emplace(std::string{ trim(line) }, static_cast<uint32_t>(result.materials.size()));
+						result.materials.emplace_back(0.f, 0.f, 0.f, 1.f);
+					}
+					else if (keyword == "Kd" && !result.materials.empty()) {
+						for (glm::length_t i = 0; i < 3; ++i) result.materials.back()[i] = parseFloat(nextToken(line));
+					}
+				}
+			}
+
+			[[noreturn]] void fail(const std::string& message) const {
+				throw std::runtime_error(filepath + ":" + std::to_string(lineNumber) + ": " + message);
+			}
+
+			const std::string& filepath;
+			SteelSightObjStream::Result& result;
+
+			std::vector<float> positions{};
+			std::vector<float> normals{};
+			std::vector<float> texcoords{};
+
+			ankerl::unordered_dense::map<CornerKey, uint32_t, CornerKeyHash> corners{};
+			ankerl::unordered_dense::map<std::string, uint32_t> materialIds{};
+			std::vector<CornerKey> face{};
+
+			uint32_t material{ NO_MATERIAL };
+			size_t lineNumber{ 0 };
+		};
+	}
+
+	SteelSightObjStream::Result SteelSightObjStream::load(const std::string& filepath, const glm::vec4& defaultMaterial) {
+		std::ifstream file{ filepath, std::ios::binary };
+		if (!file) _UNLIKELY throw std::runtime_error("failed to open file: " + filepath);
+
+		Result result{};
+		{
+			Parser parser{ filepath, result };
+
+			// Small files are read in one chunk of their own size
+			const size_t chunkSize = static_cast<size_t>(std::min<uintmax_t>(CHUNK_SIZE, std::filesystem::file_size(filepath) + 1));
+
+			std::string buffer{};
+			size_t carried{ 0 };
+			while (file) {
+				buffer.resize(carried + chunkSize);
+				file.read(buffer.data() + carried, static_cast<std::streamsize>(chunkSize));
+				const size_t size = carried + static_cast<size_t>(file.gcount());
+
+				// The unfinished last line of a chunk is moved to the front of the buffer and completed by the next chunk
+				std::string_view text{ buffer.data(), size };
+				for (size_t newline = text.find('\n'); newline != std::string_view::npos; newline = text.find('\n')) {
+					parser.parseLine(text.substr(0, newline));
+					text.remove_prefix(newline + 1);
+				}
+
+				if (!file && !text.empty()) parser.parseLine(text);
+
+				carried = text.size();
+				std::memmove(buffer.data(), text.data(), carried);
+			}
+		}
+
+		// Faces without a material use the default material behind the OBJ materials
+		const uint32_t defaultId = static_cast<uint32_t>(result.materials.size());
+		bool usesDefault{ false };
+		for (uint32_t& material : result.triangleMaterials) {
+			if (material != NO_MATERIAL) _LIKELY continue;
+			material = defaultId;
+			usesDefault = true;
+		}
+		if (usesDefault || result.materials.empty()) result.materials.push_back(defaultMaterial);
+
+		return result;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Reads an OBJ file in fixed size chunks and welds every face corner on its index tuple as soon as the face is parsed.
+	/// rapidobj keeps the text of the whole file and an index triple for every face corner until the parse finished, this reader only keeps one chunk of text and the unique corners.
+	/// The attribute arrays stay until the end of the file because a face may reference any vertex before it. Quads are split like rapidobj splits them, larger polygons as a fan. Shapes and groups are not kept.
+	/// </summary>
+	class SteelSightObjStream final {
+	public:
+		// Bytes of text read at a time
+		static constexpr size_t CHUNK_SIZE{ 4 << 20 };
+
+		struct Result final {
+			std::vector<SteelSightModel::Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+
+			// Diffuse color of every material in the .mtl files, followed by the default material when a face has none
+			std::vector<glm::vec4> materials{};
+			std::vector<uint32_t> triangleMaterials{};
+		};
+
+		/// <summary>
+		/// Parses and welds an OBJ file. Corners with equal indices share a vertex, vertices with equal values from different indices are not merged yet.
+		/// </summary>
+		/// <param name="filepath">Path of the OBJ file, material libraries are resolved next to it</param>
+		/// <param name="defaultMaterial">Color of faces without a material</param>
+		/// <returns>The welded triangle list and the materials</returns>
+		_NODISCARD static Result load(const std::string& filepath, const glm::vec4& defaultMaterial);
+	};
+}
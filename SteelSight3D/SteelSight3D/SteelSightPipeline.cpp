@@ -76,6 +76,20 @@ namespace Voortman {
         shaderStages[1].pNext = nullptr;
         shaderStages[1].pSpecializationInfo = nullptr;
 
+        std::vector<VkSpecializationMapEntry> fragmentEntries(configInfo.fragmentConstants.size());
+        for (uint32_t i = 0; i < fragmentEntries.size(); ++i) {
+            fragmentEntries[i] = { i, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t) };
+        }
+
+        VkSpecializationInfo fragmentSpecialization{};
+        if (!fragmentEntries.empty()) {
+            fragmentSpecialization.mapEntryCount = static_cast<uint32_t>(fragmentEntries.size());
+            fragmentSpecialization.pMapEntries = fragmentEntries.data();
+            fragmentSpecialization.dataSize = configInfo.fragmentConstants.size() * sizeof(uint32_t);
+            fragmentSpecialization.pData = configInfo.fragmentConstants.data();
+            shaderStages[1].pSpecializationInfo = &fragmentSpecialization;
+        }
+
         auto& bindingDescriptions = configInfo.bindingDescriptions;
         auto& attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
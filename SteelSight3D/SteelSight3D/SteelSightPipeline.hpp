@@ -25,6 +25,8 @@ namespace Voortman {
         VkPipelineLayout pipelineLayout{ nullptr };
         VkRenderPass renderPass{ nullptr };
         uint32_t subpass{ 0 };
+        // Specialization constants of the fragment shader, entry i is constant_id i
+        std::vector<uint32_t> fragmentConstants{};
 	};
 
     class SteelSightPipeline {
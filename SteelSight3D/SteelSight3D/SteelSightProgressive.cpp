@@ -0,0 +1,238 @@
+#include "SteelSightProgressive.hpp"
+
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cctype>
+#include <limits>
+
+namespace Voortman {
+	namespace {
+		using Vertex = SteelSightModel::Vertex;
+
+		constexpr char PROGRESSIVE_MAGIC[4]{ 'S', 'S', 'P', 'M' };
+
+		struct ProgressiveHeader final {
+			char magic[4]{};
+			uint32_t version{ 0 };
+			uint64_t fullLoadMicroseconds{ 0 };
+			glm::vec3 minimum{ 0.f };
+			uint32_t vertexCount{ 0 };
+			glm::vec3 maximum{ 0.f };
+			uint32_t indexCount{ 0 };
+			uint32_t batchCount{ 0 };
+			uint32_t materialCount{ 0 };
+			uint32_t partCount{ 0 };
+			uint32_t instanceCount{ 0 };
+			uint32_t lodCount{ 0 };
+			uint32_t submeshCount{ 0 };
+			uint32_t meshletCount{ 0 };
+			uint32_t reserved{ 0 };
+		};
+
+		template <typename T>
+		void writeArray(std::ofstream& file, std::span<const T> values) {
+			file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+		}
+
+		template <typename T>
+		void readArray(std::ifstream& file, std::vector<T>& values, size_t count, const std::string& filepath) {
+			values.resize(count);
+			file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+			if (!file) _UNLIKELY throw std::runtime_error("truncated progressive file: " + filepath);
+		}
+	}
+
+	bool SteelSightProgressive::isProgressive(const std::string& filepath) {
+		std::string extension = std::filesystem::path{ filepath }.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".ssprog";
+	}
+
+	std::string SteelSightProgressive::getProgressivePath(const std::string& modelPath) {
+		return modelPath + ".ssprog";
+	}
+
+	bool SteelSightProgressive::isUpToDate(const std::string& modelPath) {
+		std::error_code error{};
+		const auto progressiveTime = std::filesystem::last_write_time(getProgressivePath(modelPath), error);
+		if (error) return false;
+
+		const auto modelTime = std::filesystem::last_write_time(modelPath, error);
+		return !error && progressiveTime >= modelTime;
+	}
+
+	std::vector<SteelSightProgressive::Batch> SteelSightProgressive::write(const std::string& filepath, const SteelSightModel::Builder& builder, std::chrono::microseconds fullLoadTime) {
+		const auto vertices = builder.getVertices();
+		const auto indices = builder.getIndices();
+		const auto parts = builder.getParts();
+		const auto lods = builder.getLods();
+		if (parts.empty() || lods.empty()) _UNLIKELY throw std::runtime_error("a progressive file needs the parts and levels of detail of the model: " + filepath);
+
+		// The tables are copied and their index ranges moved to where the levels end up in the file
+		std::vector<SteelSightModel::Lod> movedLods(lods.begin(), lods.end());
+		std::vector<SteelSightModel::Submesh> movedSubmeshes(builder.getSubmeshes().begin(), builder.getSubmeshes().end());
+		std::vector<SteelSightModel::Meshlet> movedMeshlets(builder.getMeshlets().begin(), builder.getMeshlets().end());
+
+		uint32_t batchCount{ 0 };
+		for (const auto& part : parts) batchCount = std::max(batchCount, part.lodCount);
+
+		std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+		std::vector<Vertex> orderedVertices{};
+		std::vector<uint32_t> orderedIndices{};
+		orderedVertices.reserve(vertices.size());
+		orderedIndices.reserve(indices.size());
+
+		std::vector<Batch> batches{};
+		for (uint32_t batch = 0; batch < batchCount; ++batch) {
+			Batch& written = batches.emplace_back();
+			written.firstVertex = static_cast<uint32_t>(orderedVertices.size());
+			written.firstIndex = static_cast<uint32_t>(orderedIndices.size());
+
+			// Batch 0 holds the coarsest level of every part, every next batch one level finer
+			for (const auto& part : parts) {
+				if (batch >= part.lodCount) continue;
+
+				const uint32_t level = part.firstLod + part.lodCount - 1 - batch;
+				const SteelSightModel::Lod& lod = lods[level];
+				const int64_t shift = static_cast<int64_t>(orderedIndices.size()) - lod.firstIndex;
+
+				movedLods[level].firstIndex = static_cast<uint32_t>(orderedIndices.size());
+				for (uint32_t s = lod.firstSubmesh; s < lod.firstSubmesh + lod.submeshCount; ++s) {
+					auto& submesh = movedSubmeshes[s];
+					submesh.firstIndex = static_cast<uint32_t>(submesh.firstIndex + shift);
+					for (uint32_t m = submesh.firstMeshlet; m < submesh.firstMeshlet + submesh.meshletCount; ++m) {
+						movedMeshlets[m].firstIndex = static_cast<uint32_t>(movedMeshlets[m].firstIndex + shift);
+					}
+				}
+
+				for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.indexCount; ++i) {
+					uint32_t& vertex = remap[indices[i]];
+					if (vertex == UINT32_MAX) {
+						vertex = static_cast<uint32_t>(orderedVertices.size());
+						orderedVertices.push_back(vertices[indices[i]]);
+					}
+					orderedIndices.push_back(vertex);
+				}
+			}
+
+			written.vertexCount = static_cast<uint32_t>(orderedVertices.size()) - written.firstVertex;
+			written.indexCount = static_cast<uint32_t>(orderedIndices.size()) - written.firstIndex;
+		}
+
+		ProgressiveHeader header{};
+		std::memcpy(header.magic, PROGRESSIVE_MAGIC, sizeof(PROGRESSIVE_MAGIC));
+		header.version = VERSION;
+		header.fullLoadMicroseconds = static_cast<uint64_t>(fullLoadTime.count());
+		header.minimum = glm::vec3{ std::numeric_limits<float>::max() };
+		header.maximum = glm::vec3{ std::numeric_limits<float>::lowest() };
+		for (const auto& vertex : orderedVertices) {
+			header.minimum = glm::min(header.minimum, vertex.position);
+			header.maximum = glm::max(header.maximum, vertex.position);
+		}
+		header.vertexCount = static_cast<uint32_t>(orderedVertices.size());
+		header.indexCount = static_cast<uint32_t>(orderedIndices.size());
+		header.batchCount = batchCount;
+		header.materialCount = static_cast<uint32_t>(builder.getMaterials().size());
+		header.partCount = static_cast<uint32_t>(parts.size());
+		header.instanceCount = static_cast<uint32_t>(builder.getInstances().size());
+		header.lodCount = static_cast<uint32_t>(movedLods.size());
+		header.submeshCount = static_cast<uint32_t>(movedSubmeshes.size());
+		header.meshletCount = static_cast<uint32_t>(movedMeshlets.size());
+
+		// Written to a temporary file first so a watching viewer never streams a half written file
+		const std::string temporaryPath = filepath + ".tmp";
+		{
+			std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+			if (!file.is_open()) _UNLIKELY throw std::runtime_error("could not write progressive file: " + filepath);
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			writeArray(file, std::span<const Batch>{ batches });
+			writeArray(file, builder.getMaterials());
+			writeArray(file, parts);
+			writeArray(file, builder.getInstances());
+			writeArray(file, std::span<const SteelSightModel::Lod>{ movedLods });
+			writeArray(file, std::span<const SteelSightModel::Submesh>{ movedSubmeshes });
+			writeArray(file, std::span<const SteelSightModel::Meshlet>{ movedMeshlets });
+
+			// The data of every batch follows the one before, so the file is read front to back
+			for (const auto& batch : batches) {
+				writeArray(file, std::span<const Vertex>{ orderedVertices }.subspan(batch.firstVertex, batch.vertexCount));
+				writeArray(file, std::span<const uint32_t>{ orderedIndices }.subspan(batch.firstIndex, batch.indexCount));
+			}
+
+			if (!file.good()) _UNLIKELY {
+				file.close();
+				std::filesystem::remove(temporaryPath);
+				throw std::runtime_error("could not write progressive file: " + filepath);
+			}
+		}
+
+		std::filesystem::rename(temporaryPath, filepath);
+		return batches;
+	}
+
+	SteelSightProgressive::Reader::Reader(const std::string& filepath, SteelSightModel::Builder& layout) : path{ filepath }, file{ filepath, std::ios::binary } {
+		if (!file.is_open()) _UNLIKELY throw std::runtime_error("could not open progressive file: " + filepath);
+
+		ProgressiveHeader header{};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!file || std::memcmp(header.magic, PROGRESSIVE_MAGIC, sizeof(PROGRESSIVE_MAGIC)) != 0) _UNLIKELY throw std::runtime_error("not a progressive file: " + filepath);
+		if (header.version != VERSION) _UNLIKELY throw std::runtime_error("unsupported progressive file version: " + filepath);
+
+		vertexCount = header.vertexCount;
+		indexCount = header.indexCount;
+		minimum = header.minimum;
+		maximum = header.maximum;
+		fullLoadTime = std::chrono::microseconds{ header.fullLoadMicroseconds };
+
+		layout.cacheFile.reset();
+		layout.vertices.clear();
+		layout.indices.clear();
+
+		readArray(file, batches, header.batchCount, filepath);
+		readArray(file, layout.materials, header.materialCount, filepath);
+		readArray(file, layout.parts, header.partCount, filepath);
+		readArray(file, layout.instances, header.instanceCount, filepath);
+		readArray(file, layout.lods, header.lodCount, filepath);
+		readArray(file, layout.submeshes, header.submeshCount, filepath);
+		readArray(file, layout.meshlets, header.meshletCount, filepath);
+
+		// Every range has to stay inside the buffers that are allocated from the header
+		for (const auto& batch : batches) {
+			if (batch.firstVertex + static_cast<uint64_t>(batch.vertexCount) > vertexCount || batch.firstIndex + static_cast<uint64_t>(batch.indexCount) > indexCount) _UNLIKELY {
+				throw std::runtime_error("invalid batch in progressive file: " + filepath);
+			}
+		}
+	}
+
+	SteelSightProgressive::Batch SteelSightProgressive::Reader::readBatch(std::vector<SteelSightModel::Vertex>& vertices, std::vector<uint32_t>& indices) {
+		if (nextBatch >= batches.size()) _UNLIKELY throw std::out_of_range("every batch of the progressive file was read: " + path);
+
+		const Batch batch = batches[nextBatch++];
+		readArray(file, vertices, batch.vertexCount, path);
+		readArray(file, indices, batch.indexCount, path);
+
+		// A batch may only use the vertices that arrived with it or before it
+		const uint32_t vertexEnd = batch.firstVertex + batch.vertexCount;
+		for (const uint32_t index : indices) {
+			if (index >= vertexEnd) _UNLIKELY throw std::runtime_error("invalid index in progressive file: " + path);
+		}
+		return batch;
+	}
+
+	void SteelSightProgressive::read(const std::string& filepath, SteelSightModel::Builder& builder) {
+		Reader reader{ filepath, builder };
+		builder.vertices.resize(reader.getVertexCount());
+		builder.indices.resize(reader.getIndexCount());
+
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		while (reader.getBatchesRead() < reader.getBatchCount()) {
+			const Batch batch = reader.readBatch(vertices, indices);
+			std::copy(vertices.begin(), vertices.end(), builder.vertices.begin() + batch.firstVertex);
+			std::copy(indices.begin(), indices.end(), builder.indices.begin() + batch.firstIndex);
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Progressive mesh file (.ssprog): the level of detail chain of a model stored coarse to fine, so a model can be drawn as soon as its coarsest level arrived.
+	/// Batch 0 (the base mesh) holds the coarsest level of every part, every next batch the next finer level of every part that has one.
+	/// The levels already share one vertex buffer (see SteelSightMeshSimplifier), the vertices are ordered by the first batch that uses them,
+	/// so every batch only appends vertices and indices and the index ranges that can be drawn grow as the batches arrive.
+	/// The tables (materials, parts, instances, levels of detail, submeshes, meshlets) come first and already point into the final buffers.
+	/// </summary>
+	class SteelSightProgressive final {
+	public:
+		static constexpr uint32_t VERSION{ 1 };
+
+		// The vertex and index range a batch appends
+		struct Batch final {
+			uint32_t firstVertex{ 0 };
+			uint32_t vertexCount{ 0 };
+			uint32_t firstIndex{ 0 };
+			uint32_t indexCount{ 0 };
+		};
+
+		/// <summary>
+		/// Reads a progressive file one batch at a time, from the front to the back of the file.
+		/// </summary>
+		class Reader final {
+		public:
+			/// <summary>
+			/// Opens the file and reads its tables into the layout. The vertices and indices of the layout stay empty.
+			/// </summary>
+			/// <param name="filepath">Path of the progressive file</param>
+			/// <param name="layout">Receives the materials, parts, instances, levels of detail, submeshes and meshlets</param>
+			Reader(const std::string& filepath, SteelSightModel::Builder& layout);
+
+			Reader(const Reader&) = delete;
+			Reader& operator=(const Reader&) = delete;
+
+			/// <summary>
+			/// Reads the next batch.
+			/// </summary>
+			/// <param name="vertices">Receives the vertices the batch appends</param>
+			/// <param name="indices">Receives the indices the batch appends, into the whole vertex buffer</param>
+			/// <returns>Where the vertices and indices go in the buffers of the model</returns>
+			Batch readBatch(std::vector<SteelSightModel::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+			_NODISCARD inline uint32_t getVertexCount() const noexcept { return vertexCount; }
+			_NODISCARD inline uint32_t getIndexCount() const noexcept { return indexCount; }
+			_NODISCARD inline uint32_t getBatchCount() const noexcept { return static_cast<uint32_t>(batches.size()); }
+			_NODISCARD inline uint32_t getBatchesRead() const noexcept { return nextBatch; }
+			_NODISCARD inline const glm::vec3& getMinimum() const noexcept { return minimum; }
+			_NODISCARD inline const glm::vec3& getMaximum() const noexcept { return maximum; }
+
+			// Load time of the source model when the file was written, the full load a progressive load is compared with
+			_NODISCARD inline std::chrono::microseconds getFullLoadTime() const noexcept { return fullLoadTime; }
+
+		private:
+			std::string path{};
+			std::ifstream file{};
+			std::vector<Batch> batches{};
+			uint32_t nextBatch{ 0 };
+			uint32_t vertexCount{ 0 };
+			uint32_t indexCount{ 0 };
+			glm::vec3 minimum{ 0.f };
+			glm::vec3 maximum{ 0.f };
+			std::chrono::microseconds fullLoadTime{};
+		};
+
+		// Decided by the extension (.ssprog)
+		_NODISCARD static bool isProgressive(const std::string& filepath);
+
+		// The progressive file written next to a model, model.obj.ssprog
+		_NODISCARD static std::string getProgressivePath(const std::string& modelPath);
+
+		/// <summary>
+		/// Whether the progressive file of a model exists and was written after the model. The load options are not compared,
+		/// the file holds the mesh of the load that wrote it.
+		/// </summary>
+		/// <param name="modelPath">Path of the source model</param>
+		_NODISCARD static bool isUpToDate(const std::string& modelPath);
+
+		/// <summary>
+		/// Writes the mesh of a builder as a progressive file. Vertices that no level of detail uses are left out.
+		/// </summary>
+		/// <param name="filepath">Path of the file to write</param>
+		/// <param name="builder">A loaded model, with its level of detail chain for a useful base mesh</param>
+		/// <param name="fullLoadTime">Time the builder took to load, stored for the comparison with the progressive load</param>
+		/// <returns>The batches that were written</returns>
+		static std::vector<Batch> write(const std::string& filepath, const SteelSightModel::Builder& builder, std::chrono::microseconds fullLoadTime);
+
+		/// <summary>
+		/// Reads every batch of a progressive file into a builder, for loads that do not draw while streaming.
+		/// </summary>
+		/// <param name="filepath">Path of the progressive file</param>
+		/// <param name="builder">Receives the whole mesh</param>
+		static void read(const std::string& filepath, SteelSightModel::Builder& builder);
+	};
+}
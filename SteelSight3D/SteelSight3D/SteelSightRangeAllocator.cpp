@@ -0,0 +1,78 @@
+#include "SteelSightRangeAllocator.hpp"
+
+#include <iterator>
+
+namespace Voortman {
+	namespace {
+		// Also for alignments that are not a power of two, the strides of the vertex formats
+		inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) noexcept {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	SteelSightRangeAllocator::SteelSightRangeAllocator(VkDeviceSize capacity) : capacity{ capacity } {
+		if (capacity > 0) _LIKELY insertFree(0, capacity);
+	}
+
+	std::optional<VkDeviceSize> SteelSightRangeAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+		if (size == 0) _UNLIKELY return std::nullopt;
+
+		// The smallest free ranges come first, the first one that still holds the range after aligning its start is the best fit
+		for (auto candidate = freeBySize.lower_bound(size); candidate != freeBySize.end(); ++candidate) {
+			const VkDeviceSize freeOffset = candidate->second;
+			const VkDeviceSize freeSize = candidate->first;
+			const VkDeviceSize offset = alignUp(freeOffset, alignment);
+			if (offset + size > freeOffset + freeSize) continue;
+
+			eraseFree(freeByOffset.find(freeOffset));
+
+			// What is left in front of and behind the range stays free
+			if (offset > freeOffset) insertFree(freeOffset, offset - freeOffset);
+			if (offset + size < freeOffset + freeSize) insertFree(offset + size, freeOffset + freeSize - offset - size);
+
+			used += size;
+			return offset;
+		}
+
+		return std::nullopt;
+	}
+
+	void SteelSightRangeAllocator::free(VkDeviceSize offset, VkDeviceSize size) {
+		used -= size;
+		VkDeviceSize end = offset + size;
+
+		// Merge with the free range behind it and with the one in front of it, so the free list never holds two touching ranges
+		auto next = freeByOffset.lower_bound(offset);
+		if (next != freeByOffset.end() && next->first == end) {
+			end += next->second;
+			next = std::next(next);
+			eraseFree(std::prev(next));
+		}
+
+		if (next != freeByOffset.begin()) {
+			const auto previous = std::prev(next);
+			if (previous->first + previous->second == offset) {
+				offset = previous->first;
+				eraseFree(previous);
+			}
+		}
+
+		insertFree(offset, end - offset);
+	}
+
+	void SteelSightRangeAllocator::insertFree(VkDeviceSize offset, VkDeviceSize size) {
+		freeByOffset.emplace(offset, size);
+		freeBySize.emplace(size, offset);
+	}
+
+	void SteelSightRangeAllocator::eraseFree(std::map<VkDeviceSize, VkDeviceSize>::iterator range) {
+		auto [first, last] = freeBySize.equal_range(range->second);
+		for (; first != last; ++first) {
+			if (first->second == range->first) {
+				freeBySize.erase(first);
+				break;
+			}
+		}
+		freeByOffset.erase(range);
+	}
+}
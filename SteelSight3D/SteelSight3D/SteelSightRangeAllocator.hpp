@@ -0,0 +1,46 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <optional>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Hands out ranges of a fixed capacity. The free ranges are kept by offset, so a freed range merges with the free ranges on both sides of it,
+	/// and by size, so an allocation takes the smallest free range it fits in. Used for the pages of the geometry pool and for the material table, not synchronized.
+	/// </summary>
+	class SteelSightRangeAllocator final {
+	public:
+		explicit SteelSightRangeAllocator(VkDeviceSize capacity);
+
+		/// <summary>
+		/// Takes a range from the smallest free range that holds it.
+		/// </summary>
+		/// <param name="size">Size of the range, in the unit of the capacity (bytes for the geometry pool, entries for the material table)</param>
+		/// <param name="alignment">The offset is a multiple of this, any value and not only a power of two so vertices of every stride can be addressed by index</param>
+		/// <returns>Offset of the range, empty when no free range is large enough</returns>
+		_NODISCARD std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+		// Returns a range that allocate handed out
+		void free(VkDeviceSize offset, VkDeviceSize size);
+
+		_NODISCARD inline VkDeviceSize getCapacity() const noexcept { return capacity; }
+		_NODISCARD inline VkDeviceSize getUsed() const noexcept { return used; }
+		_NODISCARD inline bool empty() const noexcept { return used == 0; }
+
+		_NODISCARD inline size_t getFreeRangeCount() const noexcept { return freeByOffset.size(); }
+		_NODISCARD inline VkDeviceSize getLargestFreeRange() const noexcept { return freeBySize.empty() ? 0 : freeBySize.rbegin()->first; }
+
+	private:
+		void insertFree(VkDeviceSize offset, VkDeviceSize size);
+		void eraseFree(std::map<VkDeviceSize, VkDeviceSize>::iterator range);
+
+		VkDeviceSize capacity{ 0 };
+		VkDeviceSize used{ 0 };
+
+		// Offset to size and size to offset of every free range, two free ranges never touch
+		std::map<VkDeviceSize, VkDeviceSize> freeByOffset{};
+		std::multimap<VkDeviceSize, VkDeviceSize> freeBySize{};
+	};
+}
@@ -4,20 +4,59 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 
 #include "SteelSightSimulationObject.hpp"
+#include "SteelSightMeshlets.hpp"
 #include <stdexcept>
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <tuple>
 
 namespace Voortman {
+	// The push constants of simple_shader.frag, shared with the beam system. The models only push the material, their transforms are instance data
 	struct PushConstantData {
 		glm::mat4 modelMatrix{ 1.f };
-		glm::mat4 normalMatrix{ 1.f };
+		// mat3 with std430 column padding, leaves room for the material in the 128 bytes every device guarantees
+		glm::mat3x4 normalMatrix{ 1.f };
+		// Index into the material table, set again before the draws of every submesh
+		uint32_t material{ 0 };
+		uint32_t padding[3]{};
 	};
 
+	static_assert(sizeof(PushConstantData) <= 128, "Push constants are limited to 128 bytes on most devices");
+
+	std::vector<VkVertexInputBindingDescription> SteelSightRenderSystem::InstanceData::getBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+
+		bindingDescriptions[0].binding = 1;
+		bindingDescriptions[0].stride = sizeof(InstanceData);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> SteelSightRenderSystem::InstanceData::getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		// A matrix attribute takes one location per column
+		for (uint32_t column = 0; column < 4; ++column) {
+			attributeDescriptions.push_back({ 3 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(InstanceData, modelMatrix) + column * sizeof(glm::vec4)) });
+		}
+		for (uint32_t column = 0; column < 3; ++column) {
+			attributeDescriptions.push_back({ 7 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec4)) });
+		}
+
+		return attributeDescriptions;
+	}
+
 	SteelSightRenderSystem::SteelSightRenderSystem(SteelSightDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : SSDevice{ device } {
 		createPipelineLayout(globalSetLayout);
 		createPipeline(renderPass);
+
+		instanceBuffers.resize(SteelSightSwapChain::MAX_FRAMES_IN_FLIGHT);
 	}
 
 	SteelSightRenderSystem::~SteelSightRenderSystem() {
@@ -54,15 +93,102 @@ namespace Voortman {
 		SteelSightPipeline::defaultPipelineConfigInfo(pipelineConfig);
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
+
+		// The vertices of the model at binding 0, the instance records at binding 1
+		const auto instanceBindings = InstanceData::getBindingDescriptions();
+		const auto instanceAttributes = InstanceData::getAttributeDescriptions();
+		const auto setVertexInput = [&](std::vector<VkVertexInputBindingDescription> bindings, std::vector<VkVertexInputAttributeDescription> attributes) {
+			bindings.insert(bindings.end(), instanceBindings.begin(), instanceBindings.end());
+			attributes.insert(attributes.end(), instanceAttributes.begin(), instanceAttributes.end());
+			pipelineConfig.bindingDescriptions = std::move(bindings);
+			pipelineConfig.attributeDescriptions = std::move(attributes);
+		};
+
+		setVertexInput(pipelineConfig.bindingDescriptions, pipelineConfig.attributeDescriptions);
 		SSPipeline = std::make_unique<SteelSightPipeline>(
 			SSDevice,
 			"shaders\\simple_shader.vert.spv",
 			"shaders\\simple_shader.frag.spv",
 			pipelineConfig);
+
+		setVertexInput(SteelSightModel::CompactVertex::getBindingDescriptions(), SteelSightModel::CompactVertex::getAttributeDescriptions());
+		compactPipeline = std::make_unique<SteelSightPipeline>(
+			SSDevice,
+			"shaders\\simple_shader_compact.vert.spv",
+			"shaders\\simple_shader.frag.spv",
+			pipelineConfig);
+
+		// FLAT_SHADING (constant_id 0) of simple_shader.frag, the face normal comes from the derivatives of the position
+		pipelineConfig.fragmentConstants = { 1 };
+		setVertexInput(SteelSightModel::FlatVertex::getBindingDescriptions(), SteelSightModel::FlatVertex::getAttributeDescriptions());
+		flatPipeline = std::make_unique<SteelSightPipeline>(
+			SSDevice,
+			"shaders\\simple_shader_flat.vert.spv",
+			"shaders\\simple_shader.frag.spv",
+			pipelineConfig);
+
+		setVertexInput(SteelSightModel::CompactFlatVertex::getBindingDescriptions(), SteelSightModel::CompactFlatVertex::getAttributeDescriptions());
+		compactFlatPipeline = std::make_unique<SteelSightPipeline>(
+			SSDevice,
+			"shaders\\simple_shader_flat.vert.spv",
+			"shaders\\simple_shader.frag.spv",
+			pipelineConfig);
 	}
 
 	void SteelSightRenderSystem::renderSimulationObjects(FrameInfo& frameInfo) {
-		SSPipeline->bind(frameInfo.commandBuffer);
+		const glm::mat4 projectionView = frameInfo.Camera.getProjection() * frameInfo.Camera.getView();
+		const glm::vec3 cameraPosition = frameInfo.Camera.getPosition();
+
+		// The planes in world space, every instance is tested with its bounding sphere before it takes a record
+		const auto frustum = SteelSightMeshlets::makeFrustum(glm::mat4{ 1.f }, projectionView, cameraPosition, false);
+
+		draws.clear();
+		for (auto& kv : frameInfo.simulationObjects) {
+			auto& obj = kv.second;
+
+			SteelSightModel* model = obj.model.get();
+			glm::mat4 modelMatrix = obj.transform.mat4();
+
+			// A model that is still loading is drawn as its bounding box once the loader knows the bounds
+			if (model == nullptr) {
+				glm::vec3 minimum{}, maximum{};
+				if (obj.pendingModel == nullptr || placeholderModel == nullptr || !placeholderModel->isUploaded() || !obj.pendingModel->getBounds(minimum, maximum)) continue;
+
+				model = placeholderModel.get();
+				modelMatrix = glm::scale(glm::translate(modelMatrix, minimum), glm::max(maximum - minimum, glm::vec3{ 1e-6f }));
+			}
+
+			const bool compact = model->getVertexFormat() == SteelSightModel::VertexFormat::Compact;
+			SteelSightPipeline* pipeline = model->isFlatShaded() ? (compact ? compactFlatPipeline.get() : flatPipeline.get()) : (compact ? compactPipeline.get() : SSPipeline.get());
+
+			// Repeated shapes of the model share their geometry, every instance has its own transform and level of detail
+			const bool ownModel = model == obj.model.get();
+			const auto& instances = model->getInstances();
+			if (ownModel) obj.lods.resize(instances.size(), 0);
+
+			const glm::mat3 normalMatrix = obj.transform.normalMatrix();
+			for (size_t i = 0; i < instances.size(); ++i) {
+				const auto& instance = instances[i];
+				const glm::mat4 instanceMatrix = modelMatrix * instance.transform;
+
+				const uint32_t lod = selectLod(*model, instance.part, instanceMatrix, frameInfo.Camera.getProjection(), cameraPosition, ownModel ? obj.lods[i] : 0);
+				if (ownModel) obj.lods[i] = lod;
+
+				const glm::vec4& sphere = model->getParts()[instance.part].boundingSphere;
+				SteelSightModel::Meshlet bounds{};
+				bounds.center = glm::vec3{ instanceMatrix * glm::vec4{ glm::vec3{ sphere }, 1.f } };
+				bounds.radius = sphere.w * std::max({ glm::length(glm::vec3{ instanceMatrix[0] }), glm::length(glm::vec3{ instanceMatrix[1] }), glm::length(glm::vec3{ instanceMatrix[2] }) });
+				bounds.coneCutoff = SteelSightMeshlets::CONE_DISABLED;
+				if (!SteelSightMeshlets::isVisible(bounds, frustum)) continue;
+
+				// Nodes of a glTF file may scale their mesh, the inverse transpose keeps the normals perpendicular to the surface
+				draws.push_back({ pipeline, model, instance.part, lod, instanceMatrix, normalMatrix * glm::inverseTranspose(glm::mat3{ instance.transform }) });
+			}
+		}
+		if (draws.empty()) return;
+
+		// The fence of this frame was waited on in beginFrame, so its instance buffer is no longer read by the GPU
+		writeInstances(frameInfo.frameIndex);
 
 		vkCmdBindDescriptorSets(
 			frameInfo.commandBuffer,
@@ -74,23 +200,100 @@ namespace Voortman {
 			0,
 			nullptr);
 
-		for (auto& kv : frameInfo.simulationObjects) {
-			auto& obj = kv.second;
-			if (obj.model == nullptr) continue;
-			PushConstantData push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
-
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PushConstantData),
-				&push);
-
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+		VkBuffer instanceBuffer = instanceBuffers[frameInfo.frameIndex]->getBuffer();
+		VkDeviceSize instanceOffset{ 0 };
+		vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, &instanceBuffer, &instanceOffset);
+
+		SteelSightPipeline* boundPipeline{ nullptr };
+		// Every model lies in the geometry pool, normally all of them are drawn from the buffers bound for the first one
+		SteelSightGeometryBinding boundGeometry{};
+
+		for (size_t first = 0; first < draws.size();) {
+			const InstanceDraw& draw = draws[first];
+			size_t last = first + 1;
+			while (last < draws.size() && draws[last].model == draw.model && draws[last].part == draw.part && draws[last].lod == draw.lod) ++last;
+
+			if (draw.pipeline != boundPipeline) {
+				draw.pipeline->bind(frameInfo.commandBuffer);
+				boundPipeline = draw.pipeline;
+			}
+
+			SteelSightModel* model = draw.model;
+			model->bind(frameInfo.commandBuffer, boundGeometry);
+
+			// Only the material changes between the submeshes of a model
+			const auto setMaterial = [&](uint32_t material) {
+				const uint32_t tableIndex = model->getMaterialIndex(material);
+				vkCmdPushConstants(
+					frameInfo.commandBuffer,
+					pipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					offsetof(PushConstantData, material),
+					sizeof(uint32_t),
+					&tableIndex);
+			};
+
+			// A part drawn once keeps the meshlet culling of its full detail mesh, repeated parts are one instanced draw per submesh
+			const uint32_t firstInstance = static_cast<uint32_t>(first);
+			const uint32_t instanceCount = static_cast<uint32_t>(last - first);
+			if (instanceCount == 1) model->drawVisible(frameInfo.commandBuffer, draw.part, draw.instanceMatrix, projectionView, cameraPosition, draw.lod, firstInstance, setMaterial);
+			else model->drawInstances(frameInfo.commandBuffer, draw.part, draw.lod, firstInstance, instanceCount, setMaterial);
+
+			first = last;
+		}
+	}
+
+	void SteelSightRenderSystem::writeInstances(int frameIndex) {
+		// The pipeline changes least often, then the model so its pages and materials stay bound
+		std::sort(draws.begin(), draws.end(), [](const InstanceDraw& a, const InstanceDraw& b) {
+			return std::tie(a.pipeline, a.model, a.part, a.lod) < std::tie(b.pipeline, b.model, b.part, b.lod);
+		});
+
+		records.resize(draws.size());
+		for (size_t i = 0; i < draws.size(); ++i) {
+			records[i].modelMatrix = draws[i].instanceMatrix * draws[i].model->getDequantization();
+			records[i].normalMatrix = glm::mat3x4{ draws[i].normalMatrix };
+		}
+
+		auto& buffer = instanceBuffers[frameIndex];
+		if (buffer == nullptr || buffer->getInstanceCount() < records.size()) {
+			// Grow with some margin so a few more objects in view do not recreate the buffer every frame
+			const uint32_t capacity = static_cast<uint32_t>(records.size() + records.size() / 2);
+			buffer = std::make_unique<SteelSightBuffer>(
+				SSDevice,
+				sizeof(InstanceData),
+				capacity,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			buffer->map();
 		}
+
+		buffer->writeToBuffer(records.data(), records.size() * sizeof(InstanceData));
+	}
+
+	uint32_t SteelSightRenderSystem::selectLod(const SteelSightModel& model, uint32_t part, const glm::mat4& modelMatrix, const glm::mat4& projection, const glm::vec3& cameraPosition, uint32_t currentLod) noexcept {
+		const auto& drawnPart = model.getParts()[part];
+		if (drawnPart.lodCount <= 1) return 0;
+
+		const auto lods = std::span<const SteelSightModel::Lod>{ model.getLods() }.subspan(drawnPart.firstLod, drawnPart.lodCount);
+		const glm::vec4& sphere = drawnPart.boundingSphere;
+		const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(sphere), 1.f));
+		const float scale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+		const float radius = sphere.w * scale;
+
+		// Inside the bounding sphere the object can cover the whole screen
+		const float distance = glm::length(center - cameraPosition);
+		if (distance <= radius) return 0;
+
+		// Projected radius in half screen heights, projection[1][1] is 1 / tan(fovy / 2)
+		const float projectedRadius = radius * std::abs(projection[1][1]) / distance;
+
+		uint32_t lod{ 0 };
+		while (lod + 1 < lods.size() && lods[lod + 1].error * projectedRadius <= LOD_SCREEN_ERROR) ++lod;
+
+		// Moving to a finer level happens at once, moving to a coarser level needs some margin
+		while (lod > currentLod && lods[lod].error * projectedRadius > LOD_SCREEN_ERROR * LOD_HYSTERESIS) --lod;
+
+		return lod;
 	}
 }
\ No newline at end of file
@@ -5,14 +5,32 @@
 #include "SteelSightModel.hpp"
 #include "SteelSightPipeline.hpp"
 #include "SteelSightDevice.hpp"
+#include "SteelSightBuffer.hpp"
 #include "SteelSightSimulationObject.hpp"
 #include "SteelSightSwapChain.hpp"
 #include "SteelSightCamera.hpp"
 #include "SteelSightFrameInfo.hpp"
 
 namespace Voortman {
+	/// <summary>
+	/// Draws the models of the simulation objects. Every instance that survives the culling is a record in the instance buffer of the frame,
+	/// the records are sorted by model, part and level of detail so all instances of a part at the same level of detail are one instanced draw per submesh.
+	/// </summary>
 	class SteelSightRenderSystem {
 	public:
+		// Per instance vertex data at binding 1, read at locations 3 to 9 of the simple_shader vertex shaders
+		struct InstanceData final {
+			// Model to world transform of the instance, compact positions are quantized to the mesh bounds so it includes the dequantization
+			glm::mat4 modelMatrix{ 1.f };
+			// mat3 with padded columns, the inverse transpose keeps the normals perpendicular to the surface when a glTF node scales its mesh
+			glm::mat3x4 normalMatrix{ 1.f };
+
+			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		};
+
+		static_assert(sizeof(InstanceData) == 112, "The instance record is read as seven vec4 attributes");
+
 		SteelSightRenderSystem(SteelSightDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
 		~SteelSightRenderSystem();
 
@@ -21,12 +39,61 @@ namespace Voortman {
 
 		void renderSimulationObjects(FrameInfo& frameInfo);
 
+		// Box from 0 to 1 that is scaled to the bounds of models that are still loading, see SteelSightModel::createUnitBox
+		inline void setPlaceholderModel(std::shared_ptr<SteelSightModel> model) noexcept { placeholderModel = std::move(model); }
+
+		// Largest simplification error that may show on screen, in half screen heights (about one pixel at 1080p)
+		static constexpr float LOD_SCREEN_ERROR{ 0.002f };
+
+		// A coarser level is only picked once its error is below this fraction of LOD_SCREEN_ERROR, so objects near a switch distance do not pop back and forth
+		static constexpr float LOD_HYSTERESIS{ 0.75f };
+
+		/// <summary>
+		/// Picks the coarsest level of detail whose error stays below LOD_SCREEN_ERROR at the projected size of the object.
+		/// </summary>
+		/// <param name="model">The model with its LOD chains</param>
+		/// <param name="part">The part of the model, every part has its own LOD chain</param>
+		/// <param name="modelMatrix">Model to world transform of the instance</param>
+		/// <param name="projection">Projection matrix of the camera</param>
+		/// <param name="cameraPosition">Camera position in world space</param>
+		/// <param name="currentLod">Level of detail drawn last frame</param>
+		/// <returns>The level of detail to draw</returns>
+		_NODISCARD static uint32_t selectLod(const SteelSightModel& model, uint32_t part, const glm::mat4& modelMatrix, const glm::mat4& projection, const glm::vec3& cameraPosition, uint32_t currentLod) noexcept;
+
 	private:
+		// An instance in view, the instances with the same pipeline, model, part and level of detail are drawn with one call
+		struct InstanceDraw final {
+			SteelSightPipeline* pipeline{ nullptr };
+			SteelSightModel* model{ nullptr };
+			uint32_t part{ 0 };
+			uint32_t lod{ 0 };
+			// Object transform times instance transform, without the dequantization
+			glm::mat4 instanceMatrix{ 1.f };
+			glm::mat3 normalMatrix{ 1.f };
+		};
+
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
 
+		// Sorts the instances in view and writes their records to the instance buffer of the frame
+		void writeInstances(int frameIndex);
+
 		SteelSightDevice& SSDevice;
 		std::unique_ptr<SteelSightPipeline> SSPipeline;
+		// Same shading for models with SteelSightModel::CompactVertex
+		std::unique_ptr<SteelSightPipeline> compactPipeline;
+		// Flat shaded models without normals in the vertex buffer, see SteelSightModel::LoadOptions::flatShading
+		std::unique_ptr<SteelSightPipeline> flatPipeline;
+		std::unique_ptr<SteelSightPipeline> compactFlatPipeline;
 		VkPipelineLayout pipelineLayout;
+
+		std::shared_ptr<SteelSightModel> placeholderModel{};
+
+		// Reused every frame, cleared before the objects are culled
+		std::vector<InstanceDraw> draws{};
+		std::vector<InstanceData> records{};
+
+		// One buffer per frame in flight, a frame only rewrites its own buffer after its previous submission finished
+		std::vector<std::unique_ptr<SteelSightBuffer>> instanceBuffers{};
 	};
 }
\ No newline at end of file
@@ -43,7 +43,7 @@ namespace Voortman {
 			extent = SSWindow.getExtent();
 			glfwWaitEvents();
 		}
-		vkDeviceWaitIdle(SSDevice.device());
+		SSDevice.waitIdle();
 
 		if (SSSwapChain == nullptr) [[UNLIKELY]] {
 			SSSwapChain = std::make_unique<SteelSightSwapChain>(SSDevice, extent);
@@ -84,6 +84,9 @@ namespace Voortman {
 		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) [[UNLIKELY]] {
 			throw std::runtime_error("failed to begin recording command buffers");
 		}
+
+		// Uploads from the transfer queue that finished are handed to the graphics queue before anything is drawn
+		uploadValue = SSDevice.getTransferQueue().acquireUploads(commandBuffer);
 		return commandBuffer;
 	}
 
@@ -94,7 +97,7 @@ namespace Voortman {
 			throw std::runtime_error("failed to record command buffer!");
 		}
 
-		auto result = SSSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		auto result = SSSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex, uploadValue);
 
 		// Most of the time this will be true
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || SSWindow.wasWindowResized()) [[UNLIKELY]] {
@@ -51,5 +51,7 @@ namespace Voortman {
 		uint32_t currentImageIndex{ 0 };
 		int currentFrameIndex{ 0 };
 		bool isFrameStarted{ false };
+		// Value of the upload semaphore the frame that is recorded waits for
+		uint64_t uploadValue{ 0 };
 	};
 }
\ No newline at end of file
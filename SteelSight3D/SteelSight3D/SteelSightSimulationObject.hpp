@@ -1,8 +1,10 @@
 #pragma once
 #include "SteelSightModel.hpp"
+#include "SteelSightModelLoader.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 namespace Voortman {
 	struct TransformComponent final {
@@ -45,11 +47,17 @@ namespace Voortman {
 		id_t getId() { return id; }
 
 		std::shared_ptr<SteelSightModel> model{};
+
+		// Model that is still loading, the render system draws its bounding box until the app moves the finished model into model
+		std::shared_ptr<SteelSightModelHandle> pendingModel{};
 		glm::vec3 color{};
 		TransformComponent transform{};
 
 		std::unique_ptr<PointLightComponent> pointLight{ nullptr };
 
+		// Level of detail of every instance of the model drawn last frame, the render system only switches away from it with some hysteresis
+		std::vector<uint32_t> lods{};
+
 	private:
 		SteelSightSimulationObject(id_t objId) : id{ objId } {}
 		id_t id;
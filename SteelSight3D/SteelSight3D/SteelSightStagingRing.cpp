@@ -0,0 +1,74 @@
+#include "SteelSightStagingRing.hpp"
+#include "SteelSightUploadBatch.hpp"
+
+#include <stdexcept>
+#include <iostream>
+
+namespace Voortman {
+	SteelSightStagingRing::SteelSightStagingRing(SteelSightDevice& device) : SSDevice{ device } {
+		SSDevice.createBuffer(
+			SEGMENT_SIZE * SEGMENT_COUNT,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffer,
+			allocation);
+
+		// Mapped for the lifetime of the ring, the memory is coherent so writes never need a flush
+		void* memory{ nullptr };
+		if (vmaMapMemory(SSDevice.getAllocator().get(), allocation, &memory) != VK_SUCCESS) _UNLIKELY {
+			SSDevice.destroyBuffer(buffer, allocation);
+			throw std::runtime_error("failed to map staging ring!");
+		}
+		mapped = static_cast<char*>(memory);
+	}
+
+	SteelSightStagingRing::~SteelSightStagingRing() {
+		for (auto& segment : segments) {
+			if (segment.lastUse != nullptr) segment.lastUse->wait();
+			segment.lastUse.reset();
+		}
+
+		vmaUnmapMemory(SSDevice.getAllocator().get(), allocation);
+		SSDevice.destroyBuffer(buffer, allocation);
+	}
+
+	uint32_t SteelSightStagingRing::acquire() {
+		uint32_t index{ 0 };
+		{
+			std::unique_lock lock{ ringMutex };
+			index = nextSegment;
+			nextSegment = (nextSegment + 1) % SEGMENT_COUNT;
+
+			// Another batch still stages into the segment when more threads upload than the ring has segments
+			segmentReleased.wait(lock, [this, index] { return !segments[index].acquired; });
+			segments[index].acquired = true;
+		}
+
+		// Only the batch that acquired the segment touches its last use
+		Segment& segment = segments[index];
+		if (segment.lastUse != nullptr) {
+			if (!segment.lastUse->isFinished()) {
+				stalls.fetch_add(1, std::memory_order_relaxed);
+				segment.lastUse->wait();
+			}
+			segment.lastUse.reset();
+		}
+		return index;
+	}
+
+	void SteelSightStagingRing::release(uint32_t segment, std::shared_ptr<const SteelSightUploadSubmission> submission, VkDeviceSize bytes) {
+		stagedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+		{
+			std::lock_guard lock{ ringMutex };
+			segments[segment].lastUse = std::move(submission);
+			segments[segment].acquired = false;
+		}
+		segmentReleased.notify_all();
+	}
+
+	void SteelSightStagingRing::printStatistics() const {
+		std::cout << "Staging ring: " << getStagedBytes() / 1024 << " KB in " << getSubmissionCount() << " submissions through " << SEGMENT_COUNT << " segments of "
+			<< SEGMENT_SIZE / 1024 << " KB, waited on a segment " << getStallCount() << " times" << std::endl;
+	}
+}
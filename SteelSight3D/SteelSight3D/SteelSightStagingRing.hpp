@@ -0,0 +1,78 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+
+namespace Voortman {
+	class SteelSightDevice;
+	class SteelSightUploadSubmission;
+
+	/// <summary>
+	/// One persistently mapped host visible buffer that every upload to a device local buffer is staged through, instead of a staging buffer
+	/// that is allocated, mapped and freed per upload. The ring is split into segments that upload batches (see SteelSightUploadBatch) take in turn,
+	/// a segment is written again once the submission that copied out of it finished. Safe to use from the loader threads.
+	/// </summary>
+	class SteelSightStagingRing final {
+	public:
+		static constexpr VkDeviceSize SEGMENT_SIZE{ 8ull << 20 };
+		static constexpr uint32_t SEGMENT_COUNT{ 4 };
+
+		// Copies out of a segment start at this alignment, enough for the texel blocks of every format
+		static constexpr VkDeviceSize COPY_ALIGNMENT{ 16 };
+
+		explicit SteelSightStagingRing(SteelSightDevice& device);
+		~SteelSightStagingRing();
+
+		SteelSightStagingRing(const SteelSightStagingRing&) = delete;
+		SteelSightStagingRing& operator=(const SteelSightStagingRing&) = delete;
+
+		// Bytes staged and submissions of upload batches since the start
+		_NODISCARD inline uint64_t getStagedBytes() const noexcept { return stagedBytes.load(std::memory_order_relaxed); }
+		_NODISCARD inline uint32_t getSubmissionCount() const noexcept { return submissions.load(std::memory_order_relaxed); }
+
+		// Times a segment was still being copied when the ring wrapped around to it
+		_NODISCARD inline uint32_t getStallCount() const noexcept { return stalls.load(std::memory_order_relaxed); }
+
+		void printStatistics() const;
+
+	private:
+		friend class SteelSightUploadBatch;
+
+		struct Segment final {
+			// The submission that copied out of the segment last
+			std::shared_ptr<const SteelSightUploadSubmission> lastUse{};
+			// A batch is staging into the segment, guarded by ringMutex
+			bool acquired{ false };
+		};
+
+		// Takes the next segment of the ring once the last copy out of it finished
+		uint32_t acquire();
+		// Hands a segment back, it is written again once the submission finished
+		void release(uint32_t segment, std::shared_ptr<const SteelSightUploadSubmission> submission, VkDeviceSize bytes);
+
+		_NODISCARD inline char* getSegmentMemory(uint32_t segment) const noexcept { return mapped + getSegmentOffset(segment); }
+		_NODISCARD inline VkDeviceSize getSegmentOffset(uint32_t segment) const noexcept { return SEGMENT_SIZE * segment; }
+		_NODISCARD inline VkBuffer getBuffer() const noexcept { return buffer; }
+
+		SteelSightDevice& SSDevice;
+
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VmaAllocation allocation{ VK_NULL_HANDLE };
+		char* mapped{ nullptr };
+
+		std::array<Segment, SEGMENT_COUNT> segments{};
+		uint32_t nextSegment{ 0 };
+		std::mutex ringMutex{};
+		std::condition_variable segmentReleased{};
+
+		std::atomic<uint64_t> stagedBytes{ 0 };
+		std::atomic<uint32_t> submissions{ 0 };
+		std::atomic<uint32_t> stalls{ 0 };
+	};
+}
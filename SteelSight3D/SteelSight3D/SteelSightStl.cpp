@@ -0,0 +1,163 @@
+#include "SteelSightStl.hpp"
+#include "SteelSightMappedFile.hpp"
+#include "SteelSightUtils.hpp"
+#include "unordered_dense.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace Voortman {
+	namespace {
+		using Vertex = SteelSightModel::Vertex;
+		using NormalMode = SteelSightModel::NormalMode;
+
+		constexpr size_t HEADER_SIZE{ 80 + sizeof(uint32_t) };
+
+		// Normal, three corners and a 16 bit attribute, the records are not aligned
+		constexpr size_t RECORD_SIZE{ 50 };
+		constexpr size_t CORNERS_OFFSET{ 12 };
+
+		// -0 and 0 compare equal but hash differently, adding 0 turns -0 into 0
+		_NODISCARD inline glm::vec3 canonical(const glm::vec3& value) noexcept { return value + glm::vec3{ 0.f }; }
+
+		struct PositionHash final {
+			using is_avalanching = void;
+			_NODISCARD inline uint64_t operator()(const glm::vec3& position) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(&position, sizeof(glm::vec3)); }
+		};
+
+		// A welded position with the normal of one of its corners, corners with equal keys share a vertex
+		struct NormalKey final {
+			uint32_t position{ 0 };
+			glm::vec3 normal{};
+
+			_NODISCARD inline bool operator==(const NormalKey& other) const noexcept = default;
+		};
+
+		struct NormalKeyHash final {
+			using is_avalanching = void;
+			_NODISCARD inline uint64_t operator()(const NormalKey& key) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(&key, sizeof(NormalKey)); }
+		};
+
+		_NODISCARD inline glm::vec3 readVec3(const std::byte* data) noexcept {
+			glm::vec3 value{};
+			std::memcpy(&value, data, sizeof(glm::vec3));
+			return value;
+		}
+	}
+
+	bool SteelSightStl::isStl(const std::string& filepath) {
+		std::string extension = std::filesystem::path{ filepath }.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".stl";
+	}
+
+	SteelSightStl::Result SteelSightStl::load(const std::string& filepath, SteelSightModel::NormalMode normalMode, float smoothingAngle, uint32_t workerCount, size_t minParallelCorners) {
+		const SteelSightMappedFile file{ filepath };
+		if (file.size() < HEADER_SIZE) _UNLIKELY throw std::runtime_error("not a binary STL file: " + filepath);
+
+		uint32_t triangleCount{ 0 };
+		std::memcpy(&triangleCount, file.data() + 80, sizeof(uint32_t));
+
+		// Some binary exporters start the header with "solid" as well, an ASCII file is recognized by a size that does not match the triangle count
+		const std::string_view start{ reinterpret_cast<const char*>(file.data()), 5 };
+		if (start == "solid" && file.size() != HEADER_SIZE + triangleCount * RECORD_SIZE) _UNLIKELY throw std::runtime_error("ASCII STL files are not supported: " + filepath);
+		if ((file.size() - HEADER_SIZE) / RECORD_SIZE < triangleCount) _UNLIKELY throw std::runtime_error("truncated binary STL file: " + filepath);
+
+		const size_t cornerCount = 3 * static_cast<size_t>(triangleCount);
+		if (cornerCount > UINT32_MAX) _UNLIKELY throw std::runtime_error("binary STL file has too many triangles: " + filepath);
+
+		Result result{};
+		result.workerCount = cornerCount >= minParallelCorners ? workerCount : 1;
+		const uint32_t workers = result.workerCount;
+		const std::byte* records = file.data() + HEADER_SIZE;
+
+		std::vector<glm::vec3> cornerPositions(cornerCount);
+		parallelFor(triangleCount, workers, [&](size_t begin, size_t end, uint32_t) {
+			for (size_t triangle = begin; triangle < end; ++triangle) {
+				for (size_t corner = 0; corner < 3; ++corner) {
+					cornerPositions[3 * triangle + corner] = canonical(readVec3(records + triangle * RECORD_SIZE + CORNERS_OFFSET + corner * sizeof(glm::vec3)));
+				}
+			}
+		});
+
+		std::vector<uint32_t> cornerPositionIds{};
+		std::vector<uint32_t> positionCorners{};
+		weldParallel(cornerPositions, workers, PositionHash{}, cornerPositionIds, positionCorners);
+		result.positionCount = positionCorners.size();
+
+		// Area weighted normal of every triangle and its direction, triangles without area use the normal of their record
+		std::vector<glm::vec3> faceNormals(triangleCount);
+		std::vector<glm::vec3> faceDirections(triangleCount);
+		parallelFor(triangleCount, workers, [&](size_t begin, size_t end, uint32_t) {
+			for (size_t triangle = begin; triangle < end; ++triangle) {
+				const glm::vec3* corners = &cornerPositions[3 * triangle];
+				faceNormals[triangle] = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+				const float length = glm::length(faceNormals[triangle]);
+				if (length > 0.f) _LIKELY {
+					faceDirections[triangle] = faceNormals[triangle] / length;
+					continue;
+				}
+
+				const glm::vec3 stored = readVec3(records + triangle * RECORD_SIZE);
+				const float storedLength = glm::length(stored);
+				faceDirections[triangle] = storedLength > 0.f ? stored / storedLength : glm::vec3{ 0.f };
+			}
+		});
+
+		std::vector<NormalKey> cornerKeys(cornerCount);
+		if (normalMode == NormalMode::Flat) {
+			parallelFor(cornerCount, workers, [&](size_t begin, size_t end, uint32_t) {
+				for (size_t corner = begin; corner < end; ++corner) cornerKeys[corner] = { cornerPositionIds[corner], canonical(faceDirections[corner / 3]) };
+			});
+		}
+		else {
+			// The triangles around every position, in corner order
+			std::vector<uint32_t> offsets(result.positionCount + 1, 0);
+			for (const uint32_t position : cornerPositionIds) ++offsets[position + 1];
+			for (size_t position = 0; position < result.positionCount; ++position) offsets[position + 1] += offsets[position];
+
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			std::vector<uint32_t> adjacentTriangles(cornerCount);
+			for (size_t corner = 0; corner < cornerCount; ++corner) adjacentTriangles[fill[cornerPositionIds[corner]]++] = static_cast<uint32_t>(corner / 3);
+
+			const float minimumCosine = std::cos(smoothingAngle * glm::pi<float>() / 180.f);
+			parallelFor(cornerCount, workers, [&](size_t begin, size_t end, uint32_t) {
+				for (size_t corner = begin; corner < end; ++corner) {
+					const glm::vec3& direction = faceDirections[corner / 3];
+					const uint32_t position = cornerPositionIds[corner];
+
+					glm::vec3 sum{ 0.f };
+					for (uint32_t i = offsets[position]; i < offsets[position + 1]; ++i) {
+						const uint32_t triangle = adjacentTriangles[i];
+						if (glm::dot(faceDirections[triangle], direction) >= minimumCosine) sum += faceNormals[triangle];
+					}
+
+					const float length = glm::length(sum);
+					cornerKeys[corner] = { position, canonical(length > 0.f ? sum / length : direction) };
+				}
+			});
+		}
+
+		std::vector<uint32_t> vertexCorners{};
+		weldParallel(cornerKeys, workers, NormalKeyHash{}, result.indices, vertexCorners);
+
+		result.vertices.resize(vertexCorners.size());
+		parallelFor(vertexCorners.size(), workers, [&](size_t begin, size_t end, uint32_t) {
+			for (size_t vertex = begin; vertex < end; ++vertex) {
+				const uint32_t corner = vertexCorners[vertex];
+				result.vertices[vertex].position = cornerPositions[corner];
+				result.vertices[vertex].normal = cornerKeys[corner].normal;
+			}
+		});
+
+		return result;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "SteelSightModel.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// Binary STL import. The file is memory mapped and every triangle is read straight from its 50 byte record, binary STL stores every corner separately so the positions are welded on multiple threads.
+	/// STL has no vertex normals, they are generated from the triangles. The normals stored in the records are only used for triangles without area, most exporters write zeros there anyway.
+	/// ASCII STL is not supported.
+	/// </summary>
+	class SteelSightStl final {
+	public:
+		struct Result final {
+			std::vector<SteelSightModel::Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+
+			// Unique positions after the position weld, before the vertices were split by their normals
+			size_t positionCount{ 0 };
+			uint32_t workerCount{ 1 };
+		};
+
+		// Decided by the extension, loadModel reads every other file as OBJ
+		_NODISCARD static bool isStl(const std::string& filepath);
+
+		/// <summary>
+		/// Reads and welds a binary STL file. The result is identical for every worker count.
+		/// </summary>
+		/// <param name="filepath">Path of the .stl file</param>
+		/// <param name="normalMode">Face or smooth normals</param>
+		/// <param name="smoothingAngle">Smooth normals only average triangles whose normals are less than this many degrees apart, so the edges of machined parts stay sharp</param>
+		/// <param name="workerCount">Threads for the weld, already resolved</param>
+		/// <param name="minParallelCorners">Below this amount of corners the weld runs on one thread</param>
+		/// <returns>The indexed triangles</returns>
+		_NODISCARD static Result load(const std::string& filepath, SteelSightModel::NormalMode normalMode, float smoothingAngle, uint32_t workerCount, size_t minParallelCorners);
+	};
+}
@@ -68,8 +68,7 @@ namespace Voortman {
 
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemory[i], nullptr);
+            device.destroyImage(depthImages[i], depthImageAllocations[i]);
         }
 
         for (auto framebuffer : swapChainFrameBuffers) {
@@ -107,7 +106,7 @@ namespace Voortman {
     }
 
     VkResult SteelSightSwapChain::submitCommandBuffers(
-        const VkCommandBuffer* buffers, uint32_t* imageIndex) {
+        const VkCommandBuffer* buffers, uint32_t* imageIndex, uint64_t uploadValue) {
         if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
             vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
         }
@@ -116,12 +115,23 @@ namespace Voortman {
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame], device.getTransferQueue().getSemaphore() };
+        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, SteelSightTransferQueue::ACQUIRE_STAGES };
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
 
+        // The acquires of uploads from the transfer queue wait for the releases, the value of the binary semaphore is ignored
+        const uint64_t waitValues[] = { 0, uploadValue };
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        if (uploadValue > 0) {
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.waitSemaphoreValueCount = 2;
+            timelineInfo.pWaitSemaphoreValues = waitValues;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.waitSemaphoreCount = 2;
+        }
+
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = buffers;
 
@@ -130,6 +140,9 @@ namespace Voortman {
         submitInfo.pSignalSemaphores = signalSemaphores;
 
         vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+
+        // The loader threads submit uploads to the same queue
+        std::lock_guard lock{ device.getQueueMutex() };
         if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to submit draw command buffer!");
@@ -304,7 +317,7 @@ namespace Voortman {
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
         depthImages.resize(imageCount());
-        depthImageMemory.resize(imageCount());
+        depthImageAllocations.resize(imageCount());
         depthImageViews.resize(imageCount());
 
         for (int i = 0; i < depthImages.size(); i++) {
@@ -328,7 +341,7 @@ namespace Voortman {
                 imageInfo,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 depthImages[i],
-                depthImageMemory[i]);
+                depthImageAllocations[i]);
 
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -32,7 +32,8 @@ namespace Voortman {
 
 		VkFormat findDepthFormat();
 		VkResult acquireNextImage(uint32_t* imageIndex);
-		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+		// uploadValue is the value of the upload semaphore of the transfer queue the frame waits for, 0 when the frame acquired no upload
+		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex, uint64_t uploadValue = 0);
 	private:
 		void init();
 		void createSwapChain();
@@ -55,7 +56,7 @@ namespace Voortman {
 		VkRenderPass renderpass;
 
 		std::vector<VkImage> depthImages;
-		std::vector<VkDeviceMemory> depthImageMemory;
+		std::vector<VmaAllocation> depthImageAllocations;
 		std::vector<VkImageView> depthImageViews;
 		std::vector<VkImage> swapChainImages;
 		std::vector<VkImageView> swapChainImageViews;
@@ -0,0 +1,110 @@
+#include "SteelSightTransferQueue.hpp"
+#include "SteelSightUploadBatch.hpp"
+
+#include <stdexcept>
+
+namespace Voortman {
+	SteelSightTransferQueue::SteelSightTransferQueue(VkDevice device, VkQueue graphicsQueue, uint32_t graphicsFamily, std::mutex& graphicsQueueMutex, VkQueue transferQueue, uint32_t transferFamily)
+		: device{ device }, graphicsQueue{ graphicsQueue }, graphicsFamily{ graphicsFamily }, graphicsQueueMutex{ graphicsQueueMutex }, transferQueue{ transferQueue }, transferFamily{ transferFamily } {
+		if (!isDedicated()) return;
+
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) _UNLIKELY {
+			throw std::runtime_error("failed to create upload semaphore!");
+		}
+	}
+
+	SteelSightTransferQueue::~SteelSightTransferQueue() {
+		// The submissions wait for their fences when they are freed
+		handoffs.clear();
+		if (semaphore) _LIKELY vkDestroySemaphore(device, semaphore, nullptr);
+	}
+
+	void SteelSightTransferQueue::submit(const std::shared_ptr<SteelSightUploadSubmission>& submission, std::vector<VkBufferMemoryBarrier>&& bufferAcquires, std::vector<VkImageMemoryBarrier>&& imageAcquires) {
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &submission->commandBuffer;
+
+		if (!isDedicated()) {
+			std::lock_guard lock{ graphicsQueueMutex };
+			submission->submitted = vkQueueSubmit(graphicsQueue, 1, &submitInfo, submission->fence) == VK_SUCCESS;
+		}
+		else {
+			// Complete for the tokens once a frame acquired the upload, not when the copies finished
+			submission->handedOver.store(false, std::memory_order_relaxed);
+
+			std::lock_guard lock{ transferQueueMutex };
+			const uint64_t value = semaphoreValue + 1;
+
+			VkTimelineSemaphoreSubmitInfo timelineInfo{};
+			timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timelineInfo.signalSemaphoreValueCount = 1;
+			timelineInfo.pSignalSemaphoreValues = &value;
+
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &semaphore;
+
+			submission->submitted = vkQueueSubmit(transferQueue, 1, &submitInfo, submission->fence) == VK_SUCCESS;
+			if (submission->submitted) _LIKELY {
+				semaphoreValue = value;
+
+				std::lock_guard handoffLock{ handoffMutex };
+				handoffs.push_back({ submission, value, std::move(bufferAcquires), std::move(imageAcquires) });
+			}
+		}
+
+		if (!submission->submitted) _UNLIKELY throw std::runtime_error("failed to submit upload batch!");
+	}
+
+	uint64_t SteelSightTransferQueue::acquireUploads(VkCommandBuffer commandBuffer) {
+		if (!isDedicated()) _UNLIKELY return 0;
+
+		std::vector<VkBufferMemoryBarrier> bufferAcquires{};
+		std::vector<VkImageMemoryBarrier> imageAcquires{};
+		std::vector<std::shared_ptr<SteelSightUploadSubmission>> acquired{};
+		uint64_t value{ 0 };
+		{
+			std::lock_guard lock{ handoffMutex };
+
+			// Fences of one queue signal in submission order, every upload before the first one that still runs has finished
+			size_t finished{ 0 };
+			while (finished < handoffs.size() && vkGetFenceStatus(device, handoffs[finished].submission->fence) == VK_SUCCESS) ++finished;
+			if (finished == 0) _LIKELY return 0;
+
+			for (size_t h = 0; h < finished; ++h) {
+				auto& handoff = handoffs[h];
+				bufferAcquires.insert(bufferAcquires.end(), handoff.bufferAcquires.begin(), handoff.bufferAcquires.end());
+				imageAcquires.insert(imageAcquires.end(), handoff.imageAcquires.begin(), handoff.imageAcquires.end());
+				acquired.push_back(std::move(handoff.submission));
+				value = handoff.value;
+			}
+			handoffs.erase(handoffs.begin(), handoffs.begin() + static_cast<std::ptrdiff_t>(finished));
+		}
+
+		// Uploads to concurrent buffers hand nothing over, the wait on the semaphore alone makes them visible
+		if (!bufferAcquires.empty() || !imageAcquires.empty()) {
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				ACQUIRE_STAGES,
+				ACQUIRE_STAGES,
+				0,
+				0, nullptr,
+				static_cast<uint32_t>(bufferAcquires.size()), bufferAcquires.data(),
+				static_cast<uint32_t>(imageAcquires.size()), imageAcquires.data());
+		}
+
+		// Everything recorded after the barrier, in this frame or a later one, may read the uploads
+		for (const auto& submission : acquired) submission->handedOver.store(true, std::memory_order_release);
+		return value;
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+
+namespace Voortman {
+	class SteelSightUploadSubmission;
+
+	/// <summary>
+	/// The queue the upload batches are submitted to. When the device has a queue family that can transfer but not draw (the copy engines of
+	/// most discrete GPUs), the uploads run there next to the rendering instead of between the frames on the graphics queue.
+	/// Buffers and images are exclusive to one family, so an upload on the transfer family releases what it wrote to the graphics family and
+	/// the render thread acquires it at the start of a frame (see acquireUploads). The frame waits on the timeline semaphore the upload signaled,
+	/// only uploads whose fence already signaled are acquired so that wait never stalls a frame.
+	/// Without a separate family the uploads go to the graphics queue and need no handoff.
+	/// </summary>
+	class SteelSightTransferQueue final {
+	public:
+		SteelSightTransferQueue(VkDevice device, VkQueue graphicsQueue, uint32_t graphicsFamily, std::mutex& graphicsQueueMutex, VkQueue transferQueue, uint32_t transferFamily);
+		~SteelSightTransferQueue();
+
+		SteelSightTransferQueue(const SteelSightTransferQueue&) = delete;
+		SteelSightTransferQueue& operator=(const SteelSightTransferQueue&) = delete;
+
+		// Whether the uploads run on a queue family of their own and are handed over to the graphics family
+		_NODISCARD inline bool isDedicated() const noexcept { return transferFamily != graphicsFamily; }
+
+		_NODISCARD inline uint32_t getFamily() const noexcept { return transferFamily; }
+		_NODISCARD inline uint32_t getGraphicsFamily() const noexcept { return graphicsFamily; }
+
+		/// <summary>
+		/// Submits a recorded upload. On a dedicated queue the command buffer has to end with the releases of what it wrote.
+		/// </summary>
+		/// <param name="submission">The upload, marked as submitted when this returns</param>
+		/// <param name="bufferAcquires">Acquires the graphics queue executes before it reads the buffers, empty without a dedicated queue</param>
+		/// <param name="imageAcquires">Acquires and layout transitions of the images</param>
+		void submit(const std::shared_ptr<SteelSightUploadSubmission>& submission, std::vector<VkBufferMemoryBarrier>&& bufferAcquires, std::vector<VkImageMemoryBarrier>&& imageAcquires);
+
+		/// <summary>
+		/// Records the acquires of every upload that finished into a frame command buffer, before its render pass. Called by the render thread.
+		/// </summary>
+		/// <param name="commandBuffer">Command buffer of the frame</param>
+		/// <returns>Value of the upload semaphore the frame has to wait for, 0 when nothing was acquired</returns>
+		uint64_t acquireUploads(VkCommandBuffer commandBuffer);
+
+		// Timeline semaphore every upload on the dedicated queue signals, VK_NULL_HANDLE without one
+		_NODISCARD inline VkSemaphore getSemaphore() const noexcept { return semaphore; }
+
+		// Stages of a frame that wait for the upload semaphore, the acquires of the uploads run at these stages
+		static constexpr VkPipelineStageFlags ACQUIRE_STAGES{ VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+
+	private:
+		struct Handoff final {
+			std::shared_ptr<SteelSightUploadSubmission> submission{};
+			uint64_t value{ 0 };
+			std::vector<VkBufferMemoryBarrier> bufferAcquires{};
+			std::vector<VkImageMemoryBarrier> imageAcquires{};
+		};
+
+		VkDevice device{ VK_NULL_HANDLE };
+
+		VkQueue graphicsQueue{ VK_NULL_HANDLE };
+		uint32_t graphicsFamily{ 0 };
+		std::mutex& graphicsQueueMutex;
+
+		VkQueue transferQueue{ VK_NULL_HANDLE };
+		uint32_t transferFamily{ 0 };
+		// The frames never use the transfer queue, so its submissions do not wait for the lock of the graphics queue
+		std::mutex transferQueueMutex{};
+
+		VkSemaphore semaphore{ VK_NULL_HANDLE };
+		// Last value signaled, raised under transferQueueMutex so the values grow in submission order
+		uint64_t semaphoreValue{ 0 };
+
+		// Uploads that were released by the transfer family and not yet acquired, in submission order
+		std::mutex handoffMutex{};
+		std::vector<Handoff> handoffs{};
+	};
+}
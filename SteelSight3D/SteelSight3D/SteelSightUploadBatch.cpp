@@ -0,0 +1,258 @@
+#include "SteelSightUploadBatch.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace Voortman {
+	namespace {
+		inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) noexcept {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	SteelSightUploadSubmission::SteelSightUploadSubmission(VkDevice device, uint32_t queueFamilyIndex) : device{ device } {
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) _UNLIKELY {
+			throw std::runtime_error("failed to create upload command pool!");
+		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS || vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) _UNLIKELY {
+			vkDestroyCommandPool(device, commandPool, nullptr);
+			throw std::runtime_error("failed to create upload submission!");
+		}
+	}
+
+	SteelSightUploadSubmission::~SteelSightUploadSubmission() {
+		// The command buffer may only be freed once the copies finished
+		wait();
+		vkDestroyFence(device, fence, nullptr);
+		vkDestroyCommandPool(device, commandPool, nullptr);
+	}
+
+	bool SteelSightUploadSubmission::isFinished() const noexcept {
+		return !submitted || vkGetFenceStatus(device, fence) == VK_SUCCESS;
+	}
+
+	void SteelSightUploadSubmission::wait() const noexcept {
+		if (submitted) _LIKELY vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	}
+
+	SteelSightUploadBatch::SteelSightUploadBatch(SteelSightDevice& device) : SSDevice{ device }, ring{ device.getStagingRing() }, transferQueue{ device.getTransferQueue() } {}
+
+	SteelSightUploadBatch::~SteelSightUploadBatch() {
+		try {
+			flush();
+		}
+		catch (const std::exception& exception) {
+			std::cerr << "Dropped an upload batch: " << exception.what() << std::endl;
+		}
+	}
+
+	void SteelSightUploadBatch::begin() {
+		recording = std::make_shared<SteelSightUploadSubmission>(SSDevice.device(), transferQueue.getFamily());
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(recording->commandBuffer, &beginInfo);
+	}
+
+	void SteelSightUploadBatch::flush() {
+		if (recording == nullptr) return;
+
+		if (transferQueue.isDedicated()) {
+			// The graphics family acquires the ranges at the start of a frame, the transfer queue cannot name the stages that read them
+			std::vector<VkBufferMemoryBarrier> releases{ bufferTransfers };
+			for (auto& release : releases) {
+				release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				release.dstAccessMask = 0;
+			}
+			if (!releases.empty()) _LIKELY {
+				vkCmdPipelineBarrier(
+					recording->commandBuffer,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+					0, 0, nullptr, static_cast<uint32_t>(releases.size()), releases.data(), 0, nullptr);
+			}
+		}
+		else {
+			// Later submissions read the buffers as vertices, indices or shader resources. The queue submission already makes the writes to the ring visible to the copies
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				recording->commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+		vkEndCommandBuffer(recording->commandBuffer);
+
+		try {
+			transferQueue.submit(recording, std::move(bufferTransfers), std::move(imageTransfers));
+		}
+		catch (const std::exception&) {
+			// A failed submission never reads its segment, it can be written again right away
+			if (segment != UINT32_MAX) ring.release(segment, nullptr, 0);
+			segment = UINT32_MAX;
+			segmentUsed = 0;
+			segmentBytes = 0;
+			bufferTransfers.clear();
+			imageTransfers.clear();
+			recording.reset();
+			throw;
+		}
+		bufferTransfers.clear();
+		imageTransfers.clear();
+
+		if (segment != UINT32_MAX) {
+			ring.release(segment, recording, segmentBytes);
+			segment = UINT32_MAX;
+			segmentUsed = 0;
+			segmentBytes = 0;
+		}
+
+		ring.submissions.fetch_add(1, std::memory_order_relaxed);
+		last = std::move(recording);
+	}
+
+	void SteelSightUploadBatch::addOwnershipTransfer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+		VkBufferMemoryBarrier transfer{};
+		transfer.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		transfer.srcAccessMask = 0;
+		transfer.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		transfer.srcQueueFamilyIndex = transferQueue.getFamily();
+		transfer.dstQueueFamilyIndex = transferQueue.getGraphicsFamily();
+		transfer.buffer = buffer;
+		transfer.offset = offset;
+		transfer.size = size;
+
+		// The chunks of one upload follow each other, they are handed over as one range
+		if (!bufferTransfers.empty()) {
+			auto& previous = bufferTransfers.back();
+			if (previous.buffer == buffer && previous.offset + previous.size == offset) {
+				previous.size += size;
+				return;
+			}
+		}
+		bufferTransfers.push_back(transfer);
+	}
+
+	void SteelSightUploadBatch::copyToBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset, bool concurrent) {
+		const char* source = static_cast<const char*>(data);
+		for (VkDeviceSize offset = 0; offset < size;) {
+			// A full segment is submitted and handed back before the next one is taken, a batch never holds more than one
+			if (segment != UINT32_MAX && segmentUsed == SteelSightStagingRing::SEGMENT_SIZE) flush();
+			if (recording == nullptr) begin();
+			if (segment == UINT32_MAX) segment = ring.acquire();
+
+			const VkDeviceSize chunk = std::min(size - offset, SteelSightStagingRing::SEGMENT_SIZE - segmentUsed);
+			std::memcpy(ring.getSegmentMemory(segment) + segmentUsed, source + offset, chunk);
+
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = ring.getSegmentOffset(segment) + segmentUsed;
+			copyRegion.dstOffset = dstOffset + offset;
+			copyRegion.size = chunk;
+			vkCmdCopyBuffer(recording->commandBuffer, ring.getBuffer(), dstBuffer, 1, &copyRegion);
+			if (transferQueue.isDedicated() && !concurrent) addOwnershipTransfer(dstBuffer, copyRegion.dstOffset, chunk);
+
+			segmentUsed = alignUp(segmentUsed + chunk, SteelSightStagingRing::COPY_ALIGNMENT);
+			segmentBytes += chunk;
+			offset += chunk;
+		}
+	}
+
+	void SteelSightUploadBatch::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
+		if (recording == nullptr) begin();
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = srcOffset;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(recording->commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+		if (transferQueue.isDedicated()) addOwnershipTransfer(dstBuffer, dstOffset, size);
+	}
+
+	void SteelSightUploadBatch::copyToImage(VkImage image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layerCount) {
+		if (size > SteelSightStagingRing::SEGMENT_SIZE) _UNLIKELY throw std::runtime_error("image upload larger than a staging ring segment!");
+
+		// An image is copied out of one segment, the rest of a segment that is too full is left unused
+		if (segment != UINT32_MAX && size > SteelSightStagingRing::SEGMENT_SIZE - segmentUsed) flush();
+		if (recording == nullptr) begin();
+		if (segment == UINT32_MAX) segment = ring.acquire();
+
+		std::memcpy(ring.getSegmentMemory(segment) + segmentUsed, data, size);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = layerCount;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(recording->commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = ring.getSegmentOffset(segment) + segmentUsed;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = layerCount;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { width, height, 1 };
+		vkCmdCopyBufferToImage(recording->commandBuffer, ring.getBuffer(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		if (transferQueue.isDedicated()) {
+			// The release and the acquire both name the layout transition, it happens once between them
+			barrier.srcQueueFamilyIndex = transferQueue.getFamily();
+			barrier.dstQueueFamilyIndex = transferQueue.getGraphicsFamily();
+			barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(recording->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			imageTransfers.push_back(barrier);
+		}
+		else {
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(recording->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		segmentUsed = alignUp(segmentUsed + size, SteelSightStagingRing::COPY_ALIGNMENT);
+		segmentBytes += size;
+	}
+
+	SteelSightUploadToken SteelSightUploadBatch::submit() {
+		flush();
+		return SteelSightUploadToken{ last };
+	}
+}
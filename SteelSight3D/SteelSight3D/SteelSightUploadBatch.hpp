@@ -0,0 +1,131 @@
+#pragma once
+#include "SteelSightDevice.hpp"
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace Voortman {
+	/// <summary>
+	/// One submission of an upload batch: its command buffer and the fence it signals. Kept alive by the tokens of the batch
+	/// and by the staging ring segments it copied from, the fence tells both when the copies finished.
+	/// </summary>
+	class SteelSightUploadSubmission final {
+	public:
+		SteelSightUploadSubmission(VkDevice device, uint32_t queueFamilyIndex);
+		~SteelSightUploadSubmission();
+
+		SteelSightUploadSubmission(const SteelSightUploadSubmission&) = delete;
+		SteelSightUploadSubmission& operator=(const SteelSightUploadSubmission&) = delete;
+
+		// A submission that was never submitted counts as finished, nothing will signal its fence
+		_NODISCARD bool isFinished() const noexcept;
+		void wait() const noexcept;
+
+		// Finished and, after an upload on a dedicated transfer queue, acquired by the graphics queue
+		_NODISCARD inline bool isComplete() const noexcept { return handedOver.load(std::memory_order_acquire) && isFinished(); }
+
+	private:
+		friend class SteelSightUploadBatch;
+		friend class SteelSightTransferQueue;
+
+		VkDevice device{ VK_NULL_HANDLE };
+		// A pool per submission, every loader thread records without locking a shared pool
+		VkCommandPool commandPool{ VK_NULL_HANDLE };
+		VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+		VkFence fence{ VK_NULL_HANDLE };
+		bool submitted{ false };
+		std::atomic<bool> handedOver{ true };
+	};
+
+	/// <summary>
+	/// Completion of an upload batch. Cheap to copy and safe to poll every frame, an empty token is complete.
+	/// </summary>
+	class SteelSightUploadToken final {
+	public:
+		SteelSightUploadToken() = default;
+
+		_NODISCARD inline bool isComplete() const noexcept { return submission == nullptr || submission->isComplete(); }
+
+		// Waits on the fence of the batch, never on the whole queue. After an upload on a dedicated transfer queue the copies
+		// are finished then, the render thread may only draw the data once it acquired it and the token is complete
+		inline void wait() const noexcept { if (submission != nullptr) submission->wait(); }
+
+	private:
+		friend class SteelSightUploadBatch;
+		explicit SteelSightUploadToken(std::shared_ptr<const SteelSightUploadSubmission> last) : submission{ std::move(last) } {}
+
+		std::shared_ptr<const SteelSightUploadSubmission> submission{};
+	};
+
+	/// <summary>
+	/// Records many buffer and image uploads into one command buffer and submits them together with one fence, instead of a submission
+	/// and a wait per copy. The data is staged through the staging ring of the device when it is recorded, so the source may be freed right after.
+	/// A batch holds one ring segment at a time, when it is full the copies recorded so far are submitted and the batch goes on in the next segment.
+	/// Fences of one queue signal in submission order, so the token of the last submission completes after every copy of the batch.
+	/// A batch is used by one thread, different threads record their own batches.
+	/// </summary>
+	class SteelSightUploadBatch final {
+	public:
+		explicit SteelSightUploadBatch(SteelSightDevice& device);
+		// Submits the copies that were recorded but not submitted yet
+		~SteelSightUploadBatch();
+
+		SteelSightUploadBatch(const SteelSightUploadBatch&) = delete;
+		SteelSightUploadBatch& operator=(const SteelSightUploadBatch&) = delete;
+
+		/// <summary>
+		/// Records a copy of data into a buffer. Uploads larger than a ring segment are split over several segments.
+		/// </summary>
+		/// <param name="dstBuffer">Buffer that was created with VK_BUFFER_USAGE_TRANSFER_DST_BIT</param>
+		/// <param name="data">Data to copy, copied into the ring before the call returns</param>
+		/// <param name="size">Bytes to copy</param>
+		/// <param name="dstOffset">Where the data goes in the buffer</param>
+		/// <param name="concurrent">The buffer was created concurrent (see SteelSightDevice::createBuffer), on a dedicated transfer queue the frame waiting on the upload semaphore
+		/// makes the copy visible without handing the range over</param>
+		void copyToBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0, bool concurrent = false);
+
+		// Records a copy between two device buffers, nothing is staged
+		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+
+		/// <summary>
+		/// Records a copy of tightly packed texels into every layer of an image, with the transitions from an undefined layout to
+		/// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL and from there to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. The texels have to fit one ring segment.
+		/// </summary>
+		void copyToImage(VkImage image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layerCount);
+
+		/// <summary>
+		/// Submits the recorded copies to the transfer queue of the device. On the graphics queue they end with a barrier that makes them visible
+		/// to the vertex input and the shaders of later submissions, on a dedicated transfer queue with the releases to the graphics family.
+		/// The batch can record again afterwards.
+		/// </summary>
+		/// <returns>Completes once every copy recorded since the last submit finished</returns>
+		SteelSightUploadToken submit();
+
+		_NODISCARD inline bool empty() const noexcept { return recording == nullptr; }
+
+	private:
+		void begin();
+		void flush();
+
+		// Ownership transfer of a range a copy wrote, recorded as release at the end of the submission and handed to the transfer queue as acquire
+		void addOwnershipTransfer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+		SteelSightDevice& SSDevice;
+		SteelSightStagingRing& ring;
+		SteelSightTransferQueue& transferQueue;
+
+		std::shared_ptr<SteelSightUploadSubmission> recording{};
+		std::shared_ptr<SteelSightUploadSubmission> last{};
+
+		// Written ranges and images of the recording submission, only on a dedicated transfer queue
+		std::vector<VkBufferMemoryBarrier> bufferTransfers{};
+		std::vector<VkImageMemoryBarrier> imageTransfers{};
+
+		// Ring segment the batch stages into, how much of it is used and how much of that is data instead of alignment
+		uint32_t segment{ UINT32_MAX };
+		VkDeviceSize segmentUsed{ 0 };
+		VkDeviceSize segmentBytes{ 0 };
+	};
+}
@@ -0,0 +1,45 @@
+#include "SteelSightUtils.hpp"
+
+#include <fstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include "Windows.h"
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace Voortman {
+#ifdef _WIN32
+	size_t getResidentSize() {
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) _UNLIKELY return 0;
+		return counters.WorkingSetSize;
+	}
+
+	size_t getPeakResidentSize() {
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) _UNLIKELY return 0;
+		return counters.PeakWorkingSetSize;
+	}
+#else
+	size_t getResidentSize() {
+		// The second field of statm is the resident set in pages
+		std::ifstream statm{ "/proc/self/statm" };
+		size_t pages{ 0 };
+		size_t resident{ 0 };
+		if (!(statm >> pages >> resident)) _UNLIKELY return 0;
+		return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	}
+
+	size_t getPeakResidentSize() {
+		rusage usage{};
+		if (getrusage(RUSAGE_SELF, &usage) != 0) _UNLIKELY return 0;
+
+		// Kilobytes on Linux
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+	}
+#endif
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include <functional>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 #include "unordered_dense.h"
 
 namespace Voortman {
@@ -16,4 +20,131 @@ namespace Voortman {
 		seed ^= ankerl::unordered_dense::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(hashCombine(seed, rest), ...);
 	};
-}
\ No newline at end of file
+
+	/// <summary>
+	/// Resolves a requested worker count, 0 means one worker per hardware thread.
+	/// </summary>
+	/// <param name="requested">The requested amount of workers</param>
+	/// <returns>The amount of workers to use, at least 1</returns>
+	_NODISCARD inline uint32_t resolveWorkerCount(uint32_t requested) noexcept {
+		if (requested != 0) return requested;
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Resident memory of the process in bytes, the working set on Windows
+	_NODISCARD size_t getResidentSize();
+
+	// Highest resident memory of the process since it started
+	_NODISCARD size_t getPeakResidentSize();
+
+	/// <summary>
+	/// Splits [0, count) in one contiguous range per worker and runs the ranges on separate threads. The calling thread takes the first range.
+	/// Ranges are handed out in order, so worker w always gets a range that comes before the range of worker w + 1.
+	/// </summary>
+	/// <typeparam name="Function">Callable as function(begin, end, worker)</typeparam>
+	/// <param name="count">Number of elements</param>
+	/// <param name="workerCount">Number of workers, already resolved</param>
+	/// <param name="function">The work per range</param>
+	template <typename Function>
+	inline void parallelFor(size_t count, uint32_t workerCount, Function&& function) {
+		const size_t rangeSize = (count + workerCount - 1) / std::max(1u, workerCount);
+
+		std::vector<std::thread> workers{};
+		workers.reserve(workerCount);
+
+		for (uint32_t worker = 1; worker < workerCount; ++worker) {
+			const size_t begin = std::min(count, worker * rangeSize);
+			const size_t end = std::min(count, begin + rangeSize);
+			workers.emplace_back([&function, begin, end, worker]() { function(begin, end, worker); });
+		}
+
+		function(size_t{ 0 }, std::min(count, rangeSize), 0u);
+
+		for (auto& thread : workers) thread.join();
+	}
+
+	/// <summary>
+	/// Welds corners on multiple threads, every distinct key gets a vertex numbered in the order of the first corner with that key, the same numbering a serial weld produces.
+	/// 1. Every worker hashes a contiguous range of corners and sorts them into one bucket per shard.
+	/// 2. Every shard dedupes its own corners, visiting them in ascending order so the first corner of every key wins.
+	/// 3. The first corners are numbered in corner order with a prefix sum over the ranges.
+	/// </summary>
+	/// <typeparam name="Key">Key of a corner, corners with equal keys share a vertex</typeparam>
+	/// <typeparam name="KeyHash">Callable as hashKey(key), returns a 64 bit hash</typeparam>
+	/// <param name="keys">Key of every corner</param>
+	/// <param name="workerCount">Number of workers, already resolved</param>
+	/// <param name="hashKey">The hash of a key</param>
+	/// <param name="cornerVertices">Receives the vertex of every corner</param>
+	/// <param name="vertexCorners">Receives the first corner of every vertex</param>
+	template <typename Key, typename KeyHash>
+	inline void weldParallel(const std::vector<Key>& keys, uint32_t workerCount, KeyHash&& hashKey, std::vector<uint32_t>& cornerVertices, std::vector<uint32_t>& vertexCorners) {
+		// Set of corner indices that hashes and compares the keys the corners point to
+		struct CornerHash final {
+			using is_avalanching = void;
+			const std::vector<uint64_t>* hashes{ nullptr };
+			_NODISCARD inline uint64_t operator()(uint32_t corner) const noexcept { return (*hashes)[corner]; }
+		};
+
+		struct CornerEqual final {
+			const std::vector<Key>* keys{ nullptr };
+			_NODISCARD inline bool operator()(uint32_t a, uint32_t b) const noexcept { return (*keys)[a] == (*keys)[b]; }
+		};
+
+		const size_t cornerCount = keys.size();
+		const uint32_t shardCount = workerCount;
+		std::vector<uint64_t> hashes(cornerCount);
+		std::vector<std::vector<std::vector<uint32_t>>> buckets(workerCount, std::vector<std::vector<uint32_t>>(shardCount));
+
+		parallelFor(cornerCount, workerCount, [&](size_t begin, size_t end, uint32_t worker) {
+			auto& workerBuckets = buckets[worker];
+			for (auto& bucket : workerBuckets) bucket.reserve((end - begin) / shardCount + 1);
+
+			for (size_t corner = begin; corner < end; ++corner) {
+				hashes[corner] = hashKey(keys[corner]);
+				workerBuckets[hashes[corner] % shardCount].push_back(static_cast<uint32_t>(corner));
+			}
+		});
+
+		// firstCorners[c] is the lowest corner with the same key as corner c
+		std::vector<uint32_t> firstCorners(cornerCount);
+
+		parallelFor(shardCount, workerCount, [&](size_t begin, size_t end, uint32_t) {
+			for (size_t shard = begin; shard < end; ++shard) {
+				ankerl::unordered_dense::set<uint32_t, CornerHash, CornerEqual> unique{ 0, CornerHash{ &hashes }, CornerEqual{ &keys } };
+
+				for (const auto& workerBuckets : buckets) {
+					for (uint32_t corner : workerBuckets[shard]) firstCorners[corner] = *unique.insert(corner).first;
+				}
+			}
+		});
+
+		// Count the new vertices per range and turn the counts into offsets
+		std::vector<uint32_t> rangeOffsets(workerCount + 1, 0);
+		parallelFor(cornerCount, workerCount, [&](size_t begin, size_t end, uint32_t worker) {
+			uint32_t count{ 0 };
+			for (size_t corner = begin; corner < end; ++corner) count += firstCorners[corner] == corner;
+			rangeOffsets[worker + 1] = count;
+		});
+		for (uint32_t worker = 0; worker < workerCount; ++worker) rangeOffsets[worker + 1] += rangeOffsets[worker];
+
+		cornerVertices.resize(cornerCount);
+		vertexCorners.resize(rangeOffsets[workerCount]);
+
+		// A corner that starts a new vertex stores its vertex index, later corners look it up from their first corner
+		parallelFor(cornerCount, workerCount, [&](size_t begin, size_t end, uint32_t worker) {
+			uint32_t next = rangeOffsets[worker];
+			for (size_t corner = begin; corner < end; ++corner) {
+				if (firstCorners[corner] != corner) continue;
+
+				vertexCorners[next] = static_cast<uint32_t>(corner);
+				cornerVertices[corner] = next++;
+			}
+		});
+
+		parallelFor(cornerCount, workerCount, [&](size_t begin, size_t end, uint32_t) {
+			for (size_t corner = begin; corner < end; ++corner) {
+				if (firstCorners[corner] != corner) cornerVertices[corner] = cornerVertices[firstCorners[corner]];
+			}
+		});
+	}
+}
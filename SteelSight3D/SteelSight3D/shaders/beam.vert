@@ -0,0 +1,46 @@
+#version 450
+
+// SteelSightModel::Vertex of a profile template, a beam of length 1 along x
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 uv;
+
+// SteelSightBeamSystem::BeamInstance
+layout(location = 3) in vec4 positionLength; // xyz is the start of the beam, w its length
+layout(location = 4) in vec4 rotation; // quaternion, xyz is the vector part
+
+layout(location = 0) out vec3 fragPosWorld;
+layout(location = 1) out vec3 fragNormalWorld;
+
+struct PointLight {
+  vec4 position; // ignore w
+  vec4 color; // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+layout(push_constant) uniform Push {
+  mat4 modelMatrix; // yard to world
+  mat3x4 normalMatrix; // mat3 with padded columns
+  uint material;
+} push;
+
+vec3 rotate(vec4 q, vec3 v) {
+  return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+  // Stretching along x leaves the normals alone, the side faces have no x component and the caps only have one
+  vec3 positionYard = rotate(rotation, vec3(position.x * positionLength.w, position.yz)) + positionLength.xyz;
+  vec4 positionWorld = push.modelMatrix * vec4(positionYard, 1.0);
+  gl_Position = ubo.projection * ubo.view * positionWorld;
+  fragNormalWorld = normalize(mat3(push.normalMatrix) * rotate(rotation, normal));
+  fragPosWorld = positionWorld.xyz;
+}
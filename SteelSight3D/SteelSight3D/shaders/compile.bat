@@ -1,5 +1,8 @@
 C:\Git\VsmRender\SteelSight3D\SteelSight3D\VULKAN\glslc.exe shaders/simple_shader.vert -o shaders/simple_shader.vert.spv
 C:\Git\VsmRender\SteelSight3D\SteelSight3D\VULKAN\glslc.exe shaders/simple_shader.frag -o shaders/simple_shader.frag.spv
+C:\Git\VsmRender\SteelSight3D\SteelSight3D\VULKAN\glslc.exe shaders/simple_shader_compact.vert -o shaders/simple_shader_compact.vert.spv
+C:\Git\VsmRender\SteelSight3D\SteelSight3D\VULKAN\glslc.exe shaders/beam.vert -o shaders/beam.vert.spv
+C:\Git\VsmRender\SteelSight3D\SteelSight3D\VULKAN\glslc.exe shaders/simple_shader_flat.vert -o shaders/simple_shader_flat.vert.spv
 
 C:\Git\VsmRender\SteelSight3D\SteelSight3D\VULKAN\glslc.exe shaders/point_light.frag -o shaders/point_light.frag.spv
 C:\Git\VsmRender\SteelSight3D\SteelSight3D\VULKAN\glslc.exe shaders/point_light.vert -o shaders/point_light.vert.spv
@@ -1,11 +1,13 @@
 #version 450
 
-layout (location = 0) in vec3 fragColor;
-layout (location = 1) in vec3 fragPosWorld;
-layout (location = 2) in vec3 fragNormalWorld;
+layout (location = 0) in vec3 fragPosWorld;
+layout (location = 1) in vec3 fragNormalWorld;
 
 layout (location = 0) out vec4 outColor;
 
+// Set for models without normals, the face normal is taken from the screen space derivatives of the position
+layout (constant_id = 0) const bool FLAT_SHADING = false;
+
 struct PointLight {
   vec4 position; // ignore w
   vec4 color; // w is intensity
@@ -20,19 +22,33 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
+layout(set = 0, binding = 1) readonly buffer MaterialTable {
+  vec4 colors[]; // diffuse color of every material of every model
+} materials;
+
 layout(push_constant) uniform Push {
   mat4 modelMatrix;
-  mat4 normalMatrix;
+  mat3x4 normalMatrix; // mat3 with padded columns
+  uint material; // material base of the model + material of the submesh
 } push;
 
 void main() {
+  vec3 fragColor = materials.colors[push.material].rgb;
+
   vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
   vec3 specularLight = vec3(0.0);
-  vec3 surfaceNormal = normalize(fragNormalWorld);
-
   vec3 CameraPosWorld = ubo.invView[3].xyz;
   vec3 viewDirection = normalize(CameraPosWorld - fragPosWorld);
 
+  vec3 surfaceNormal;
+  if (FLAT_SHADING) {
+    // Both derivatives lie in the plane of the triangle, turned towards the camera like the front faces of a closed solid
+    surfaceNormal = normalize(cross(dFdx(fragPosWorld), dFdy(fragPosWorld)));
+    if (dot(surfaceNormal, viewDirection) < 0.0) surfaceNormal = -surfaceNormal;
+  } else {
+    surfaceNormal = normalize(fragNormalWorld);
+  }
+
   for (int i = 0; i < ubo.numLights; i++) {
     PointLight light = ubo.pointLights[i];
     vec3 directionToLight = light.position.xyz - fragPosWorld;
@@ -1,13 +1,15 @@
 #version 450
 
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
-layout(location = 3) in vec2 uv;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 uv;
 
-layout(location = 0) out vec3 fragColor;
-layout(location = 1) out vec3 fragPosWorld;
-layout(location = 2) out vec3 fragNormalWorld;
+// SteelSightRenderSystem::InstanceData
+layout(location = 3) in mat4 modelMatrix;
+layout(location = 7) in mat3x4 normalMatrix; // mat3 with padded columns
+
+layout(location = 0) out vec3 fragPosWorld;
+layout(location = 1) out vec3 fragNormalWorld;
 
 struct PointLight {
   vec4 position; // ignore w
@@ -23,15 +25,9 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
-layout(push_constant) uniform Push {
-  mat4 modelMatrix;
-  mat4 normalMatrix;
-} push;
-
 void main() {
-  vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+  vec4 positionWorld = modelMatrix * vec4(position, 1.0);
   gl_Position = ubo.projection * ubo.view * positionWorld;
-  fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+  fragNormalWorld = normalize(mat3(normalMatrix) * normal);
   fragPosWorld = positionWorld.xyz;
-  fragColor = color;
 }
\ No newline at end of file
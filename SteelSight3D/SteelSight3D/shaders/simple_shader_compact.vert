@@ -0,0 +1,42 @@
+#version 450
+
+// SteelSightModel::CompactVertex
+layout(location = 0) in vec4 position; // xyz quantized to the mesh bounds, w is unused
+layout(location = 1) in vec2 normal; // octahedral
+layout(location = 2) in vec2 uv;
+
+// SteelSightRenderSystem::InstanceData
+layout(location = 3) in mat4 modelMatrix; // includes the dequantization of the positions
+layout(location = 7) in mat3x4 normalMatrix; // mat3 with padded columns
+
+layout(location = 0) out vec3 fragPosWorld;
+layout(location = 1) out vec3 fragNormalWorld;
+
+struct PointLight {
+  vec4 position; // ignore w
+  vec4 color; // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+vec3 decodeOctahedral(vec2 encoded) {
+  vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+void main() {
+  vec4 positionWorld = modelMatrix * vec4(position.xyz, 1.0);
+  gl_Position = ubo.projection * ubo.view * positionWorld;
+  fragNormalWorld = normalize(mat3(normalMatrix) * decodeOctahedral(normal));
+  fragPosWorld = positionWorld.xyz;
+}
@@ -0,0 +1,33 @@
+#version 450
+
+// SteelSightModel::FlatVertex or CompactFlatVertex, there is no normal
+layout(location = 0) in vec3 position; // compact positions are quantized to the mesh bounds
+layout(location = 2) in vec2 uv;
+
+// SteelSightRenderSystem::InstanceData
+layout(location = 3) in mat4 modelMatrix; // includes the dequantization of compact positions
+layout(location = 7) in mat3x4 normalMatrix; // mat3 with padded columns
+
+layout(location = 0) out vec3 fragPosWorld;
+layout(location = 1) out vec3 fragNormalWorld;
+
+struct PointLight {
+  vec4 position; // ignore w
+  vec4 color; // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+void main() {
+  vec4 positionWorld = modelMatrix * vec4(position, 1.0);
+  gl_Position = ubo.projection * ubo.view * positionWorld;
+  fragNormalWorld = vec3(0.0); // simple_shader.frag takes the normal of the face from fragPosWorld
+  fragPosWorld = positionWorld.xyz;
+}